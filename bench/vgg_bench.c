@@ -0,0 +1,1593 @@
+/* vgg.h - v0.1 - public domain data structures - nickscha 2025
+
+A C89 standard compliant, single header, nostdlib (no C Standard Library) vector graphics generator (VGG).
+
+This Benchmark measures the serialization hot paths so changes can be compared against each other.
+The suite reports median and p99 ns per item, --csv emits them for --compare between commits.
+
+LICENSE
+
+  Placed in the public domain and also MIT licensed.
+  See end of file for detailed license information.
+
+*/
+#include "../vgg.h"                /* Vector graphics generator */
+#include "../vgg_platform_cache.h" /* Rendered fragment cache   */
+#include "../vgg_platform_parallel.h" /* Parallel serialization */
+#include "../vgg_platform_write.h"    /* File output             */
+#include "../vgg_gzip.h"              /* .svgz output            */
+#include "../vgg_platform_async.h"    /* Asynchronous writer     */
+#include "../vgg_scene.h"             /* Binary scene capture    */
+#include "../vgg_raster.h"            /* Raster previews         */
+
+#include <stdio.h>
+#include <string.h>
+#ifndef _WIN32
+#include <time.h> /* clock_gettime, strict builds get POSIX.1-2001 through vgg.h */
+#endif
+
+#ifdef _WIN32
+#ifndef _WINDOWS_
+__declspec(dllimport) int __stdcall QueryPerformanceCounter(void *lpPerformanceCount);
+__declspec(dllimport) int __stdcall QueryPerformanceFrequency(void *lpFrequency);
+__declspec(dllimport) void __stdcall Sleep(unsigned long dwMilliseconds);
+#endif
+
+/* LARGE_INTEGER without windows.h */
+typedef union bench_large_integer
+{
+  double align;
+  unsigned long part[2];
+
+} bench_large_integer;
+
+/* Monotonic clock in seconds */
+double bench_time(void)
+{
+  static double frequency = 0.0;
+  bench_large_integer counter;
+
+  if (frequency == 0.0)
+  {
+    bench_large_integer f;
+    QueryPerformanceFrequency(&f);
+    frequency = (double)f.part[0] + (double)f.part[1] * 4294967296.0;
+  }
+
+  QueryPerformanceCounter(&counter);
+  return ((double)counter.part[0] + (double)counter.part[1] * 4294967296.0) / frequency;
+}
+#else
+/* Monotonic clock in seconds */
+double bench_time(void)
+{
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return (double)ts.tv_sec + (double)ts.tv_nsec * 1e-9;
+}
+#endif
+
+/* Blocks the calling thread without using the CPU */
+void bench_sleep(double seconds)
+{
+#ifdef _WIN32
+  Sleep((unsigned long)(seconds * 1e3 + 0.5));
+#else
+  struct timespec ts;
+  ts.tv_sec = (time_t)seconds;
+  ts.tv_nsec = (long)((seconds - (double)ts.tv_sec) * 1e9);
+  nanosleep(&ts, 0);
+#endif
+}
+
+/* Sink that throws the bytes away so only serialization is measured */
+int bench_sink_discard(vgg_svg_writer *w)
+{
+  unsigned long *bytes = (unsigned long *)w->sink_user;
+  *bytes += (unsigned long)w->length;
+  w->length = 0;
+  return 1;
+}
+
+#define BENCH_CHUNK_CAPACITY 65536
+#define BENCH_RECTS 1000000
+
+void bench_rects(char *name, void (*element_add)(vgg_svg_writer *w, vgg_header *header))
+{
+  static unsigned char chunk_buffer[BENCH_CHUNK_CAPACITY];
+
+  unsigned long bytes = 0;
+  vgg_svg_writer w = vgg_svg_writer_create_stream(chunk_buffer, BENCH_CHUNK_CAPACITY, bench_sink_discard, &bytes);
+  vgg_rect rect = {0};
+  double start, seconds;
+  unsigned int i;
+
+  rect.header.type = VGG_TYPE_RECT;
+
+  start = bench_time();
+
+  vgg_svg_start(&w, "bench", 1000.0, 1000.0);
+  for (i = 0; i < BENCH_RECTS; ++i)
+  {
+    rect.header.id = i;
+    rect.header.color_fill.r = (int)(i & 0xFF);
+    rect.header.color_fill.g = (int)((i >> 8) & 0xFF);
+    rect.header.color_fill.b = 128;
+    rect.x = (double)(i % 1000);
+    rect.y = (double)(i / 1000);
+    rect.width = 1.25;
+    rect.height = 0.75;
+    element_add(&w, (vgg_header *)&rect);
+  }
+  vgg_svg_end(&w);
+
+  seconds = bench_time() - start;
+
+  printf("%-32s %10.2f ns/element %10.2f MB/s\n",
+         name,
+         seconds * 1e9 / (double)BENCH_RECTS,
+         (double)bytes / seconds / (1024.0 * 1024.0));
+}
+
+/* Deferred formatting: a captured binary scene converted to SVG */
+void bench_scene_convert(void)
+{
+  static unsigned char scene_buffer[BENCH_RECTS * 32 + 64];
+  static unsigned char chunk_buffer[BENCH_CHUNK_CAPACITY];
+
+  unsigned long bytes = 0;
+  vgg_svg_writer scene = vgg_svg_writer_create(scene_buffer, BENCH_RECTS * 32 + 64);
+  vgg_svg_writer w = vgg_svg_writer_create_stream(chunk_buffer, BENCH_CHUNK_CAPACITY, bench_sink_discard, &bytes);
+  vgg_rect rect = {0};
+  double start, seconds;
+  unsigned int i;
+
+  rect.header.type = VGG_TYPE_RECT;
+
+  vgg_scene_start(&scene, "bench", 1000.0, 1000.0);
+  for (i = 0; i < BENCH_RECTS; ++i)
+  {
+    rect.header.id = i;
+    rect.header.color_fill.r = (int)(i & 0xFF);
+    rect.header.color_fill.g = (int)((i >> 8) & 0xFF);
+    rect.header.color_fill.b = 128;
+    rect.x = (double)(i % 1000);
+    rect.y = (double)(i / 1000);
+    rect.width = 1.25;
+    rect.height = 0.75;
+    vgg_scene_add(&scene, (vgg_header *)&rect);
+  }
+
+  start = bench_time();
+  vgg_scene_convert(&w, scene.buffer, (unsigned long)scene.length);
+  seconds = bench_time() - start;
+
+  printf("%-32s %10.2f ns/element %10.2f MB/s %6.2f MB scene\n",
+         "rects scene convert",
+         seconds * 1e9 / (double)BENCH_RECTS,
+         (double)bytes / seconds / (1024.0 * 1024.0),
+         (double)scene.length / (1024.0 * 1024.0));
+}
+
+/* Columnar input as it comes from analytics buffers */
+static double bench_x[BENCH_RECTS];
+static double bench_y[BENCH_RECTS];
+static double bench_width[BENCH_RECTS];
+static double bench_height[BENCH_RECTS];
+static vgg_color bench_colors[BENCH_RECTS];
+
+void bench_rects_batch(char *name)
+{
+  static unsigned char chunk_buffer[BENCH_CHUNK_CAPACITY];
+
+  unsigned long bytes = 0;
+  vgg_svg_writer w = vgg_svg_writer_create_stream(chunk_buffer, BENCH_CHUNK_CAPACITY, bench_sink_discard, &bytes);
+  double start, seconds;
+  unsigned int i;
+
+  for (i = 0; i < BENCH_RECTS; ++i)
+  {
+    bench_x[i] = (double)(i % 1000);
+    bench_y[i] = (double)(i / 1000);
+    bench_width[i] = 1.25;
+    bench_height[i] = 0.75;
+    bench_colors[i].r = (int)(i & 0xFF);
+    bench_colors[i].g = (int)((i >> 8) & 0xFF);
+    bench_colors[i].b = 128;
+  }
+
+  start = bench_time();
+
+  vgg_svg_start(&w, "bench", 1000.0, 1000.0);
+  vgg_svg_rects_add(&w, BENCH_RECTS, 0, bench_x, bench_y, bench_width, bench_height, bench_colors);
+  vgg_svg_end(&w);
+
+  seconds = bench_time() - start;
+
+  printf("%-32s %10.2f ns/element %10.2f MB/s\n",
+         name,
+         seconds * 1e9 / (double)BENCH_RECTS,
+         (double)bytes / seconds / (1024.0 * 1024.0));
+}
+
+static double bench_values[BENCH_RECTS];
+
+/* Heatmap with a 3 stop gradient: colors mapped per cell with vgg_color_map_linear vs. a baked vgg_colormap,
+   optionally with fills interned into CSS classes */
+void bench_heatmap(char *name, int use_colormap, int use_style)
+{
+  static unsigned char chunk_buffer[BENCH_CHUNK_CAPACITY];
+  static vgg_colormap map;
+  static vgg_svg_style style;
+
+  vgg_color stops[3] = {{68, 1, 84}, {33, 145, 140}, {253, 231, 37}};
+  unsigned long bytes = 0;
+  vgg_svg_writer w = vgg_svg_writer_create_stream(chunk_buffer, BENCH_CHUNK_CAPACITY, bench_sink_discard, &bytes);
+  double start, seconds;
+  unsigned int i;
+
+  for (i = 0; i < BENCH_RECTS; ++i)
+  {
+    bench_x[i] = (double)(i % 1000);
+    bench_y[i] = (double)(i / 1000);
+    bench_width[i] = 1.0;
+    bench_height[i] = 1.0;
+    bench_values[i] = (double)((i * 7919) % 1000);
+  }
+
+  start = bench_time();
+
+  vgg_svg_start(&w, "bench", 1000.0, 1000.0);
+  if (use_style)
+  {
+    vgg_svg_style_init(&style);
+    vgg_svg_style_use(&w, &style);
+  }
+  if (use_colormap)
+  {
+    vgg_colormap_init(&map, stops, 0, 3, 0.0, 1000.0);
+    vgg_svg_rects_add_colormap(&w, BENCH_RECTS, 0, bench_x, bench_y, bench_width, bench_height, bench_values, &map);
+  }
+  else
+  {
+    for (i = 0; i < BENCH_RECTS; ++i)
+    {
+      double v = bench_values[i];
+      bench_colors[i] = (v < 500.0) ? vgg_color_map_linear(v, 0.0, 500.0, stops[0], stops[1])
+                                    : vgg_color_map_linear(v, 500.0, 1000.0, stops[1], stops[2]);
+    }
+    vgg_svg_rects_add(&w, BENCH_RECTS, 0, bench_x, bench_y, bench_width, bench_height, bench_colors);
+  }
+  vgg_svg_end(&w);
+
+  seconds = bench_time() - start;
+
+  printf("%-32s %10.2f ns/element %10.2f MB/s %10.2f bytes/element\n",
+         name,
+         seconds * 1e9 / (double)BENCH_RECTS,
+         (double)bytes / seconds / (1024.0 * 1024.0),
+         (double)bytes / (double)BENCH_RECTS);
+}
+
+static char bench_d[BENCH_RECTS * 32];
+
+/* Time series as one path: d built by the caller with sprintf vs. the path builder */
+void bench_path(char *name, int use_builder)
+{
+  static unsigned char chunk_buffer[BENCH_CHUNK_CAPACITY];
+
+  unsigned long bytes = 0;
+  vgg_svg_writer w = vgg_svg_writer_create_stream(chunk_buffer, BENCH_CHUNK_CAPACITY, bench_sink_discard, &bytes);
+  vgg_path path = {0};
+  double start, seconds;
+  unsigned int i;
+
+  for (i = 0; i < BENCH_RECTS; ++i)
+  {
+    bench_x[i] = (double)i * 0.001;
+    bench_y[i] = 500.0 + (double)((i * 7919) % 1000) * 0.137;
+  }
+
+  path.header.type = VGG_TYPE_PATH;
+
+  start = bench_time();
+
+  vgg_svg_start(&w, "bench", 1000.0, 1000.0);
+  if (use_builder)
+  {
+    vgg_svg_path_begin(&w);
+    vgg_svg_path_move_to(&w, bench_x[0], bench_y[0]);
+    vgg_svg_path_lines_to(&w, BENCH_RECTS - 1, bench_x + 1, bench_y + 1);
+    vgg_svg_path_end(&w, &path.header);
+  }
+  else
+  {
+    char *p = bench_d + sprintf(bench_d, "M%.3f %.3f", bench_x[0], bench_y[0]);
+    for (i = 1; i < BENCH_RECTS; ++i)
+    {
+      p += sprintf(p, "L%.3f %.3f", bench_x[i], bench_y[i]);
+    }
+    path.d = bench_d;
+    vgg_svg_element_add(&w, (vgg_header *)&path);
+  }
+  vgg_svg_end(&w);
+
+  seconds = bench_time() - start;
+
+  printf("%-32s %10.2f ns/element %10.2f MB/s\n",
+         name,
+         seconds * 1e9 / (double)BENCH_RECTS,
+         (double)bytes / seconds / (1024.0 * 1024.0));
+}
+
+/* 1M point time series on an 800 pixel wide chart, simplified before the path is written.
+   mode 0: min/max per column, 1: rdp, 2: min/max then rdp */
+void bench_simplify(char *name, int mode)
+{
+  static unsigned char chunk_buffer[BENCH_CHUNK_CAPACITY];
+  static unsigned int stack[2 * BENCH_RECTS];
+  static unsigned char keep[BENCH_RECTS];
+
+  unsigned long bytes = 0;
+  vgg_svg_writer w = vgg_svg_writer_create_stream(chunk_buffer, BENCH_CHUNK_CAPACITY, bench_sink_discard, &bytes);
+  vgg_header header = {0};
+  double start, seconds;
+  unsigned int i, n;
+
+  for (i = 0; i < BENCH_RECTS; ++i)
+  {
+    bench_x[i] = (double)i * (800.0 / (double)BENCH_RECTS);
+    bench_y[i] = 150.0 + (double)((i / 1000) % 100) + (double)((i * 7919) % 13) * 0.1;
+  }
+
+  header.type = VGG_TYPE_PATH;
+
+  start = bench_time();
+
+  vgg_svg_start(&w, "bench", 800.0, 300.0);
+  n = BENCH_RECTS;
+  if (mode != 1)
+  {
+    n = vgg_simplify_minmax(bench_x, bench_y, n, 0.0, 1.0, bench_x, bench_y);
+  }
+  if (mode != 0)
+  {
+    n = vgg_simplify_rdp(bench_x, bench_y, n, 1.0, stack, keep, bench_x, bench_y);
+  }
+  vgg_svg_polyline_add(&w, &header, n, bench_x, bench_y);
+  vgg_svg_end(&w);
+
+  seconds = bench_time() - start;
+
+  printf("%-32s %10.2f ns/element %10.2f MB/s %10u -> %u vertices\n",
+         name,
+         seconds * 1e9 / (double)BENCH_RECTS,
+         (double)bytes / seconds / (1024.0 * 1024.0),
+         BENCH_RECTS, n);
+}
+
+/* Zoomed 800x600 view into 1M rects on a 10000x10000 canvas: culling while scanning all rects vs. a grid query */
+void bench_cull(void)
+{
+  static unsigned char chunk_buffer[BENCH_CHUNK_CAPACITY];
+  static vgg_bounds bounds[BENCH_RECTS];
+  static unsigned int cells[256 * 256 + 1];
+  static unsigned int items[BENCH_RECTS];
+  static unsigned int found[BENCH_RECTS];
+
+  unsigned long bytes = 0;
+  vgg_svg_writer w = vgg_svg_writer_create_stream(chunk_buffer, BENCH_CHUNK_CAPACITY, bench_sink_discard, &bytes);
+  vgg_bounds area = {0.0, 0.0, 10000.0, 10000.0};
+  vgg_bounds view = {4000.0, 3000.0, 4800.0, 3600.0};
+  vgg_grid grid;
+  double start, seconds;
+  unsigned int i, n;
+
+  for (i = 0; i < BENCH_RECTS; ++i)
+  {
+    bench_x[i] = (double)(i % 1000) * 10.0;
+    bench_y[i] = (double)(i / 1000) * 10.0;
+    bench_width[i] = 8.0;
+    bench_height[i] = 8.0;
+    bounds[i].x0 = bench_x[i];
+    bounds[i].y0 = bench_y[i];
+    bounds[i].x1 = bench_x[i] + bench_width[i];
+    bounds[i].y1 = bench_y[i] + bench_height[i];
+  }
+
+  /* Scan: every rect is tested */
+  start = bench_time();
+  vgg_svg_start(&w, "bench", 800.0, 600.0);
+  w.cull_viewport = view;
+  vgg_svg_cull(&w, 1);
+  vgg_svg_rects_add(&w, BENCH_RECTS, 0, bench_x, bench_y, bench_width, bench_height, 0);
+  vgg_svg_end(&w);
+  seconds = bench_time() - start;
+  printf("%-32s %10.2f ms/view %10u written\n", "cull scan", seconds * 1e3, BENCH_RECTS - w.culled);
+
+  start = bench_time();
+  vgg_grid_build(&grid, bounds, BENCH_RECTS, area, 256, 256, cells, items);
+  seconds = bench_time() - start;
+  printf("%-32s %10.2f ms\n", "cull grid build", seconds * 1e3);
+
+  /* Query: only candidate cells are touched */
+  w = vgg_svg_writer_create_stream(chunk_buffer, BENCH_CHUNK_CAPACITY, bench_sink_discard, &bytes);
+  start = bench_time();
+  vgg_svg_start(&w, "bench", 800.0, 600.0);
+  n = vgg_grid_query(&grid, bounds, view, found);
+  for (i = 0; i < n; ++i)
+  {
+    unsigned int k = found[i];
+    vgg_svg_rects_add(&w, 1, k, &bench_x[k], &bench_y[k], &bench_width[k], &bench_height[k], 0);
+  }
+  vgg_svg_end(&w);
+  seconds = bench_time() - start;
+  printf("%-32s %10.2f ms/view %10u written\n", "cull grid query", seconds * 1e3, n);
+}
+
+#define BENCH_DOCUMENT_RECTS 100000
+#define BENCH_ARENA_CAPACITY (32UL * 1024UL * 1024UL)
+
+/* Retained document: adding elements into the arena, then writing it again and again */
+void bench_document(void)
+{
+  static unsigned char chunk_buffer[BENCH_CHUNK_CAPACITY];
+  static unsigned char arena_memory[BENCH_ARENA_CAPACITY];
+
+  unsigned long bytes = 0;
+  vgg_svg_writer w = vgg_svg_writer_create_stream(chunk_buffer, BENCH_CHUNK_CAPACITY, bench_sink_discard, &bytes);
+  vgg_arena arena = vgg_arena_create(arena_memory, BENCH_ARENA_CAPACITY);
+  vgg_document doc;
+  vgg_rect rect = {0};
+  double start = 0.0, seconds = 0.0;
+  unsigned int i, pass;
+
+  rect.header.type = VGG_TYPE_RECT;
+  rect.width = 1.25;
+  rect.height = 0.75;
+
+  /* First pass only touches the arena pages, the second one is measured */
+  for (pass = 0; pass < 2; ++pass)
+  {
+    vgg_arena_reset(&arena);
+
+    start = bench_time();
+    vgg_document_init(&doc, &arena);
+    for (i = 0; i < BENCH_DOCUMENT_RECTS; ++i)
+    {
+      rect.header.id = i;
+      rect.x = (double)(i % 1000);
+      rect.y = (double)(i / 1000);
+      vgg_document_add(&doc, (vgg_header *)&rect);
+    }
+    seconds = bench_time() - start;
+  }
+  printf("%-32s %10.2f ns/element %10lu arena bytes\n", "document add", seconds * 1e9 / (double)BENCH_DOCUMENT_RECTS, arena.used);
+
+  start = bench_time();
+  vgg_svg_start(&w, "bench", 1000.0, 1000.0);
+  vgg_document_write(&doc, &w);
+  vgg_svg_end(&w);
+  seconds = bench_time() - start;
+  printf("%-32s %10.2f ns/element %10.2f MB/s\n", "document write", seconds * 1e9 / (double)BENCH_DOCUMENT_RECTS, (double)bytes / seconds / (1024.0 * 1024.0));
+}
+
+#define BENCH_DASHBOARD_RECTS 200000
+#define BENCH_DASHBOARD_FRAMES 10
+#define BENCH_CACHE_CAPACITY (32 * 1024 * 1024)
+
+/* Live dashboard: 200k cells, 1% of them change per frame. Full re-serialization vs. vgg_document_render.
+   mode 0: full, 1: incremental with fill changes (same length), 2: incremental with geometry changes (splice) */
+void bench_dashboard(char *name, int mode)
+{
+  static unsigned char arena_memory[BENCH_ARENA_CAPACITY * 2];
+  static unsigned char cache_buffer[BENCH_CACHE_CAPACITY];
+
+  vgg_arena arena = vgg_arena_create(arena_memory, BENCH_ARENA_CAPACITY * 2);
+  vgg_svg_writer cache = vgg_svg_writer_create(cache_buffer, BENCH_CACHE_CAPACITY);
+  vgg_document doc;
+  vgg_element element;
+  unsigned long seed = 1;
+  double start, seconds;
+  unsigned int i, frame;
+
+  vgg_document_init(&doc, &arena);
+  for (i = 0; i < BENCH_DASHBOARD_RECTS; ++i)
+  {
+    vgg_rect rect = {0};
+    rect.header.type = VGG_TYPE_RECT;
+    rect.header.id = i;
+    rect.x = (double)(i % 500);
+    rect.y = (double)(i / 500);
+    rect.width = 1.0;
+    rect.height = 1.0;
+    vgg_document_add(&doc, (vgg_header *)&rect);
+  }
+  vgg_document_render(&doc, &cache);
+
+  start = bench_time();
+  for (frame = 0; frame < BENCH_DASHBOARD_FRAMES; ++frame)
+  {
+    for (i = 0; i < BENCH_DASHBOARD_RECTS / 100; ++i)
+    {
+      unsigned int index;
+      seed = (seed * 1103515245UL + 12345UL) & 0x7FFFFFFFUL;
+      index = (unsigned int)(seed % BENCH_DASHBOARD_RECTS);
+
+      vgg_document_element(&doc, index, &element);
+      element.header.color_fill.r = (int)(seed & 0xFF);
+      if (mode == 2)
+      {
+        element.rect.width = (double)(seed % 1000) * 0.001;
+      }
+      vgg_document_set(&doc, index, &element.header);
+    }
+
+    if (mode == 0)
+    {
+      cache.length = 0;
+      vgg_document_write(&doc, &cache);
+    }
+    else
+    {
+      vgg_document_render(&doc, &cache);
+    }
+  }
+  seconds = bench_time() - start;
+
+  printf("%-32s %10.2f ms/frame %10d bytes\n", name, seconds * 1e3 / (double)BENCH_DASHBOARD_FRAMES, cache.length);
+}
+
+#define BENCH_CACHE_RECTS 100000
+#define BENCH_CACHE_ROUNDS 10
+
+/* Rendering a document against reading it back from the on-disk fragment cache */
+void bench_platform_cache(void)
+{
+  static unsigned char arena_memory[BENCH_ARENA_CAPACITY];
+  static unsigned char scratch_buffer[BENCH_CACHE_CAPACITY];
+  static unsigned char output_buffer[BENCH_CACHE_CAPACITY];
+
+  vgg_arena arena = vgg_arena_create(arena_memory, BENCH_ARENA_CAPACITY);
+  vgg_svg_writer scratch = vgg_svg_writer_create(scratch_buffer, BENCH_CACHE_CAPACITY);
+  vgg_svg_writer output = vgg_svg_writer_create(output_buffer, BENCH_CACHE_CAPACITY);
+  vgg_platform_cache cache;
+  vgg_document doc;
+  vgg_hash hash;
+  char key[VGG_PLATFORM_CACHE_KEY_SIZE];
+  double start, render, hashing, hit;
+  unsigned int i;
+
+  vgg_document_init(&doc, &arena);
+  for (i = 0; i < BENCH_CACHE_RECTS; ++i)
+  {
+    vgg_rect rect = {0};
+    rect.header.type = VGG_TYPE_RECT;
+    rect.header.id = i;
+    rect.x = (double)(i % 500) * 1.5;
+    rect.y = (double)(i / 500) * 1.5;
+    rect.width = 1.25;
+    rect.height = 1.25;
+    vgg_document_add(&doc, (vgg_header *)&rect);
+  }
+
+  vgg_platform_cache_open(&cache, "bench_cache", BENCH_CACHE_CAPACITY * 4UL);
+  vgg_platform_cache_clear(&cache);
+  vgg_platform_cache_document(&cache, &doc, &output, &scratch);
+
+  start = bench_time();
+  for (i = 0; i < BENCH_CACHE_ROUNDS; ++i)
+  {
+    output.length = 0;
+    vgg_document_write(&doc, &output);
+  }
+  render = (bench_time() - start) / (double)BENCH_CACHE_ROUNDS;
+
+  start = bench_time();
+  for (i = 0; i < BENCH_CACHE_ROUNDS; ++i)
+  {
+    vgg_hash_init(&hash);
+    vgg_hash_document(&hash, &doc, &output);
+    vgg_hash_hex(&hash, key);
+  }
+  hashing = (bench_time() - start) / (double)BENCH_CACHE_ROUNDS;
+
+  start = bench_time();
+  for (i = 0; i < BENCH_CACHE_ROUNDS; ++i)
+  {
+    output.length = 0;
+    vgg_platform_cache_document(&cache, &doc, &output, &scratch);
+  }
+  hit = (bench_time() - start) / (double)BENCH_CACHE_ROUNDS;
+
+  printf("%-32s %10.2f ms/frame %10d bytes\n", "cache miss (document_write)", render * 1e3, output.length);
+  printf("%-32s %10.2f ms/frame\n", "cache key (hash_document)", hashing * 1e3);
+  printf("%-32s %10.2f ms/frame %10lu hits\n", "cache hit (hash + mmap + copy)", hit * 1e3, cache.hits);
+
+  vgg_platform_cache_clear(&cache);
+}
+
+#define BENCH_PARALLEL_RECTS 1000000
+#define BENCH_PARALLEL_MEMORY (64UL * 1024UL * 1024UL)
+
+/* Scaling of sharded serialization from 1 to VGG_PLATFORM_PARALLEL_THREADS_MAX threads */
+void bench_parallel(void)
+{
+  static vgg_rect rects[BENCH_PARALLEL_RECTS];
+  static vgg_header *headers[BENCH_PARALLEL_RECTS];
+  static unsigned char shard_memory[BENCH_PARALLEL_MEMORY];
+  static unsigned char chunk_buffer[BENCH_CHUNK_CAPACITY];
+
+  unsigned long bytes = 0;
+  vgg_svg_writer w = vgg_svg_writer_create_stream(chunk_buffer, BENCH_CHUNK_CAPACITY, bench_sink_discard, &bytes);
+  double start, seconds, serial = 0.0;
+  unsigned int i, threads;
+  char name[32];
+
+  for (i = 0; i < BENCH_PARALLEL_RECTS; ++i)
+  {
+    rects[i].header.type = VGG_TYPE_RECT;
+    rects[i].header.id = i;
+    rects[i].header.color_fill.g = (int)(i & 0xFF);
+    rects[i].x = (double)(i % 1000) * 1.25;
+    rects[i].y = (double)(i / 1000) * 1.25;
+    rects[i].width = 1.125;
+    rects[i].height = 1.125;
+    headers[i] = &rects[i].header;
+  }
+
+  /* Warm pass, touches all shard memory */
+  vgg_platform_parallel_elements_add(&w, headers, BENCH_PARALLEL_RECTS, 2, shard_memory, BENCH_PARALLEL_MEMORY);
+  vgg_svg_writer_flush(&w);
+
+  for (threads = 1; threads <= VGG_PLATFORM_PARALLEL_THREADS_MAX; threads *= 2)
+  {
+    bytes = 0;
+    start = bench_time();
+    vgg_platform_parallel_elements_add(&w, headers, BENCH_PARALLEL_RECTS, threads, shard_memory, BENCH_PARALLEL_MEMORY);
+    vgg_svg_writer_flush(&w);
+    seconds = bench_time() - start;
+    serial = (threads == 1) ? seconds : serial;
+
+    sprintf(name, "parallel %u threads", threads);
+    printf("%-32s %10.2f ms %10.2f MB/s %6.2fx\n", name, seconds * 1e3, (double)bytes / seconds / (1024.0 * 1024.0), serial / seconds);
+  }
+}
+
+#define BENCH_GATHER_FRAGMENTS 2000
+#define BENCH_GATHER_FRAGMENT_SIZE (64 * 1024)
+
+/* Assembling cached fragments between writer bytes: copied through a stream writer against gathered spans */
+void bench_gather(void)
+{
+  static unsigned char fragment[BENCH_GATHER_FRAGMENT_SIZE];
+  static unsigned char chunk_buffer[BENCH_CHUNK_CAPACITY];
+  static unsigned char writer_buffer[BENCH_GATHER_FRAGMENTS * 128];
+  static vgg_platform_span spans[2 * BENCH_GATHER_FRAGMENTS + 1];
+
+  vgg_svg_writer w;
+  vgg_platform_gather gather;
+  vgg_platform_stream file;
+  vgg_circle circle = {0};
+  double start, copied, gathered;
+  unsigned int i;
+
+  for (i = 0; i < BENCH_GATHER_FRAGMENT_SIZE; ++i)
+  {
+    fragment[i] = (unsigned char)('a' + i % 26);
+  }
+  circle.header.type = VGG_TYPE_CIRCLE;
+  circle.r = 2.5;
+
+  vgg_platform_stream_open(&file, "bench_gather.svg");
+  start = bench_time();
+  w = vgg_svg_writer_create_stream(chunk_buffer, BENCH_CHUNK_CAPACITY, vgg_platform_stream_sink, &file);
+  for (i = 0; i < BENCH_GATHER_FRAGMENTS; ++i)
+  {
+    circle.header.id = i;
+    vgg_svg_element_add(&w, &circle.header);
+    vgg_svg_putn(&w, (char *)fragment, BENCH_GATHER_FRAGMENT_SIZE);
+  }
+  vgg_svg_writer_flush(&w);
+  copied = bench_time() - start;
+  vgg_platform_stream_close(&file);
+
+  vgg_platform_stream_open(&file, "bench_gather.svg");
+  start = bench_time();
+  w = vgg_svg_writer_create(writer_buffer, BENCH_GATHER_FRAGMENTS * 128);
+  vgg_platform_gather_init(&gather, spans, 2 * BENCH_GATHER_FRAGMENTS + 1, &w);
+  for (i = 0; i < BENCH_GATHER_FRAGMENTS; ++i)
+  {
+    circle.header.id = i;
+    vgg_svg_element_add(&w, &circle.header);
+    vgg_platform_gather_fragment(&gather, fragment, BENCH_GATHER_FRAGMENT_SIZE);
+  }
+  vgg_platform_gather_write(&gather, &file);
+  gathered = bench_time() - start;
+  vgg_platform_stream_close(&file);
+
+  printf("%-32s %10.2f ms %10.2f MB/s\n", "fragments copied + write", copied * 1e3, (double)BENCH_GATHER_FRAGMENTS * BENCH_GATHER_FRAGMENT_SIZE / copied / (1024.0 * 1024.0));
+  printf("%-32s %10.2f ms %10.2f MB/s\n", "fragments gathered + writev", gathered * 1e3, (double)BENCH_GATHER_FRAGMENTS * BENCH_GATHER_FRAGMENT_SIZE / gathered / (1024.0 * 1024.0));
+}
+
+#define BENCH_DEVICE_RATE (512.0 * 1024.0 * 1024.0)
+
+/* Sink of a simulated device that takes length / BENCH_DEVICE_RATE seconds per chunk */
+int bench_sink_device(vgg_svg_writer *w)
+{
+  unsigned long *bytes = (unsigned long *)w->sink_user;
+  bench_sleep((double)w->length / BENCH_DEVICE_RATE);
+  *bytes += (unsigned long)w->length;
+  w->length = 0;
+  return 1;
+}
+
+/* Device bound streaming: formatting waits for each chunk (0 buffers) or overlaps with the I/O thread */
+void bench_async(char *name, int buffers)
+{
+  static unsigned char memory[4 * BENCH_CHUNK_CAPACITY];
+
+  unsigned long bytes = 0;
+  vgg_platform_async async;
+  vgg_svg_writer w;
+  vgg_rect rect = {0};
+  double start, seconds;
+  unsigned int i;
+
+  if (buffers)
+  {
+    vgg_platform_async_start(&async, &w, memory, (unsigned long)buffers * BENCH_CHUNK_CAPACITY, buffers, bench_sink_device, &bytes);
+  }
+  else
+  {
+    w = vgg_svg_writer_create_stream(memory, BENCH_CHUNK_CAPACITY, bench_sink_device, &bytes);
+  }
+  rect.header.type = VGG_TYPE_RECT;
+
+  start = bench_time();
+
+  vgg_svg_start(&w, "bench", 1000.0, 1000.0);
+  for (i = 0; i < BENCH_RECTS; ++i)
+  {
+    rect.header.id = i;
+    rect.x = (double)(i % 1000);
+    rect.y = (double)(i / 1000);
+    rect.width = 1.25;
+    rect.height = (double)(i % 37) * 0.5;
+    vgg_svg_element_add(&w, (vgg_header *)&rect);
+  }
+  vgg_svg_end(&w);
+  if (buffers)
+  {
+    vgg_platform_async_finish(&async, &w);
+  }
+  else
+  {
+    vgg_svg_writer_flush(&w);
+  }
+
+  seconds = bench_time() - start;
+
+  printf("%-32s %10.2f ms %10.2f MB/s %8lu stalls\n", name, seconds * 1e3, (double)bytes / seconds / (1024.0 * 1024.0), buffers ? async.stalls : 0UL);
+}
+
+#define BENCH_POINTS 10000000
+#define BENCH_POINTS_CHUNK 65536
+
+/* Clustered scatter points, generated in chunks as they would be streamed in */
+void bench_points_chunk(double *x, double *y, unsigned int first, unsigned int count)
+{
+  unsigned int i;
+
+  for (i = 0; i < count; ++i)
+  {
+    unsigned int k = (first + i) * 2654435761U;
+    double spread = (double)((k >> 8) & 0xFF) + (double)((k >> 16) & 0xFF);
+    x[i] = 250.0 + spread * (double)((k >> 4) & 0x3) * 0.5 + (double)(k & 0xF);
+    y[i] = 250.0 + spread * (double)((k >> 6) & 0x3) * 0.5 + (double)((k >> 24) & 0xF);
+  }
+}
+
+/* 10M scatter points as one circle each against binned into 2 unit cells of the 1000 x 1000 canvas */
+void bench_bins(char *name, int binned)
+{
+  static unsigned char chunk_buffer[BENCH_CHUNK_CAPACITY];
+  static double x[BENCH_POINTS_CHUNK], y[BENCH_POINTS_CHUNK];
+  static unsigned int counts[500 * 500];
+
+  unsigned long bytes = 0;
+  vgg_svg_writer w = vgg_svg_writer_create_stream(chunk_buffer, BENCH_CHUNK_CAPACITY, bench_sink_discard, &bytes);
+  vgg_color low = {255, 255, 200};
+  vgg_color high = {200, 0, 0};
+  vgg_circle circle = {0};
+  vgg_bins bins;
+  unsigned int i, j, elements = 0;
+  double start, seconds;
+
+  circle.header.type = VGG_TYPE_CIRCLE;
+  circle.r = 1.0;
+
+  start = bench_time();
+
+  vgg_svg_start(&w, "bench", 1000.0, 1000.0);
+  vgg_bins_init(&bins, w.cull_viewport, 2.0, counts, 0);
+  for (i = 0; i < BENCH_POINTS; i += BENCH_POINTS_CHUNK)
+  {
+    unsigned int count = (BENCH_POINTS - i < BENCH_POINTS_CHUNK) ? BENCH_POINTS - i : BENCH_POINTS_CHUNK;
+
+    bench_points_chunk(x, y, i, count);
+    if (binned)
+    {
+      vgg_bins_add(&bins, x, y, 0, count);
+      continue;
+    }
+    for (j = 0; j < count; ++j)
+    {
+      circle.header.id = i + j;
+      circle.cx = x[j];
+      circle.cy = y[j];
+      vgg_svg_element_add(&w, &circle.header);
+    }
+    elements += count;
+  }
+  if (binned)
+  {
+    elements = vgg_bins_write(&w, &bins, VGG_TYPE_RECT, 0, low, high, 0);
+  }
+  vgg_svg_end(&w);
+
+  seconds = bench_time() - start;
+
+  printf("%-32s %10.2f ms %10lu elements %10.2f MB\n", name, seconds * 1e3, (unsigned long)elements, (double)bytes / (1024.0 * 1024.0));
+}
+
+#define BENCH_RASTER_ELEMENTS 100000
+#define BENCH_RASTER_SIZE 1024
+
+/* Raster preview of a 400 x 250 heatmap (or 100k scattered circles) at size x size pixels */
+void bench_raster(char *name, int size, int circles)
+{
+  static unsigned char pixels[BENCH_RASTER_SIZE * BENCH_RASTER_SIZE * 4];
+  static float cells[VGG_RASTER_CELLS(BENCH_RASTER_SIZE, BENCH_RASTER_SIZE)];
+
+  vgg_color background = {255, 255, 255};
+  vgg_raster r;
+  vgg_rect rect = {0};
+  vgg_circle circle = {0};
+  double start, seconds;
+  unsigned int i;
+
+  vgg_raster_init(&r, pixels, cells, size, size, 1000.0, 1000.0);
+  vgg_raster_clear(&r, background);
+  rect.header.type = VGG_TYPE_RECT;
+  circle.header.type = VGG_TYPE_CIRCLE;
+
+  start = bench_time();
+
+  for (i = 0; i < BENCH_RASTER_ELEMENTS; ++i)
+  {
+    if (circles)
+    {
+      circle.header.color_fill.r = (int)(i & 0xFF);
+      circle.header.color_fill.b = 128;
+      circle.cx = (double)((i * 7919U) % 1000U);
+      circle.cy = (double)((i * 104729U) % 1000U);
+      circle.r = 1.5 + (double)(i % 5);
+      vgg_raster_element(&r, &circle.header);
+    }
+    else
+    {
+      rect.header.color_fill.r = (int)(i & 0xFF);
+      rect.header.color_fill.g = (int)((i >> 8) & 0xFF);
+      rect.header.color_fill.b = 128;
+      rect.x = (double)(i % 400) * 2.5;
+      rect.y = (double)(i / 400) * 4.0;
+      rect.width = 2.5;
+      rect.height = 4.0;
+      vgg_raster_element(&r, &rect.header);
+    }
+  }
+
+  seconds = bench_time() - start;
+
+  printf("%-32s %10.2f ms %10.2f ns/element\n", name, seconds * 1e3, seconds * 1e9 / (double)BENCH_RASTER_ELEMENTS);
+}
+
+/* Streaming .svgz output: serialization + deflate in one pass against plain serialization */
+void bench_gzip(char *name, int level)
+{
+  static unsigned char chunk_buffer[BENCH_CHUNK_CAPACITY];
+  static unsigned char compressed_buffer[BENCH_CHUNK_CAPACITY];
+  static vgg_gzip gz;
+
+  unsigned long plain_bytes = 0, compressed_bytes = 0;
+  vgg_svg_writer compressed = vgg_svg_writer_create_stream(compressed_buffer, BENCH_CHUNK_CAPACITY, bench_sink_discard, &compressed_bytes);
+  vgg_svg_writer w;
+  vgg_rect rect = {0};
+  double start, seconds;
+  unsigned int i;
+
+  vgg_gzip_init(&gz, &compressed, level);
+  w = level ? vgg_svg_writer_create_stream(chunk_buffer, BENCH_CHUNK_CAPACITY, vgg_gzip_sink, &gz)
+            : vgg_svg_writer_create_stream(chunk_buffer, BENCH_CHUNK_CAPACITY, bench_sink_discard, &plain_bytes);
+  rect.header.type = VGG_TYPE_RECT;
+
+  start = bench_time();
+
+  vgg_svg_start(&w, "bench", 1000.0, 1000.0);
+  for (i = 0; i < BENCH_RECTS; ++i)
+  {
+    rect.header.id = i;
+    rect.header.color_fill.r = (int)(i & 0xFF);
+    rect.header.color_fill.b = 128;
+    rect.x = (double)(i % 1000);
+    rect.y = (double)(i / 1000);
+    rect.width = 1.25;
+    rect.height = (double)(i % 37) * 0.5;
+    vgg_svg_element_add(&w, (vgg_header *)&rect);
+  }
+  vgg_svg_end(&w);
+  if (level)
+  {
+    vgg_gzip_finish(&gz);
+    plain_bytes = gz.size;
+  }
+
+  seconds = bench_time() - start;
+
+  printf("%-32s %10.2f ns/element %10.2f MB/s in %6.2f%% size\n",
+         name,
+         seconds * 1e9 / (double)BENCH_RECTS,
+         (double)plain_bytes / seconds / (1024.0 * 1024.0),
+         level ? 100.0 * (double)compressed_bytes / (double)plain_bytes : 100.0);
+}
+
+#define BENCH_ATOMIC_WINDOW (64UL * 1024UL * 1024UL)
+
+/* Large document to a file: plain stream, atomic through a chunk buffer, atomic formatted into mapped windows */
+void bench_atomic(char *name, int mode)
+{
+  static unsigned char chunk_buffer[BENCH_CHUNK_CAPACITY];
+
+  vgg_platform_stream file;
+  vgg_platform_atomic atomic;
+  vgg_svg_writer w;
+  vgg_rect rect = {0};
+  double start, seconds;
+  unsigned long bytes;
+  unsigned int i;
+
+  start = bench_time();
+
+  if (mode == 0)
+  {
+    vgg_platform_stream_open(&file, "bench_atomic.svg");
+    w = vgg_svg_writer_create_stream(chunk_buffer, BENCH_CHUNK_CAPACITY, vgg_platform_stream_sink, &file);
+  }
+  else
+  {
+    vgg_platform_atomic_open(&atomic, "bench_atomic.svg", 80UL * 1024UL * 1024UL, VGG_PLATFORM_SYNC_NONE);
+    w = vgg_svg_writer_create_stream(chunk_buffer, BENCH_CHUNK_CAPACITY, vgg_platform_atomic_sink, &atomic);
+    if (mode == 2)
+    {
+      vgg_platform_atomic_map(&atomic, &w, BENCH_ATOMIC_WINDOW);
+    }
+  }
+
+  rect.header.type = VGG_TYPE_RECT;
+  vgg_svg_start(&w, "bench", 1000.0, 1000.0);
+  for (i = 0; i < BENCH_RECTS; ++i)
+  {
+    rect.header.id = i;
+    rect.header.color_fill.r = (int)(i & 0xFF);
+    rect.x = (double)(i % 1000);
+    rect.y = (double)(i / 1000);
+    rect.width = 1.25;
+    rect.height = 0.75;
+    vgg_svg_element_add(&w, (vgg_header *)&rect);
+  }
+  vgg_svg_end(&w);
+
+  if (mode == 0)
+  {
+    vgg_platform_stream_close(&file);
+    bytes = 0;
+  }
+  else
+  {
+    bytes = atomic.size;
+    vgg_platform_atomic_commit(&atomic);
+  }
+
+  seconds = bench_time() - start;
+  remove("bench_atomic.svg");
+
+  printf("%-32s %10.2f ms %10lu bytes\n", name, seconds * 1e3, bytes);
+}
+
+/* vgg_svg_put_double before the shared formatting engine (truncating, digit by digit through vgg_svg_putc) */
+void bench_legacy_put_uint(vgg_svg_writer *w, unsigned int val)
+{
+  char buf[10];
+  int i = 10;
+  if (val == 0)
+  {
+    vgg_svg_putc(w, '0');
+    return;
+  }
+  while (val && i)
+  {
+    buf[--i] = (char)('0' + val % 10);
+    val /= 10;
+  }
+  while (i < 10)
+  {
+    vgg_svg_putc(w, buf[i++]);
+  }
+}
+
+void bench_legacy_put_double(vgg_svg_writer *w, double d)
+{
+  int i = (int)d;
+  int frac;
+
+  if (d < 0)
+  {
+    vgg_svg_putc(w, '-');
+    d = -d;
+    i = -i;
+  }
+
+  bench_legacy_put_uint(w, (unsigned int)i);
+  vgg_svg_putc(w, '.');
+
+  frac = (int)((d - (double)i) * 1000.0);
+  if (frac < 0)
+  {
+    frac = -frac;
+  }
+  if (frac < 100)
+  {
+    vgg_svg_putc(w, '0');
+  }
+  if (frac < 10)
+  {
+    vgg_svg_putc(w, '0');
+  }
+  bench_legacy_put_uint(w, (unsigned int)frac);
+}
+
+/* Unchecked write into a reserved span as done by vgg_svg_element_add */
+void bench_raw_double(vgg_svg_writer *w, double d)
+{
+  char *p = vgg_svg_reserve(w, VGG_SVG_DOUBLE_SIZE_MAX);
+  vgg_svg_commit(w, vgg_svg_raw_double(p, d));
+}
+
+void bench_sprintf_double(vgg_svg_writer *w, double d)
+{
+  char *p = vgg_svg_reserve(w, VGG_SVG_DOUBLE_SIZE_MAX);
+  vgg_svg_commit(w, p + sprintf(p, "%.3f", d));
+}
+
+#define BENCH_DOUBLES 10000000
+
+void bench_doubles(char *name, void (*put_double)(vgg_svg_writer *w, double d))
+{
+  static unsigned char chunk_buffer[BENCH_CHUNK_CAPACITY];
+
+  unsigned long bytes = 0;
+  vgg_svg_writer w = vgg_svg_writer_create_stream(chunk_buffer, BENCH_CHUNK_CAPACITY, bench_sink_discard, &bytes);
+  double start, seconds;
+  unsigned int i;
+
+  start = bench_time();
+
+  for (i = 0; i < BENCH_DOUBLES; ++i)
+  {
+    /* Typical coordinates: 0..2000 with up to 3 fractional digits */
+    put_double(&w, (double)(i % 2000) + (double)(i % 997) * 0.001);
+  }
+  vgg_svg_writer_flush(&w);
+
+  seconds = bench_time() - start;
+
+  printf("%-32s %10.2f ns/number  %10.2f MB/s\n",
+         name,
+         seconds * 1e9 / (double)BENCH_DOUBLES,
+         (double)bytes / seconds / (1024.0 * 1024.0));
+}
+
+#define BENCH_COLORS 1000000
+
+void bench_color_map(char *name, void (*color_map)(double *values, unsigned int count, double value_min, double value_max, vgg_color color_start, vgg_color color_end, unsigned char *rgb))
+{
+  static double values[BENCH_COLORS];
+  static unsigned char rgb[BENCH_COLORS * 3];
+
+  vgg_color start = {144, 224, 239};
+  vgg_color end = {255, 85, 0};
+  double begin, seconds;
+  unsigned int i;
+
+  for (i = 0; i < BENCH_COLORS; ++i)
+  {
+    values[i] = (double)(i % 1200) - 100.0;
+  }
+
+  begin = bench_time();
+  color_map(values, BENCH_COLORS, 0.0, 1000.0, start, end, rgb);
+  seconds = bench_time() - begin;
+
+  printf("%-32s %10.2f ns/value\n", name, seconds * 1e9 / (double)BENCH_COLORS);
+}
+
+/* #############################################################################
+ * # MICROBENCHMARK SUITE
+ * #############################################################################
+ * Each case is run a few times to warm up, then measured repeatedly. The median and p99 per item
+ * are reported, with --csv as machine readable lines that --compare checks against a baseline.
+ */
+#define BENCH_RUNS_MAX 101
+#define BENCH_ITEMS_PER_CASE 20000000UL /* Items measured per case, split into 3 to 101 runs */
+#define BENCH_QUICK_ITEMS_MAX 100000UL
+
+/* Runs one repetition over count items, returns the produced bytes */
+typedef unsigned long (*bench_function)(unsigned long count);
+
+static int bench_csv;
+static int bench_quick;
+
+static unsigned char bench_suite_chunk[BENCH_CHUNK_CAPACITY];
+
+void bench_measure(char *name, bench_function function, unsigned long count)
+{
+  double samples[BENCH_RUNS_MAX], median, p99, scale;
+  unsigned long bytes = 0;
+  int runs, warmups, i, j;
+
+  if (bench_quick && count > BENCH_QUICK_ITEMS_MAX)
+  {
+    return;
+  }
+
+  runs = (count * 3 > BENCH_ITEMS_PER_CASE) ? 3 : (int)(BENCH_ITEMS_PER_CASE / count);
+  runs = (runs > BENCH_RUNS_MAX) ? BENCH_RUNS_MAX : runs;
+  runs = bench_quick ? (runs > 11 ? 11 : runs) : runs;
+  warmups = runs / 10 + 1;
+
+  for (i = 0; i < warmups; ++i)
+  {
+    function(count);
+  }
+
+  for (i = 0; i < runs; ++i)
+  {
+    double start = bench_time();
+    bytes = function(count);
+    samples[i] = bench_time() - start;
+  }
+
+  /* Insertion sort, at most 101 samples */
+  for (i = 1; i < runs; ++i)
+  {
+    double sample = samples[i];
+    for (j = i; j > 0 && samples[j - 1] > sample; --j)
+    {
+      samples[j] = samples[j - 1];
+    }
+    samples[j] = sample;
+  }
+
+  /* Nearest rank, the slowest run below 100 runs */
+  median = samples[runs / 2];
+  p99 = samples[(99 * runs + 99) / 100 - 1];
+  scale = 1e9 / (double)count;
+
+  if (bench_csv)
+  {
+    printf("%s,%lu,%d,%.3f,%.3f,%.3f,%.2f\n", name, count, runs, median * scale, p99 * scale, samples[0] * scale, (double)bytes / median / (1024.0 * 1024.0));
+  }
+  else
+  {
+    printf("%-32s %9lu x %3d %10.2f ns/item median %10.2f p99 %10.2f MB/s\n", name, count, runs, median * scale, p99 * scale, (double)bytes / median / (1024.0 * 1024.0));
+  }
+}
+
+/* count elements of one type, all types in turn past VGG_TYPE_PATH */
+void bench_suite_elements(vgg_svg_writer *w, unsigned long count, vgg_header_type type)
+{
+  unsigned long i;
+  vgg_rect rect = {0};
+  vgg_circle circle = {0};
+  vgg_line line = {0};
+  vgg_ellipse ellipse = {0};
+  vgg_text text = {0};
+  vgg_path path = {0};
+  vgg_header *headers[VGG_TYPE_PATH + 1];
+
+  headers[VGG_TYPE_RECT] = &rect.header;
+  headers[VGG_TYPE_CIRCLE] = &circle.header;
+  headers[VGG_TYPE_LINE] = &line.header;
+  headers[VGG_TYPE_ELLIPSE] = &ellipse.header;
+  headers[VGG_TYPE_TEXT] = &text.header;
+  headers[VGG_TYPE_PATH] = &path.header;
+  rect.header.type = VGG_TYPE_RECT;
+  circle.header.type = VGG_TYPE_CIRCLE;
+  line.header.type = VGG_TYPE_LINE;
+  ellipse.header.type = VGG_TYPE_ELLIPSE;
+  text.header.type = VGG_TYPE_TEXT;
+  text.text = "label";
+  path.header.type = VGG_TYPE_PATH;
+  path.d = "M10 10 L90 10 L90 90 Z";
+
+  for (i = 0; i < count; ++i)
+  {
+    double x = (double)(i % 1000) + 0.25, y = (double)(i / 1000 % 1000) + 0.5;
+    vgg_header_type current = (type > VGG_TYPE_PATH) ? (vgg_header_type)(i % 6) : type;
+    vgg_header *header = headers[current];
+
+    header->id = (unsigned int)i;
+    header->color_fill.r = (int)(i & 0xFF);
+    header->color_fill.b = 128;
+
+    rect.x = x;
+    rect.y = y;
+    rect.width = 1.25;
+    rect.height = (double)(i % 37) * 0.5;
+    circle.cx = x;
+    circle.cy = y;
+    circle.r = 2.5;
+    line.x1 = x;
+    line.y1 = y;
+    line.x2 = x + 10.0;
+    line.y2 = y + 3.75;
+    ellipse.cx = x;
+    ellipse.cy = y;
+    ellipse.rx = 4.0;
+    ellipse.ry = 1.5;
+    text.x = x;
+    text.y = y;
+
+    vgg_svg_element_add(w, header);
+  }
+}
+
+/* Elements through a streaming writer, the chunks are discarded */
+unsigned long bench_case_elements(unsigned long count, vgg_header_type type)
+{
+  unsigned long bytes = 0;
+  vgg_svg_writer w = vgg_svg_writer_create_stream(bench_suite_chunk, BENCH_CHUNK_CAPACITY, bench_sink_discard, &bytes);
+
+  bench_suite_elements(&w, count, type);
+  vgg_svg_writer_flush(&w);
+
+  return bytes;
+}
+
+unsigned long bench_case_rect(unsigned long count) { return bench_case_elements(count, VGG_TYPE_RECT); }
+unsigned long bench_case_circle(unsigned long count) { return bench_case_elements(count, VGG_TYPE_CIRCLE); }
+unsigned long bench_case_line(unsigned long count) { return bench_case_elements(count, VGG_TYPE_LINE); }
+unsigned long bench_case_ellipse(unsigned long count) { return bench_case_elements(count, VGG_TYPE_ELLIPSE); }
+unsigned long bench_case_text(unsigned long count) { return bench_case_elements(count, VGG_TYPE_TEXT); }
+unsigned long bench_case_path(unsigned long count) { return bench_case_elements(count, VGG_TYPE_PATH); }
+
+/* Whole document: header, all element types in turn, closing tag */
+unsigned long bench_case_document(unsigned long count)
+{
+  unsigned long bytes = 0;
+  vgg_svg_writer w = vgg_svg_writer_create_stream(bench_suite_chunk, BENCH_CHUNK_CAPACITY, bench_sink_discard, &bytes);
+
+  vgg_svg_start(&w, "bench", 1000.0, 1000.0);
+  bench_suite_elements(&w, count, (vgg_header_type)(VGG_TYPE_PATH + 1));
+  vgg_svg_end(&w);
+
+  return bytes;
+}
+
+/* Same document through a measuring writer, nothing is stored */
+unsigned long bench_case_measure(unsigned long count)
+{
+  vgg_svg_writer w = vgg_svg_writer_create_measure();
+
+  vgg_svg_start(&w, "bench", 1000.0, 1000.0);
+  bench_suite_elements(&w, count, (vgg_header_type)(VGG_TYPE_PATH + 1));
+  vgg_svg_end(&w);
+
+  return (unsigned long)w.length;
+}
+
+unsigned long bench_case_itoa(unsigned long count)
+{
+  char buffer[16];
+  unsigned long bytes = 0, i;
+
+  for (i = 0; i < count; ++i)
+  {
+    bytes += (unsigned long)vgg_svg_strlen(vgg_itoa((int)(i * 2654435761UL & 0x7FFFFFFFUL) - 0x3FFFFFFF, buffer));
+  }
+  return bytes;
+}
+
+unsigned long bench_case_ftoa(unsigned long count)
+{
+  char buffer[VGG_FMT_DOUBLE_SIZE_MAX + 1];
+  unsigned long bytes = 0, i;
+
+  for (i = 0; i < count; ++i)
+  {
+    bytes += (unsigned long)vgg_svg_strlen(vgg_ftoa((double)i * 0.37 - 1234.5, buffer, 3));
+  }
+  return bytes;
+}
+
+unsigned long bench_case_put_double(unsigned long count)
+{
+  unsigned long bytes = 0, i;
+  vgg_svg_writer w = vgg_svg_writer_create_stream(bench_suite_chunk, BENCH_CHUNK_CAPACITY, bench_sink_discard, &bytes);
+
+  for (i = 0; i < count; ++i)
+  {
+    vgg_svg_put_double(&w, (double)i * 0.37 - 1234.5);
+  }
+  vgg_svg_writer_flush(&w);
+  return bytes;
+}
+
+unsigned long bench_case_puts(unsigned long count)
+{
+  unsigned long bytes = 0, i;
+  vgg_svg_writer w = vgg_svg_writer_create_stream(bench_suite_chunk, BENCH_CHUNK_CAPACITY, bench_sink_discard, &bytes);
+
+  for (i = 0; i < count; ++i)
+  {
+    vgg_svg_puts(&w, "  <rect x=\"");
+  }
+  vgg_svg_writer_flush(&w);
+  return bytes;
+}
+
+/* Color mapping in blocks of BENCH_RECTS values */
+unsigned long bench_case_color_map(unsigned long count)
+{
+  static double values[BENCH_RECTS];
+  static unsigned char rgb[3 * BENCH_RECTS];
+  vgg_color start = {0, 0, 255};
+  vgg_color end = {255, 0, 0};
+  unsigned long i, done;
+
+  for (i = 0; values[1] == 0.0 && i < BENCH_RECTS; ++i)
+  {
+    values[i] = (double)(i % 1000) * 0.001;
+  }
+
+  for (done = 0; done < count; done += BENCH_RECTS)
+  {
+    unsigned long n = (count - done < BENCH_RECTS) ? count - done : BENCH_RECTS;
+    vgg_color_map_linear_batch(values, (unsigned int)n, 0.0, 1.0, start, end, rgb);
+  }
+  return 3 * count;
+}
+
+unsigned long bench_case_colormap(unsigned long count)
+{
+  static vgg_colormap map;
+  vgg_color stops[3] = {{0, 0, 255}, {255, 255, 255}, {255, 0, 0}};
+  unsigned long sum = 0, i;
+
+  vgg_colormap_init(&map, stops, 0, 3, 0.0, 1.0);
+  for (i = 0; i < count; ++i)
+  {
+    sum += (unsigned long)vgg_colormap_index(&map, (double)(i % 1000) * 0.001);
+  }
+  return 3 * count + (sum & 1);
+}
+
+void bench_suite(void)
+{
+  if (bench_csv)
+  {
+    printf("name,items,runs,median_ns,p99_ns,min_ns,mb_s\n");
+  }
+
+  bench_measure("format itoa", bench_case_itoa, 100000UL);
+  bench_measure("format ftoa", bench_case_ftoa, 100000UL);
+  bench_measure("format put_double", bench_case_put_double, 100000UL);
+  bench_measure("format puts", bench_case_puts, 100000UL);
+  bench_measure("color map_linear_batch", bench_case_color_map, 100000UL);
+  bench_measure("color colormap_index", bench_case_colormap, 100000UL);
+  bench_measure("element rect", bench_case_rect, 100000UL);
+  bench_measure("element circle", bench_case_circle, 100000UL);
+  bench_measure("element line", bench_case_line, 100000UL);
+  bench_measure("element ellipse", bench_case_ellipse, 100000UL);
+  bench_measure("element text", bench_case_text, 100000UL);
+  bench_measure("element path", bench_case_path, 100000UL);
+  bench_measure("document 1k", bench_case_document, 1000UL);
+  bench_measure("document 10k", bench_case_document, 10000UL);
+  bench_measure("document 100k", bench_case_document, 100000UL);
+  bench_measure("document 1M", bench_case_document, 1000000UL);
+  bench_measure("document 10M", bench_case_document, 10000000UL);
+  bench_measure("measure 1k", bench_case_measure, 1000UL);
+  bench_measure("measure 100k", bench_case_measure, 100000UL);
+  bench_measure("measure 1M", bench_case_measure, 1000000UL);
+}
+
+/* Reads "name,items,runs,median_ns,..." lines, returns the number of cases */
+int bench_read_csv(char *filename, char names[][64], unsigned long *items, double *median, int capacity)
+{
+  char line[256];
+  int count = 0;
+  FILE *file = fopen(filename, "r");
+
+  if (!file)
+  {
+    return -1;
+  }
+
+  while (count < capacity && fgets(line, sizeof(line), file))
+  {
+    int runs;
+    if (sscanf(line, "%63[^,],%lu,%d,%lf", names[count], &items[count], &runs, &median[count]) == 4)
+    {
+      count++;
+    }
+  }
+
+  fclose(file);
+  return count;
+}
+
+/* Median per item of each case in current against baseline, returns 1 if one got slower than threshold percent */
+int bench_compare(char *baseline, char *current, double threshold)
+{
+  static char names[2][64][64];
+  unsigned long items[2][64];
+  double median[2][64];
+  int counts[2], i, j, regressions = 0;
+
+  counts[0] = bench_read_csv(baseline, names[0], items[0], median[0], 64);
+  counts[1] = bench_read_csv(current, names[1], items[1], median[1], 64);
+  if (counts[0] < 0 || counts[1] < 0)
+  {
+    printf("can not read %s\n", counts[0] < 0 ? baseline : current);
+    return 2;
+  }
+
+  for (i = 0; i < counts[1]; ++i)
+  {
+    for (j = 0; j < counts[0]; ++j)
+    {
+      if (strcmp(names[0][j], names[1][i]) == 0 && items[0][j] == items[1][i])
+      {
+        double change = (median[1][i] - median[0][j]) / median[0][j] * 100.0;
+        int slower = change > threshold;
+
+        printf("%-32s %10.2f -> %10.2f ns/item %+7.1f%%%s\n", names[1][i], median[0][j], median[1][i], change, slower ? "  REGRESSION" : "");
+        regressions += slower;
+        break;
+      }
+    }
+  }
+
+  return regressions > 0;
+}
+
+/* vgg_bench              suite followed by the feature comparisons
+   vgg_bench --csv        suite only, machine readable
+   vgg_bench --quick      suite with at most 100k items per case and 11 runs (combines with --csv)
+   vgg_bench --compare baseline.csv current.csv [threshold percent, default 10]
+*/
+int main(int argc, char **argv)
+{
+  int i;
+
+  for (i = 1; i < argc; ++i)
+  {
+    if (strcmp(argv[i], "--compare") == 0 && i + 2 < argc)
+    {
+      double threshold = 10.0;
+      if (i + 3 < argc)
+      {
+        sscanf(argv[i + 3], "%lf", &threshold);
+      }
+      return bench_compare(argv[i + 1], argv[i + 2], threshold);
+    }
+    bench_csv |= strcmp(argv[i], "--csv") == 0;
+    bench_quick |= strcmp(argv[i], "--quick") == 0;
+  }
+
+  bench_suite();
+  if (bench_csv || bench_quick)
+  {
+    return 0;
+  }
+  printf("\n");
+
+  bench_color_map("color_map_linear scalar", vgg_color_map_linear_batch_scalar);
+  bench_color_map("color_map_linear batch", vgg_color_map_linear_batch);
+
+  bench_doubles("double legacy put_double", bench_legacy_put_double);
+  bench_doubles("double sprintf", bench_sprintf_double);
+  bench_doubles("double put_double", vgg_svg_put_double);
+  bench_doubles("double raw_double", bench_raw_double);
+
+  bench_rects("rects element_add_checked", vgg_svg_element_add_checked);
+  bench_rects("rects element_add", vgg_svg_element_add);
+  bench_rects("rects scene capture", vgg_scene_add);
+  bench_scene_convert();
+  bench_rects_batch("rects rects_add (columns)");
+  bench_heatmap("heatmap color_map_linear", 0, 0);
+  bench_heatmap("heatmap colormap lut", 1, 0);
+  bench_heatmap("heatmap colormap lut + style", 1, 1);
+  bench_path("path sprintf d + element_add", 0);
+  bench_path("path builder", 1);
+  bench_simplify("path simplify_minmax", 0);
+  bench_simplify("path simplify_rdp", 1);
+  bench_simplify("path simplify_minmax + rdp", 2);
+  bench_cull();
+  bench_document();
+  bench_dashboard("dashboard 1% full write", 0);
+  bench_dashboard("dashboard 1% render fills", 1);
+  bench_dashboard("dashboard 1% render geometry", 2);
+  bench_platform_cache();
+  bench_parallel();
+  bench_gather();
+  bench_atomic("file stream (O_TRUNC)", 0);
+  bench_atomic("file atomic write", 1);
+  bench_atomic("file atomic mmap window", 2);
+  bench_async("device stream (sync)", 0);
+  bench_async("device async 2 buffers", 2);
+  bench_async("device async 4 buffers", 4);
+  bench_bins("scatter 10M circles", 0);
+  bench_bins("scatter 10M binned", 1);
+  bench_raster("raster heatmap 100k 1024px", 1024, 0);
+  bench_raster("raster heatmap 100k 256px", 256, 0);
+  bench_raster("raster circles 100k 1024px", 1024, 1);
+  bench_gzip("svg plain", 0);
+  bench_gzip("svgz fast", VGG_GZIP_LEVEL_FAST);
+  bench_gzip("svgz best", VGG_GZIP_LEVEL_BEST);
+
+  return 0;
+}
+
+/*
+   ------------------------------------------------------------------------------
+   This software is available under 2 licenses -- choose whichever you prefer.
+   ------------------------------------------------------------------------------
+   ALTERNATIVE A - MIT License
+   Copyright (c) 2025 nickscha
+   Permission is hereby granted, free of charge, to any person obtaining a copy of
+   this software and associated documentation files (the "Software"), to deal in
+   the Software without restriction, including without limitation the rights to
+   use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies
+   of the Software, and to permit persons to whom the Software is furnished to do
+   so, subject to the following conditions:
+   The above copyright notice and this permission notice shall be included in all
+   copies or substantial portions of the Software.
+   THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+   IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+   FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+   AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+   LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+   OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+   SOFTWARE.
+   ------------------------------------------------------------------------------
+   ALTERNATIVE B - Public Domain (www.unlicense.org)
+   This is free and unencumbered software released into the public domain.
+   Anyone is free to copy, modify, publish, use, compile, sell, or distribute this
+   software, either in source code form or as a compiled binary, for any purpose,
+   commercial or non-commercial, and by any means.
+   In jurisdictions that recognize copyright laws, the author or authors of this
+   software dedicate any and all copyright interest in the software to the public
+   domain. We make this dedication for the benefit of the public at large and to
+   the detriment of our heirs and successors. We intend this dedication to be an
+   overt act of relinquishment in perpetuity of all present and future rights to
+   this software under copyright law.
+   THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+   IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+   FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+   AUTHORS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN
+   ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+   WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+   ------------------------------------------------------------------------------
+*/
@@ -10,11 +10,21 @@ LICENSE
   See end of file for detailed license information.
 
 */
+#define VGG_STATS /* Writer statistics, see vgg_test_svg_stats */
+
 #include "../vgg.h"                /* Vector graphics generator                        */
 #include "../vgg_platform_write.h" /* Optional: OS-Specific write file implementations */
+#include "../vgg_platform_cache.h" /* Optional: OS-Specific rendered fragment cache       */
+#include "../vgg_platform_parallel.h" /* Optional: OS-Specific parallel serialization   */
+#include "../vgg_platform_async.h"    /* Optional: OS-Specific asynchronous writer        */
+#include "../vgg_gzip.h"              /* Optional: gzip compressed output (.svgz)         */
+#include "../vgg_scene.h"             /* Optional: binary scene capture                   */
+#include "../vgg_raster.h"            /* Optional: software rasterizer                    */
 
 #include "test.h" /* Simple Testing framework */
 
+#include <limits.h>
+
 void vgg_test_data_field(void)
 {
   char value_buffer[32];
@@ -23,6 +33,113 @@ void vgg_test_data_field(void)
   printf("%s, %s\n", f1.key, f1.value);
 }
 
+int vgg_test_bytes_equal(unsigned char *a, unsigned char *b, int length)
+{
+  int i;
+  for (i = 0; i < length; ++i)
+  {
+    if (a[i] != b[i])
+    {
+      return 0;
+    }
+  }
+  return 1;
+}
+
+int vgg_test_string_equals(char *a, char *b)
+{
+  while (*a && *a == *b)
+  {
+    a++;
+    b++;
+  }
+  return *a == *b;
+}
+
+/* Formats with vgg_ftoa and compares to the C standard library */
+int vgg_test_ftoa_matches_printf(double value, int precision)
+{
+  char expected[512];
+  char buffer[VGG_FMT_DOUBLE_SIZE_MAX + 1];
+
+  sprintf(expected, "%.*f", precision, value);
+  vgg_ftoa(value, buffer, precision);
+
+  return vgg_test_string_equals(buffer, expected);
+}
+
+void vgg_test_ftoa(void)
+{
+  char buffer[VGG_FMT_DOUBLE_SIZE_MAX + 1];
+
+  /* Rounding instead of truncation, ties to even on exact halves */
+  assert(vgg_test_ftoa_matches_printf(0.0005, 3));
+  assert(vgg_test_ftoa_matches_printf(1.0005, 3));
+  assert(vgg_test_ftoa_matches_printf(0.9999, 3));
+  assert(vgg_test_ftoa_matches_printf(2.5, 0));
+  assert(vgg_test_ftoa_matches_printf(3.5, 0));
+  assert(vgg_test_ftoa_matches_printf(0.125, 2));
+  assert(vgg_test_ftoa_matches_printf(-123.456789, 4));
+  assert(vgg_test_ftoa_matches_printf(3.14159265358979, 9));
+
+  /* Beyond 32-bit integers */
+  assert(vgg_test_ftoa_matches_printf(4294967296.75, 1));
+  assert(vgg_test_ftoa_matches_printf(-9007199254740991.5, 1));
+  assert(vgg_test_ftoa_matches_printf(1e20, 3));
+  assert(vgg_test_ftoa_matches_printf(1.7976931348623157e308, 2));
+
+  /* Special values */
+  assert(vgg_test_string_equals(vgg_ftoa(-0.0, buffer, 3), "0.000"));
+  assert(vgg_test_string_equals(vgg_ftoa(-0.0001, buffer, 3), "0.000"));
+  assert(vgg_test_string_equals(vgg_ftoa(1.0 / 0.0, buffer, 3), "inf"));
+  assert(vgg_test_string_equals(vgg_ftoa(-1.0 / 0.0, buffer, 3), "-inf"));
+  assert(vgg_test_string_equals(vgg_ftoa(0.0 / 0.0, buffer, 3), "nan"));
+}
+
+void vgg_test_itoa(void)
+{
+  char expected[32];
+  char buffer[VGG_FMT_LONG_SIZE_MAX + 1];
+
+  assert(vgg_test_string_equals(vgg_itoa(0, buffer), "0"));
+  assert(vgg_test_string_equals(vgg_itoa(7, buffer), "7"));
+  assert(vgg_test_string_equals(vgg_itoa(-42, buffer), "-42"));
+  assert(vgg_test_string_equals(vgg_itoa(1000000, buffer), "1000000"));
+
+  sprintf(expected, "%d", INT_MIN);
+  assert(vgg_test_string_equals(vgg_itoa(INT_MIN, buffer), expected));
+
+  sprintf(expected, "%ld", LONG_MIN);
+  assert(vgg_test_string_equals(vgg_ltoa(LONG_MIN, buffer), expected));
+
+  sprintf(expected, "%ld", LONG_MAX);
+  assert(vgg_test_string_equals(vgg_ltoa(LONG_MAX, buffer), expected));
+
+  sprintf(expected, "%lu", ULONG_MAX);
+  assert(vgg_test_string_equals(vgg_ultoa(ULONG_MAX, buffer), expected));
+
+  assert(vgg_test_string_equals(vgg_ultoa(999999999UL, buffer), "999999999"));
+}
+
+void vgg_test_svg_put_double(void)
+{
+  static unsigned char binary_buffer[64];
+
+  vgg_svg_writer w = vgg_svg_writer_create(binary_buffer, 64);
+
+  /* Trailing zeros are left out */
+  vgg_svg_put_double(&w, 800.0);
+  vgg_svg_putc(&w, ' ');
+  vgg_svg_put_double(&w, 10.5);
+  vgg_svg_putc(&w, ' ');
+  vgg_svg_put_double(&w, -0.1236);
+  vgg_svg_putc(&w, ' ');
+  vgg_svg_put_double(&w, 3000000000.25);
+  vgg_svg_putc(&w, '\0');
+
+  assert(vgg_test_string_equals((char *)w.buffer, "800 10.5 -0.124 3000000000.25"));
+}
+
 void vgg_test_color_map_linear(void)
 {
   vgg_color start = {144, 224, 239}; /* Start (light teal): 144, 224, 239 */
@@ -37,6 +154,98 @@ void vgg_test_color_map_linear(void)
   assert(current.r == 255 && current.g == 85 && current.b == 0);
 }
 
+void vgg_test_color_map_linear_batch(void)
+{
+#define COLOR_MAP_COUNT 1001
+  static double values[COLOR_MAP_COUNT];
+  static unsigned char rgb[COLOR_MAP_COUNT * 3];
+
+  vgg_color start = {144, 224, 239};
+  vgg_color end = {255, 85, 0};
+  unsigned int i;
+  int equal = 1;
+
+  /* Includes values below and above the range to check the clamping */
+  for (i = 0; i < COLOR_MAP_COUNT; ++i)
+  {
+    values[i] = -2.0 + (double)i * 0.0137;
+  }
+
+  vgg_color_map_linear_batch(values, COLOR_MAP_COUNT, 0.0, 10.0, start, end, rgb);
+
+  for (i = 0; i < COLOR_MAP_COUNT; ++i)
+  {
+    vgg_color expected = vgg_color_map_linear(values[i], 0.0, 10.0, start, end);
+    equal = equal && rgb[i * 3 + 0] == expected.r && rgb[i * 3 + 1] == expected.g && rgb[i * 3 + 2] == expected.b;
+  }
+  assert(equal);
+
+  /* Empty range maps everything to the start color */
+  vgg_color_map_linear_batch(values, 3, 5.0, 5.0, start, end, rgb);
+  assert(rgb[0] == 144 && rgb[1] == 224 && rgb[2] == 239);
+  assert(rgb[6] == 144 && rgb[7] == 224 && rgb[8] == 239);
+}
+
+void vgg_test_colormap(void)
+{
+  static vgg_colormap map;
+  static unsigned char mapped_buffer[8192];
+  static unsigned char colors_buffer[8192];
+
+  /* viridis-like stops */
+  vgg_color stops[3] = {{68, 1, 84}, {33, 145, 140}, {253, 231, 37}};
+  double positions[3] = {0.0, 0.25, 1.0};
+
+  double x[4] = {0.0, 1.0, 2.0, 3.0};
+  double size[4] = {1.0, 1.0, 1.0, 1.0};
+  double values[4] = {-5.0, 25.0, 50.0, 1000.0};
+  vgg_color colors[4];
+  char hex[6];
+  int i;
+
+  vgg_svg_writer mapped = vgg_svg_writer_create(mapped_buffer, 8192);
+  vgg_svg_writer direct = vgg_svg_writer_create(colors_buffer, 8192);
+
+  vgg_colormap_init(&map, stops, 0, 3, 0.0, 100.0);
+
+  /* Stops at both ends, clamped outside of the range */
+  assert(vgg_colormap_index(&map, -1.0) == 0);
+  assert(vgg_colormap_index(&map, 100.0) == VGG_COLORMAP_SIZE - 1);
+  assert(vgg_colormap_index(&map, 0.0 / 0.0) == 0);
+  assert(vgg_colormap_map(&map, 0.0).r == 68 && vgg_colormap_map(&map, 0.0).b == 84);
+  assert(vgg_colormap_map(&map, 1e9).r == 253 && vgg_colormap_map(&map, 1e9).g == 231);
+
+  /* Middle stop of an evenly spaced map */
+  assert(vgg_colormap_map(&map, 50.0).r >= 33 && vgg_colormap_map(&map, 50.0).r <= 36);
+
+  /* Explicit stop positions */
+  vgg_colormap_init(&map, stops, positions, 3, 0.0, 100.0);
+  assert(vgg_colormap_map(&map, 25.0).g >= 144 && vgg_colormap_map(&map, 25.0).g <= 146);
+
+  /* Pre-rendered hex strings */
+  for (i = 0; i < VGG_COLORMAP_SIZE; i += 17)
+  {
+    vgg_svg_raw_color(hex, map.colors[i]);
+    assert(vgg_test_bytes_equal((unsigned char *)hex, (unsigned char *)map.hex[i], 6));
+  }
+
+  /* The public color macro writes the same digits */
+  VGG_SVG_PUT_COLOR(&mapped, map.colors[VGG_COLORMAP_SIZE - 1]);
+  assert(mapped.length == 6 && vgg_test_bytes_equal(mapped.buffer, (unsigned char *)map.hex[VGG_COLORMAP_SIZE - 1], 6));
+  mapped.length = 0;
+
+  /* Same output as mapping the colors first */
+  for (i = 0; i < 4; ++i)
+  {
+    colors[i] = vgg_colormap_map(&map, values[i]);
+  }
+  vgg_svg_rects_add_colormap(&mapped, 4, 0, x, x, size, size, values, &map);
+  vgg_svg_rects_add(&direct, 4, 0, x, x, size, size, colors);
+
+  assert(mapped.length == direct.length);
+  assert(vgg_test_bytes_equal(mapped.buffer, direct.buffer, direct.length));
+}
+
 void vgg_test_svg_write_rect(void)
 {
 /* vgg.h does not use File IO and just fills the buffer with the executable file data */
@@ -44,7 +253,7 @@ void vgg_test_svg_write_rect(void)
   static unsigned char binary_buffer[BINARY_CAPACITY];
 
   /* Initialize the VGA writer */
-  vgg_svg_writer w = {binary_buffer, BINARY_CAPACITY, 0};
+  vgg_svg_writer w = vgg_svg_writer_create(binary_buffer, BINARY_CAPACITY);
 
   vgg_color color_green = {0, 255, 0};
 
@@ -88,7 +297,7 @@ void vgg_test_svg_write_circle(void)
   static unsigned char binary_buffer[BINARY_CAPACITY];
 
   /* Initialize the VGA writer */
-  vgg_svg_writer w = {binary_buffer, BINARY_CAPACITY, 0};
+  vgg_svg_writer w = vgg_svg_writer_create(binary_buffer, BINARY_CAPACITY);
 
   vgg_color color_red = {255, 0, 0};
 
@@ -121,7 +330,7 @@ void vgg_test_svg_write_text(void)
   static unsigned char binary_buffer[BINARY_CAPACITY];
 
   /* Initialize the VGA writer */
-  vgg_svg_writer w = {binary_buffer, BINARY_CAPACITY, 0};
+  vgg_svg_writer w = vgg_svg_writer_create(binary_buffer, BINARY_CAPACITY);
 
   vgg_color color_red = {255, 0, 0};
 
@@ -147,13 +356,2032 @@ void vgg_test_svg_write_text(void)
   vgg_platform_write("test_text.svg", w.buffer, (unsigned long)w.length);
 }
 
+/* Writes a small document using all element types */
+void vgg_test_scene_write_with(vgg_svg_writer *w, void (*element_add)(vgg_svg_writer *w, vgg_header *header))
+{
+  vgg_color color_green = {0, 255, 0};
+  vgg_color color_red = {255, 0, 0};
+
+  vgg_data_field data_fields[2];
+
+  vgg_rect rect = {0};
+  vgg_circle circle = {0};
+  vgg_line line = {0};
+  vgg_ellipse ellipse = {0};
+  vgg_text text = {0};
+  vgg_path path = {0};
+
+  data_fields[0].key = "weight";
+  data_fields[0].value = "20.0";
+  data_fields[1].key = "num_lines_of_code";
+  data_fields[1].value = "165";
+
+  rect.header.type = VGG_TYPE_RECT;
+  rect.header.id = 1;
+  rect.header.color_fill = color_green;
+  rect.header.data_fields = data_fields;
+  rect.header.data_fields_count = 2;
+  rect.x = 10.5;
+  rect.y = 20.25;
+  rect.width = 100.0;
+  rect.height = 50.0;
+
+  circle.header.type = VGG_TYPE_CIRCLE;
+  circle.header.id = 2;
+  circle.header.color_fill = color_red;
+  circle.cx = 200.0;
+  circle.cy = 200.0;
+  circle.r = 100.0;
+
+  line.header.type = VGG_TYPE_LINE;
+  line.header.id = 3;
+  line.x1 = 0.0;
+  line.y1 = 0.0;
+  line.x2 = 400.0;
+  line.y2 = 300.0;
+
+  ellipse.header.type = VGG_TYPE_ELLIPSE;
+  ellipse.header.id = 4;
+  ellipse.header.color_fill = color_green;
+  ellipse.cx = 50.0;
+  ellipse.cy = 60.0;
+  ellipse.rx = 30.0;
+  ellipse.ry = 20.0;
+
+  text.header.type = VGG_TYPE_TEXT;
+  text.header.id = 5;
+  text.header.color_fill = color_red;
+  text.x = 100.0;
+  text.y = 100.0;
+  text.text = "test";
+
+  path.header.type = VGG_TYPE_PATH;
+  path.header.id = 6;
+  path.header.color_fill = color_red;
+  path.d = "M10 10 L90 10 L90 90 Z";
+
+  vgg_svg_start(w, "vgg_svg", 400, 400);
+  {
+    element_add(w, (vgg_header *)&rect);
+    element_add(w, (vgg_header *)&circle);
+    element_add(w, (vgg_header *)&line);
+    element_add(w, (vgg_header *)&ellipse);
+    element_add(w, (vgg_header *)&text);
+    element_add(w, (vgg_header *)&path);
+  }
+  vgg_svg_end(w);
+}
+
+void vgg_test_scene_write(vgg_svg_writer *w)
+{
+  vgg_test_scene_write_with(w, vgg_svg_element_add);
+}
+
+/* Streaming sink that collects all chunks into one memory block */
+typedef struct vgg_test_memory_sink
+{
+  unsigned char *data;
+  int capacity;
+  int length;
+  int calls;
+
+} vgg_test_memory_sink;
+
+int vgg_test_memory_sink_flush(vgg_svg_writer *w)
+{
+  vgg_test_memory_sink *sink = (vgg_test_memory_sink *)w->sink_user;
+  int i;
+
+  sink->calls++;
+
+  for (i = 0; i < w->length; ++i)
+  {
+    if (sink->length >= sink->capacity)
+    {
+      return 0;
+    }
+    sink->data[sink->length++] = w->buffer[i];
+  }
+
+  w->length = 0;
+  return 1;
+}
+
+void vgg_test_svg_write_stream(void)
+{
+  static unsigned char fixed_buffer[4096];
+  static unsigned char chunk_buffer[256];
+  static unsigned char sink_buffer[4096];
+
+  /* Chunks smaller and larger than the worst case size of an element */
+  int chunk_sizes[2] = {7, 256};
+  int i;
+
+  vgg_svg_writer fixed = vgg_svg_writer_create(fixed_buffer, 4096);
+
+  vgg_test_scene_write(&fixed);
+  assert(!fixed.truncated);
+
+  for (i = 0; i < 2; ++i)
+  {
+    vgg_svg_writer stream;
+    vgg_test_memory_sink sink = {0};
+
+    sink.data = sink_buffer;
+    sink.capacity = 4096;
+
+    stream = vgg_svg_writer_create_stream(chunk_buffer, chunk_sizes[i], vgg_test_memory_sink_flush, &sink);
+
+    vgg_test_scene_write(&stream);
+
+    assert(!stream.truncated);
+    assert(stream.length == 0);
+    assert(sink.calls > 1);
+    assert(sink.length == fixed.length);
+    assert(vgg_test_bytes_equal(sink.data, fixed.buffer, fixed.length));
+  }
+}
+
+void vgg_test_svg_write_stream_failed(void)
+{
+  static unsigned char chunk_buffer[16];
+  static unsigned char sink_buffer[32];
+
+  vgg_svg_writer stream;
+  vgg_test_memory_sink sink = {0};
+
+  /* Sink runs out of space */
+  sink.data = sink_buffer;
+  sink.capacity = 32;
+
+  stream = vgg_svg_writer_create_stream(chunk_buffer, 16, vgg_test_memory_sink_flush, &sink);
+
+  vgg_test_scene_write(&stream);
+
+  assert(stream.truncated);
+  assert(stream.sink == 0);
+  assert(!vgg_svg_writer_flush(&stream));
+}
+
+void vgg_test_platform_async(void)
+{
+  static unsigned char fixed_buffer[8192];
+  static unsigned char async_memory[3 * 64];
+  static unsigned char sink_buffer[8192];
+
+  vgg_svg_writer fixed = vgg_svg_writer_create(fixed_buffer, 8192);
+  vgg_svg_writer w;
+  vgg_platform_async async;
+  vgg_test_memory_sink sink = {0};
+
+  sink.data = sink_buffer;
+  sink.capacity = 8192;
+
+  vgg_test_scene_write(&fixed);
+
+  /* Three 64 byte buffers, the writer has to wait for the I/O thread */
+  assert(vgg_platform_async_start(&async, &w, async_memory, sizeof(async_memory), 3, vgg_test_memory_sink_flush, &sink));
+  assert(async.count == 3);
+  assert(async.capacity == 64);
+  vgg_test_scene_write(&w);
+  assert(vgg_platform_async_finish(&async, &w));
+
+  assert(!w.truncated);
+  assert(sink.length == fixed.length);
+  assert(vgg_test_bytes_equal(sink.data, fixed.buffer, fixed.length));
+  assert(sink.calls > 3);
+
+  /* Downstream sink runs out of space, reported at the latest by finish */
+  sink.length = 0;
+  sink.calls = 0;
+  sink.capacity = 32;
+
+  assert(vgg_platform_async_start(&async, &w, async_memory, sizeof(async_memory), 2, vgg_test_memory_sink_flush, &sink));
+  vgg_test_scene_write(&w);
+  assert(!vgg_platform_async_finish(&async, &w));
+  assert(async.failed);
+
+  /* Not enough memory for two buffers */
+  assert(!vgg_platform_async_start(&async, &w, async_memory, 1, 2, vgg_test_memory_sink_flush, &sink));
+}
+
+int vgg_test_contains(unsigned char *buffer, int length, char *s)
+{
+  int i;
+  int n = vgg_svg_strlen(s);
+
+  for (i = 0; i + n <= length; ++i)
+  {
+    if (vgg_test_bytes_equal(buffer + i, (unsigned char *)s, n))
+    {
+      return 1;
+    }
+  }
+  return 0;
+}
+
+void vgg_test_svg_element_add_fast_path(void)
+{
+  static unsigned char fast_buffer[4096];
+  static unsigned char checked_buffer[4096];
+
+  vgg_svg_writer fast = vgg_svg_writer_create(fast_buffer, 4096);
+  vgg_svg_writer checked = vgg_svg_writer_create(checked_buffer, 4096);
+
+  vgg_rect rect = {0};
+  double x[2] = {1e20, 5.0};
+  double y[2] = {-4e17, 6.0};
+
+  vgg_test_scene_write_with(&fast, vgg_svg_element_add);
+  vgg_test_scene_write_with(&checked, vgg_svg_element_add_checked);
+
+  assert(fast.length == checked.length);
+  assert(vgg_test_bytes_equal(fast.buffer, checked.buffer, checked.length));
+
+  /* The worst case of ordinary coordinates fits small chunk buffers */
+  rect.header.type = VGG_TYPE_RECT;
+  assert(vgg_svg_element_size_max(&rect.header) < 256);
+
+  /* Coordinates beyond 2^53 are written exactly through the checked path */
+  rect.x = 1e20;
+  rect.height = -4e17;
+  fast = vgg_svg_writer_create(fast_buffer, 4096);
+  checked = vgg_svg_writer_create(checked_buffer, 4096);
+  vgg_svg_element_add(&fast, &rect.header);
+  vgg_svg_element_add_checked(&checked, &rect.header);
+  assert(fast.length == checked.length);
+  assert(vgg_test_bytes_equal(fast.buffer, checked.buffer, checked.length));
+  assert(vgg_test_contains(fast.buffer, fast.length, "x=\"100000000000000000000\""));
+  assert(vgg_test_contains(fast.buffer, fast.length, "height=\"-400000000000000000\""));
+
+  vgg_svg_path_begin(&fast);
+  vgg_svg_path_move_to(&fast, x[0], y[0]);
+  vgg_svg_path_lines_to(&fast, 2, x, y);
+  vgg_svg_path_end(&fast, &rect.header);
+  assert(vgg_test_contains(fast.buffer, fast.length, "M100000000000000000000 -400000000000000000L100000000000000000000 -400000000000000000L5 6\""));
+}
+
+void vgg_test_svg_batch_add(void)
+{
+#define BATCH_COUNT 64
+  static unsigned char batch_buffer[16384];
+  static unsigned char single_buffer[16384];
+  static unsigned char chunk_buffer[2048];
+  static unsigned char sink_buffer[16384];
+
+  double a[BATCH_COUNT], b[BATCH_COUNT], c[BATCH_COUNT], d[BATCH_COUNT];
+  vgg_color colors[BATCH_COUNT];
+  unsigned int i;
+
+  vgg_svg_writer batch = vgg_svg_writer_create(batch_buffer, 16384);
+  vgg_svg_writer single = vgg_svg_writer_create(single_buffer, 16384);
+  vgg_svg_writer stream;
+  vgg_test_memory_sink sink = {0};
+
+  sink.data = sink_buffer;
+  sink.capacity = 16384;
+  stream = vgg_svg_writer_create_stream(chunk_buffer, 2048, vgg_test_memory_sink_flush, &sink);
+
+  for (i = 0; i < BATCH_COUNT; ++i)
+  {
+    a[i] = (double)i * 1.5;
+    b[i] = (double)i * -0.25;
+    c[i] = 10.0 + (double)i;
+    d[i] = 20.125;
+    colors[i].r = (int)(i * 4);
+    colors[i].g = 255 - (int)(i * 4);
+    colors[i].b = 128;
+  }
+
+  /* Coordinates beyond 2^53 go through the checked path inside a batch */
+  a[7] = 1e20;
+  d[9] = -4e17;
+
+  for (i = 0; i < BATCH_COUNT; ++i)
+  {
+    vgg_rect rect = {0};
+    vgg_circle circle = {0};
+    vgg_line line = {0};
+
+    rect.header.type = VGG_TYPE_RECT;
+    rect.header.id = 100 + i;
+    rect.header.color_fill = colors[i];
+    rect.x = a[i];
+    rect.y = b[i];
+    rect.width = c[i];
+    rect.height = d[i];
+    vgg_svg_element_add(&single, (vgg_header *)&rect);
+
+    circle.header.type = VGG_TYPE_CIRCLE;
+    circle.header.id = 200 + i;
+    circle.header.color_fill = colors[i];
+    circle.cx = a[i];
+    circle.cy = b[i];
+    circle.r = c[i];
+    vgg_svg_element_add(&single, (vgg_header *)&circle);
+
+    line.header.type = VGG_TYPE_LINE;
+    line.header.id = 300 + i;
+    line.x1 = a[i];
+    line.y1 = b[i];
+    line.x2 = c[i];
+    line.y2 = d[i];
+    vgg_svg_element_add(&single, (vgg_header *)&line);
+  }
+
+  /* Same output, element by element vs. column batches */
+  for (i = 0; i < BATCH_COUNT; ++i)
+  {
+    vgg_svg_rects_add(&batch, 1, 100 + i, &a[i], &b[i], &c[i], &d[i], &colors[i]);
+    vgg_svg_circles_add(&batch, 1, 200 + i, &a[i], &b[i], &c[i], &colors[i]);
+    vgg_svg_lines_add(&batch, 1, 300 + i, &a[i], &b[i], &c[i], &d[i], 0);
+  }
+
+  assert(!single.truncated);
+  assert(batch.length == single.length);
+  assert(vgg_test_bytes_equal(batch.buffer, single.buffer, single.length));
+
+  /* Whole columns through a small streaming buffer */
+  batch.length = 0;
+  vgg_svg_rects_add(&batch, BATCH_COUNT, 100, a, b, c, d, colors);
+  vgg_svg_rects_add(&stream, BATCH_COUNT, 100, a, b, c, d, colors);
+  vgg_svg_writer_flush(&stream);
+
+  assert(!stream.truncated);
+  assert(sink.length == batch.length);
+  assert(vgg_test_bytes_equal(sink.data, batch.buffer, batch.length));
+}
+
+void vgg_test_svg_path_builder(void)
+{
+  static unsigned char path_buffer[4096];
+  static unsigned char builder_buffer[4096];
+  static unsigned char chunk_buffer[1024];
+  static unsigned char sink_buffer[4096];
+
+  double x[3] = {10.5, 20.0, -0.25};
+  double y[3] = {1.0, -2.125, 3.0};
+  vgg_data_field data_field;
+  vgg_path path = {0};
+  vgg_svg_writer w_path = vgg_svg_writer_create(path_buffer, 4096);
+  vgg_svg_writer w_builder = vgg_svg_writer_create(builder_buffer, 4096);
+  int chunk_sizes[2] = {16, 1024};
+  char value_buffer[16];
+  int i;
+
+  data_field = vgg_data_field_create_int("series", 7, value_buffer);
+  path.header.type = VGG_TYPE_PATH;
+  path.header.id = 3;
+  path.header.color_fill.r = 255;
+  path.header.data_fields = &data_field;
+  path.header.data_fields_count = 1;
+  path.d = "M0 0L10.5 1L20 -2.125L-0.25 3C1 2 3 4 5 6.5Q1.001 2 3 4Z";
+
+  vgg_svg_element_add(&w_path, (vgg_header *)&path);
+
+  for (i = 0; i < 3; ++i)
+  {
+    vgg_svg_writer w;
+    vgg_test_memory_sink sink = {0};
+
+    sink.data = sink_buffer;
+    sink.capacity = 4096;
+
+    w = (i == 2) ? w_builder : vgg_svg_writer_create_stream(chunk_buffer, chunk_sizes[i], vgg_test_memory_sink_flush, &sink);
+
+    vgg_svg_path_begin(&w);
+    vgg_svg_path_move_to(&w, 0.0, 0.0);
+    vgg_svg_path_lines_to(&w, 3, x, y);
+    vgg_svg_path_cubic_to(&w, 1.0, 2.0, 3.0, 4.0, 5.0, 6.5);
+    vgg_svg_path_quad_to(&w, 1.001, 2.0, 3.0, 4.0);
+    vgg_svg_path_close(&w);
+    vgg_svg_path_end(&w, &path.header);
+    vgg_svg_writer_flush(&w);
+
+    assert(!w.truncated);
+    if (i == 2)
+    {
+      assert(w.length == w_path.length);
+      assert(vgg_test_bytes_equal(w.buffer, w_path.buffer, w_path.length));
+    }
+    else
+    {
+      assert(sink.length == w_path.length);
+      assert(vgg_test_bytes_equal(sink.data, w_path.buffer, w_path.length));
+    }
+  }
+}
+
+void vgg_test_simplify(void)
+{
+#define SIMPLIFY_COUNT 1000
+  static double x[SIMPLIFY_COUNT];
+  static double y[SIMPLIFY_COUNT];
+  static unsigned int stack[2 * SIMPLIFY_COUNT];
+  static unsigned char keep[SIMPLIFY_COUNT];
+  static unsigned char polyline_buffer[1024];
+  static unsigned char builder_buffer[1024];
+
+  vgg_svg_writer w_polyline = vgg_svg_writer_create(polyline_buffer, 1024);
+  vgg_svg_writer w_builder = vgg_svg_writer_create(builder_buffer, 1024);
+  vgg_header header = {0};
+  unsigned int i, n;
+
+  /* Noise below the tolerance around a tent with its peak at 500 */
+  for (i = 0; i < SIMPLIFY_COUNT; ++i)
+  {
+    x[i] = (double)i;
+    y[i] = (double)(i < 500 ? i : 1000 - i) + ((i & 1) ? 0.25 : -0.25);
+  }
+  n = vgg_simplify_rdp(x, y, SIMPLIFY_COUNT, 0.5, stack, keep, x, y);
+  assert(n == 3);
+  assert(x[0] == 0.0 && x[1] == 500.0 && x[2] == 999.0);
+
+  /* A tolerance of 0 keeps every point not exactly on the line */
+  for (i = 0; i < SIMPLIFY_COUNT; ++i)
+  {
+    x[i] = (double)i;
+    y[i] = (double)(i & 1);
+  }
+  assert(vgg_simplify_rdp(x, y, SIMPLIFY_COUNT, 0.0, stack, keep, x, y) == SIMPLIFY_COUNT);
+
+  /* 10 columns of 100 points: first, min, max and last of each */
+  for (i = 0; i < SIMPLIFY_COUNT; ++i)
+  {
+    x[i] = (double)i;
+    y[i] = (i % 100 == 25) ? -100.0 : ((i % 100 == 50) ? 100.0 : (double)(i % 7));
+  }
+  n = vgg_simplify_minmax(x, y, SIMPLIFY_COUNT, 0.0, 100.0, x, y);
+  assert(n == 40);
+  assert(x[0] == 0.0 && x[3] == 99.0 && x[39] == 999.0);
+  for (i = 0; i < n; i += 4)
+  {
+    assert(x[i + 1] == x[i] + 25.0 && x[i + 2] == x[i] + 50.0 && x[i + 3] == x[i] + 99.0);
+    assert(y[i + 1] == -100.0 && y[i + 2] == 100.0);
+  }
+
+  /* Single point columns pass through */
+  assert(vgg_simplify_minmax(x, y, 3, 0.0, 1.0, x, y) == 3);
+
+  header.type = VGG_TYPE_PATH;
+  vgg_svg_polyline_add(&w_polyline, &header, 4, x, y);
+  vgg_svg_path_begin(&w_builder);
+  vgg_svg_path_move_to(&w_builder, x[0], y[0]);
+  for (i = 1; i < 4; ++i)
+  {
+    vgg_svg_path_line_to(&w_builder, x[i], y[i]);
+  }
+  vgg_svg_path_end(&w_builder, &header);
+
+  assert(w_polyline.length == w_builder.length);
+  assert(vgg_test_bytes_equal(w_polyline.buffer, w_builder.buffer, w_builder.length));
+}
+
+void vgg_test_svg_style(void)
+{
+#define STYLE_COUNT 64
+  static unsigned char inline_buffer[8192];
+  static unsigned char style_buffer[8192];
+  static vgg_svg_style style;
+
+  vgg_color palette[2] = {{255, 0, 0}, {0, 0, 255}};
+  vgg_color colors[STYLE_COUNT];
+  double a[STYLE_COUNT];
+  vgg_svg_writer w_inline = vgg_svg_writer_create(inline_buffer, 8192);
+  vgg_svg_writer w_style = vgg_svg_writer_create(style_buffer, 8192);
+  vgg_circle circle = {0};
+  unsigned int i;
+
+  for (i = 0; i < STYLE_COUNT; ++i)
+  {
+    colors[i] = palette[i % 2];
+    a[i] = (double)i;
+  }
+
+  /* Palette registered up front is declared right after the svg start tag */
+  vgg_svg_style_init(&style);
+  assert(vgg_svg_style_intern(&style, palette[0]) == 0);
+  assert(vgg_svg_style_intern(&style, palette[1]) == 1);
+  assert(vgg_svg_style_intern(&style, palette[0]) == 0);
+
+  vgg_svg_start(&w_inline, "style", 100.0, 100.0);
+  vgg_svg_start(&w_style, "style", 100.0, 100.0);
+  vgg_svg_style_use(&w_style, &style);
+  assert(vgg_test_contains(w_style.buffer, w_style.length, "<style>.c0{fill:#FF0000}.c1{fill:#0000FF}</style>"));
+
+  vgg_svg_rects_add(&w_inline, STYLE_COUNT, 0, a, a, a, a, colors);
+  vgg_svg_rects_add(&w_style, STYLE_COUNT, 0, a, a, a, a, colors);
+
+  assert(vgg_test_contains(w_style.buffer, w_style.length, "id=\"0\" class=\"c0\" "));
+  assert(vgg_test_contains(w_style.buffer, w_style.length, "id=\"1\" class=\"c1\" "));
+  assert(!vgg_test_contains(w_style.buffer, w_style.length, "fill=\"#"));
+
+  /* Colors first seen while writing are declared before the closing tag */
+  circle.header.type = VGG_TYPE_CIRCLE;
+  circle.header.color_fill.g = 128;
+  circle.r = 1.0;
+  vgg_svg_element_add(&w_inline, (vgg_header *)&circle);
+  vgg_svg_element_add_checked(&w_style, (vgg_header *)&circle);
+  assert(vgg_test_contains(w_style.buffer, w_style.length, "class=\"c2\" "));
+
+  vgg_svg_end(&w_inline);
+  vgg_svg_end(&w_style);
+
+  assert(vgg_test_contains(w_style.buffer, w_style.length, "<style>.c2{fill:#008000}</style>\n</svg>"));
+  assert(!w_style.truncated);
+  assert(w_style.length < w_inline.length);
+}
+
+void vgg_test_bounds(void)
+{
+  vgg_bounds bounds = vgg_bounds_empty();
+  vgg_path path = {0};
+  vgg_text text = {0};
+
+  assert(vgg_bounds_path("M10 10L20 5h5v-3Z", &bounds));
+  assert(bounds.x0 == 10.0 && bounds.y0 == 2.0 && bounds.x1 == 25.0 && bounds.y1 == 10.0);
+
+  /* Relative commands, implicit line to and control points */
+  bounds = vgg_bounds_empty();
+  assert(vgg_bounds_path("m1,1 2,2 c0-10 5 0 5 0 z q1e1 1 0 0", &bounds));
+  assert(bounds.x0 == 1.0 && bounds.y0 == -7.0 && bounds.x1 == 11.0 && bounds.y1 == 3.0);
+
+  /* Arcs are padded conservatively */
+  bounds = vgg_bounds_empty();
+  assert(vgg_bounds_path("M0 0A5 5 0 0 1 10 0", &bounds));
+  assert(bounds.x0 <= -5.0 && bounds.y0 <= -5.0 && bounds.x1 >= 10.0 && bounds.y1 >= 5.0);
+
+  bounds = vgg_bounds_empty();
+  assert(!vgg_bounds_path("M0 0L", &bounds));
+  assert(!vgg_bounds_path("10 10", &bounds));
+
+  path.header.type = VGG_TYPE_PATH;
+  path.d = "M-1 -1L-0.5 -0.5";
+  assert(vgg_bounds_element((vgg_header *)&path, &bounds));
+  assert(bounds.x1 == -0.5);
+
+  text.header.type = VGG_TYPE_TEXT;
+  assert(!vgg_bounds_element((vgg_header *)&text, &bounds));
+}
+
+void vgg_test_svg_cull(void)
+{
+  static unsigned char binary_buffer[4096];
+
+  double x[3] = {10.0, 200.0, -20.0};
+  double y[3] = {10.0, 10.0, 10.0};
+  double size[3] = {5.0, 5.0, 25.0};
+  vgg_svg_writer w = vgg_svg_writer_create(binary_buffer, 4096);
+  vgg_circle circle = {0};
+  vgg_path path = {0};
+  double zero = 0.0;
+  int length;
+
+  vgg_svg_start(&w, "cull", 100.0, 100.0);
+  vgg_svg_cull(&w, 1);
+
+  /* Inside, right of the document, reaching in from the left */
+  vgg_svg_rects_add(&w, 3, 0, x, y, size, size, 0);
+  assert(w.culled == 1);
+  assert(vgg_test_contains(w.buffer, w.length, "id=\"0\""));
+  assert(!vgg_test_contains(w.buffer, w.length, "id=\"1\""));
+  assert(vgg_test_contains(w.buffer, w.length, "id=\"2\""));
+
+  vgg_svg_circles_add(&w, 3, 10, x, y, size, 0);
+  vgg_svg_lines_add(&w, 3, 20, x, y, x, size, 0);
+  assert(w.culled == 4);
+
+  circle.header.type = VGG_TYPE_CIRCLE;
+  circle.cx = 50.0;
+  circle.cy = -30.0;
+  circle.r = 20.0;
+  vgg_svg_element_add(&w, (vgg_header *)&circle);
+  assert(w.culled == 5);
+
+  path.header.type = VGG_TYPE_PATH;
+  path.d = "M50 110l10 10";
+  vgg_svg_element_add(&w, (vgg_header *)&path);
+  assert(w.culled == 6);
+
+  /* Path builder rolls back what it wrote */
+  length = w.length;
+  vgg_svg_path_begin(&w);
+  vgg_svg_path_move_to(&w, 150.0, 50.0);
+  vgg_svg_path_lines_to(&w, 3, x, y);
+  vgg_svg_path_end(&w, &path.header);
+  assert(w.culled == 6);
+  assert(w.length > length);
+
+  length = w.length;
+  vgg_svg_path_begin(&w);
+  vgg_svg_path_move_to(&w, 150.0, 50.0);
+  vgg_svg_path_cubic_to(&w, 160.0, 50.0, 170.0, 60.0, 180.0, 90.0);
+  vgg_svg_path_end(&w, &path.header);
+  assert(w.culled == 7);
+  assert(w.length == length);
+
+  /* Bounds with NaN coordinates overlap everything */
+  circle.cy = zero / zero;
+  vgg_svg_element_add(&w, (vgg_header *)&circle);
+  assert(w.culled == 7);
+  assert(w.length > length);
+  circle.cy = -30.0;
+
+  length = w.length;
+  vgg_svg_path_begin(&w);
+  vgg_svg_path_move_to(&w, zero / zero, zero / zero);
+  vgg_svg_path_line_to(&w, zero / zero, zero / zero);
+  vgg_svg_path_end(&w, &path.header);
+  assert(w.culled == 7);
+  assert(w.length > length);
+
+  length = w.length;
+  assert(vgg_svg_cull_box(&w, zero / zero, 10.0, zero / zero, 20.0) == 0);
+  assert(vgg_svg_cull_box(&w, 150.0, 10.0, 160.0, 20.0) == 1);
+  assert(w.culled == 8);
+
+  /* Culling off writes everything */
+  vgg_svg_cull(&w, 0);
+  vgg_svg_element_add(&w, (vgg_header *)&circle);
+  assert(w.culled == 8);
+  assert(w.length > length);
+}
+
+void vgg_test_grid(void)
+{
+#define GRID_COUNT 2000
+  static vgg_bounds bounds[GRID_COUNT];
+  static unsigned int cells[16 * 8 + 1];
+  static unsigned int items[GRID_COUNT];
+  static unsigned int found[GRID_COUNT];
+
+  vgg_grid grid;
+  vgg_bounds area = {0.0, 0.0, 1000.0, 500.0};
+  vgg_bounds views[4] = {{100.0, 100.0, 300.0, 200.0}, {-50.0, -50.0, 10.0, 10.0}, {990.0, 400.0, 2000.0, 2000.0}, {-1e9, -1e9, 1e9, 1e9}};
+  unsigned long seed = 12345;
+  unsigned int i, v, n, expected;
+  int matches;
+
+  /* Random rects, some outside the grid area */
+  for (i = 0; i < GRID_COUNT; ++i)
+  {
+    seed = (seed * 1103515245UL + 12345UL) & 0x7FFFFFFFUL;
+    bounds[i].x0 = (double)(seed % 1200) - 100.0;
+    seed = (seed * 1103515245UL + 12345UL) & 0x7FFFFFFFUL;
+    bounds[i].y0 = (double)(seed % 700) - 100.0;
+    bounds[i].x1 = bounds[i].x0 + (double)(seed % 40);
+    bounds[i].y1 = bounds[i].y0 + (double)(seed % 25);
+  }
+
+  vgg_grid_build(&grid, bounds, GRID_COUNT, area, 16, 8, cells, items);
+  assert(cells[16 * 8] == GRID_COUNT);
+
+  for (v = 0; v < 4; ++v)
+  {
+    n = vgg_grid_query(&grid, bounds, views[v], found);
+
+    /* Same elements in the same order as a full scan */
+    expected = 0;
+    matches = 1;
+    for (i = 0; i < GRID_COUNT; ++i)
+    {
+      if (vgg_bounds_overlap(&bounds[i], &views[v]))
+      {
+        matches &= (expected < n && found[expected] == i);
+        expected++;
+      }
+    }
+    assert(matches);
+    assert(n == expected);
+  }
+  assert(n == GRID_COUNT);
+}
+
+void vgg_test_bins(void)
+{
+  static unsigned char binned_buffer[4096];
+  static unsigned char expected_buffer[4096];
+  static unsigned int counts[10 * 5];
+  static double sums[10 * 5];
+  static double x[104], y[104], values[104];
+
+  vgg_svg_writer binned = vgg_svg_writer_create(binned_buffer, 4096);
+  vgg_svg_writer expected = vgg_svg_writer_create(expected_buffer, 4096);
+  vgg_color blue = {0, 0, 255};
+  vgg_color red = {255, 0, 0};
+  vgg_rect rect = {0};
+  vgg_bins bins;
+  vgg_bounds huge = {0.0, 0.0, 65536.0, 65536.0};
+  double zero = 0.0;
+  int i;
+
+  /* 100 x 50 canvas with 10 unit bins */
+  vgg_svg_start(&binned, "vgg_svg", 100, 50);
+  assert(vgg_bins_cells(binned.cull_viewport, 10.0) == 50);
+  assert(vgg_bins_cells(binned.cull_viewport, 30.0) == 4 * 2);
+  assert(vgg_bins_cells(huge, 1.0) == 0);
+  huge.y1 = 65535.0;
+  assert(vgg_bins_cells(huge, 1.0) == 65536UL * 65535UL);
+
+  vgg_bins_init(&bins, binned.cull_viewport, 10.0, counts, sums);
+  assert(bins.columns == 10 && bins.rows == 5);
+
+  for (i = 0; i < 100; ++i)
+  {
+    x[i] = 1.0 + (double)(i % 9);
+    y[i] = 2.5;
+    values[i] = 1.0;
+  }
+  x[100] = 95.0;
+  y[100] = 45.0;
+  values[100] = 7.0;
+  x[101] = 150.0; /* Outside the canvas */
+  y[101] = 5.0;
+  x[102] = zero / zero;
+  y[102] = 5.0;
+  x[103] = 100.0; /* On the right edge, outside the last bin */
+  y[103] = 5.0;
+
+  vgg_bins_add(&bins, x, y, values, 104);
+  assert(bins.points == 104 && bins.dropped == 3);
+  assert(counts[0] == 100 && counts[49] == 1);
+  assert(sums[0] == 100.0 && sums[49] == 7.0);
+
+  /* Densest bin gets color_end, one rect per non-empty bin */
+  assert(vgg_bins_write(&binned, &bins, VGG_TYPE_RECT, 0, blue, red, 10) == 2);
+
+  vgg_svg_start(&expected, "vgg_svg", 100, 50);
+  vgg_svg_header_init(&rect.header, VGG_TYPE_RECT, 10, &red);
+  rect.width = 10.0;
+  rect.height = 10.0;
+  vgg_svg_element_add(&expected, &rect.header);
+  vgg_svg_header_init(&rect.header, VGG_TYPE_RECT, 11, &blue);
+  rect.x = 90.0;
+  rect.y = 40.0;
+  vgg_svg_element_add(&expected, &rect.header);
+
+  assert(binned.length == expected.length);
+  assert(vgg_test_bytes_equal(binned.buffer, expected.buffer, expected.length));
+
+  /* Mean values swap the colors, circles are inscribed */
+  binned.length = 0;
+  assert(vgg_bins_write(&binned, &bins, VGG_TYPE_CIRCLE, 1, blue, red, 0) == 2);
+  assert(vgg_test_contains(binned.buffer, binned.length, "<circle cx=\"5\" cy=\"5\" r=\"5\" id=\"0\" fill=\"#0000FF\""));
+  assert(vgg_test_contains(binned.buffer, binned.length, "<circle cx=\"95\" cy=\"45\" r=\"5\" id=\"1\" fill=\"#FF0000\""));
+}
+
+static vgg_document vgg_test_document_scene;
+static int vgg_test_document_failed;
+
+void vgg_test_document_add(vgg_svg_writer *w, vgg_header *header)
+{
+  (void)w;
+  vgg_test_document_failed |= vgg_document_add(&vgg_test_document_scene, header) < 0;
+}
+
+void vgg_test_document(void)
+{
+  static unsigned char arena_memory[65536];
+  static unsigned char scratch_buffer[4096];
+  static unsigned char immediate_buffer[4096];
+  static unsigned char document_buffer[4096];
+  static unsigned char small_memory[64];
+
+  vgg_arena arena = vgg_arena_create(arena_memory, 65536);
+  vgg_arena small = vgg_arena_create(small_memory, 64);
+  vgg_svg_writer scratch = vgg_svg_writer_create(scratch_buffer, 4096);
+  vgg_svg_writer immediate = vgg_svg_writer_create(immediate_buffer, 4096);
+  vgg_svg_writer document = vgg_svg_writer_create(document_buffer, 4096);
+  vgg_document small_doc;
+  vgg_element element;
+  int i, length;
+
+  vgg_document_init(&vgg_test_document_scene, &arena);
+
+  /* Retained and immediate mode write the same bytes */
+  vgg_test_scene_write(&immediate);
+  vgg_test_scene_write_with(&scratch, vgg_test_document_add);
+  assert(vgg_test_document_scene.count == 6);
+
+  vgg_svg_start(&document, "vgg_svg", 400, 400);
+  vgg_document_write(&vgg_test_document_scene, &document);
+  vgg_svg_end(&document);
+
+  assert(document.length == immediate.length);
+  assert(vgg_test_bytes_equal(document.buffer, immediate.buffer, immediate.length));
+
+  /* Columns grow past their first capacity, elements keep their order and geometry */
+  for (i = 0; i < 20; ++i)
+  {
+    scratch.length = 0;
+    vgg_test_scene_write_with(&scratch, vgg_test_document_add);
+  }
+  assert(!vgg_test_document_failed);
+  assert(vgg_test_document_scene.count == 126);
+  assert(vgg_test_document_scene.shapes[VGG_TYPE_RECT].count == 21);
+  assert(!arena.exhausted);
+
+  vgg_document_element(&vgg_test_document_scene, 120, &element);
+  assert(element.header.type == VGG_TYPE_RECT && element.rect.x == 10.5 && element.header.data_fields_count == 2);
+  assert(vgg_test_string_equals(element.header.data_fields[1].key, "num_lines_of_code"));
+  vgg_document_element(&vgg_test_document_scene, 125, &element);
+  assert(element.header.type == VGG_TYPE_PATH && vgg_test_string_equals(element.path.d, "M10 10 L90 10 L90 90 Z"));
+
+  /* Repeated renders */
+  document.length = 0;
+  vgg_document_write(&vgg_test_document_scene, &document);
+  length = document.length;
+  document.length = 0;
+  vgg_document_write(&vgg_test_document_scene, &document);
+  assert(document.length == length);
+
+  /* A full arena is reported, not overrun */
+  vgg_document_init(&small_doc, &small);
+  scratch.length = 0;
+  vgg_svg_element_add(&scratch, (vgg_header *)&element);
+  assert(vgg_document_add(&small_doc, &element.header) == -1);
+  assert(small.exhausted);
+  assert(small.used <= 64);
+}
+
+static vgg_svg_writer vgg_test_scene_capture;
+
+void vgg_test_scene_capture_add(vgg_svg_writer *w, vgg_header *header)
+{
+  (void)w;
+  vgg_scene_add(&vgg_test_scene_capture, header);
+}
+
+void vgg_test_scene(void)
+{
+  static unsigned char scene_buffer[4096];
+  static unsigned char scratch_buffer[4096];
+  static unsigned char immediate_buffer[4096];
+  static unsigned char converted_buffer[4096];
+  static unsigned char chunk_buffer[24];
+  static unsigned char sink_buffer[4096];
+
+  vgg_svg_writer scratch = vgg_svg_writer_create(scratch_buffer, 4096);
+  vgg_svg_writer immediate = vgg_svg_writer_create(immediate_buffer, 4096);
+  vgg_svg_writer converted = vgg_svg_writer_create(converted_buffer, 4096);
+  vgg_test_memory_sink sink = {0};
+  vgg_data_field fields[1];
+  vgg_scene_reader reader;
+  vgg_element element;
+  vgg_rect rect = {0};
+  int length, count = 0;
+
+  vgg_test_scene_capture = vgg_svg_writer_create(scene_buffer, 4096);
+  vgg_test_scene_write(&immediate);
+
+  vgg_scene_start(&vgg_test_scene_capture, "vgg_svg", 400, 400);
+  vgg_test_scene_write_with(&scratch, vgg_test_scene_capture_add);
+  assert(vgg_scene_end(&vgg_test_scene_capture));
+  length = vgg_test_scene_capture.length;
+  assert(length % 4 == 0);
+
+  /* Converted scene is the same SVG as immediate mode */
+  assert(vgg_scene_convert(&converted, scene_buffer, (unsigned long)length));
+  assert(converted.length == immediate.length);
+  assert(vgg_test_bytes_equal(converted.buffer, immediate.buffer, immediate.length));
+
+  /* Fixed size records: a rect is 32 bytes */
+  scratch.length = 0;
+  rect.header.type = VGG_TYPE_RECT;
+  vgg_scene_add(&scratch, &rect.header);
+  assert(scratch.length == 32);
+
+  /* Records are walked in place, data fields beyond the array are counted */
+  assert(vgg_scene_open(&reader, scene_buffer, (unsigned long)length));
+  assert(vgg_test_string_equals(reader.id, "vgg_svg") && reader.width == 400.0);
+  while (vgg_scene_next(&reader, &element, fields, 1))
+  {
+    count++;
+  }
+  assert(count == 6);
+  assert(reader.offset == (unsigned long)length);
+  assert(reader.fields_dropped == 1);
+  assert(element.header.type == VGG_TYPE_PATH && vgg_test_string_equals(element.path.d, "M10 10 L90 10 L90 90 Z"));
+
+  /* Streamed capture through a small chunk buffer writes the same bytes */
+  sink.data = sink_buffer;
+  sink.capacity = 4096;
+  vgg_test_scene_capture = vgg_svg_writer_create_stream(chunk_buffer, 24, vgg_test_memory_sink_flush, &sink);
+  vgg_scene_start(&vgg_test_scene_capture, "vgg_svg", 400, 400);
+  vgg_test_scene_write_with(&scratch, vgg_test_scene_capture_add);
+  assert(vgg_scene_end(&vgg_test_scene_capture));
+  assert(sink.length == length);
+  assert(vgg_test_bytes_equal(sink_buffer, scene_buffer, length));
+
+  /* A cut off or foreign buffer is rejected */
+  converted.length = 0;
+  assert(!vgg_scene_convert(&converted, scene_buffer, (unsigned long)length - 4));
+  assert(!vgg_scene_convert(&converted, immediate_buffer, (unsigned long)immediate.length));
+}
+
+/* Sum of the red channel in pixels, 255 per fully covered pixel */
+double vgg_test_raster_red(vgg_raster *r)
+{
+  double sum = 0.0;
+  int i;
+
+  for (i = 0; i < r->width * r->height; ++i)
+  {
+    sum += (double)r->pixels[4 * i];
+  }
+  return sum / 255.0;
+}
+
+void vgg_test_raster(void)
+{
+  static unsigned char pixels[16 * 16 * 4];
+  static unsigned char path_pixels[16 * 16 * 4];
+  static float cells[VGG_RASTER_CELLS(16, 16)];
+  static unsigned char ppm_buffer[1024];
+
+  vgg_svg_writer ppm = vgg_svg_writer_create(ppm_buffer, 1024);
+  vgg_color black = {0, 0, 0};
+  vgg_color red = {255, 0, 0};
+  vgg_raster r;
+  vgg_rect rect = {0};
+  vgg_circle circle = {0};
+  vgg_path path = {0};
+  vgg_text text = {0};
+  double area;
+
+  rect.header.type = VGG_TYPE_RECT;
+  rect.header.color_fill = red;
+  circle.header.type = VGG_TYPE_CIRCLE;
+  circle.header.color_fill = red;
+  path.header.type = VGG_TYPE_PATH;
+  path.header.color_fill = red;
+  text.header.type = VGG_TYPE_TEXT;
+  text.text = "label";
+
+  /* Pixel aligned rect is opaque inside, half covered pixels get half the color */
+  vgg_raster_init(&r, pixels, cells, 16, 16, 16.0, 16.0);
+  vgg_raster_clear(&r, black);
+  rect.x = 2.0;
+  rect.y = 2.0;
+  rect.width = 4.0;
+  rect.height = 4.0;
+  vgg_raster_element(&r, &rect.header);
+  rect.x = 8.5;
+  rect.width = 1.0;
+  vgg_raster_element(&r, &rect.header);
+  assert(pixels[4 * (3 * 16 + 3)] == 255 && pixels[4 * (3 * 16 + 3) + 1] == 0 && pixels[4 * (3 * 16 + 3) + 3] == 255);
+  assert(pixels[4 * (3 * 16 + 6)] == 0);
+  assert(pixels[4 * (3 * 16 + 8)] == 127 && pixels[4 * (3 * 16 + 9)] == 127);
+
+  /* The same square as a path covers the same pixels */
+  vgg_raster_init(&r, path_pixels, cells, 16, 16, 16.0, 16.0);
+  vgg_raster_clear(&r, black);
+  path.d = "M2 2 L6 2 L6 6 L2 6 Z";
+  vgg_raster_element(&r, &path.header);
+  rect.x = 8.5;
+  vgg_raster_element(&r, &rect.header);
+  assert(vgg_test_bytes_equal(path_pixels, pixels, 16 * 16 * 4));
+
+  /* Anti-aliased circle covers its area, also when clipped by the framebuffer */
+  vgg_raster_clear(&r, black);
+  circle.cx = 8.0;
+  circle.cy = 8.0;
+  circle.r = 5.0;
+  vgg_raster_element(&r, &circle.header);
+  area = vgg_test_raster_red(&r);
+  assert(area > 3.14159 * 25.0 - 1.0 && area < 3.14159 * 25.0 + 1.0);
+  assert(path_pixels[4 * (8 * 16 + 8)] == 255 && path_pixels[0] == 0);
+
+  vgg_raster_clear(&r, black);
+  circle.cx = 0.0;
+  circle.cy = 0.0;
+  circle.r = 4.0;
+  vgg_raster_element(&r, &circle.header);
+  area = vgg_test_raster_red(&r);
+  assert(area > 3.14159 * 4.0 - 0.5 && area < 3.14159 * 4.0 + 0.5);
+
+  /* Document units are scaled to the framebuffer */
+  vgg_raster_init(&r, pixels, cells, 16, 16, 32.0, 32.0);
+  vgg_raster_clear(&r, black);
+  path.d = "m4 4 h8 v8 h-8 z M20 20 Q28 20 28 28 C24 28 20 24 20 20";
+  vgg_raster_element(&r, &path.header);
+  assert(pixels[4 * (3 * 16 + 3)] == 255 && pixels[4 * (7 * 16 + 7)] == 0);
+  assert(r.skipped == 0);
+
+  /* Text and unparsable paths are counted, not drawn */
+  path.d = "M1 1 L";
+  vgg_raster_element(&r, &path.header);
+  vgg_raster_element(&r, &text.header);
+  assert(r.skipped == 2);
+
+  /* PPM: header and one RGB triple per pixel */
+  vgg_raster_write_ppm(&r, &ppm);
+  assert(ppm.length == 13 + 16 * 16 * 3);
+  assert(vgg_test_bytes_equal(ppm.buffer, (unsigned char *)"P6\n16 16\n255\n", 13));
+  assert(ppm.buffer[13 + 3 * (3 * 16 + 3)] == 255);
+
+  /* Rects thinner than a pixel epsilon stay within their column, also at the start of the framebuffer */
+  vgg_raster_init(&r, pixels, cells, 16, 16, 16.0, 16.0);
+  vgg_raster_clear(&r, black);
+  vgg_raster_rect(&r, 0.0, 0.0, 1e-10, 4.0, red);
+  vgg_raster_rect(&r, 5.0, 0.0, 1e-10, 4.0, red);
+  assert(vgg_test_raster_red(&r) < 0.01);
+  assert(pixels[3] == 255 && pixels[4 * 16 - 1] == 255);
+
+  /* Huge coordinates whose differences overflow stay inside the framebuffer */
+  vgg_raster_clear(&r, black);
+  vgg_raster_line(&r, -1e308, 5.0, 1e308, 6.0, red);
+  assert(pixels[4 * (5 * 16 + 8)] > 0 && pixels[4 * (12 * 16 + 8)] == 0);
+
+  vgg_raster_clear(&r, black);
+  path.d = "M-1e308 5 L1e308 6 L0 10Z";
+  vgg_raster_element(&r, &path.header);
+  area = vgg_test_raster_red(&r);
+  assert(area > 0.0 && area <= 16.0 * 16.0);
+
+  vgg_raster_clear(&r, black);
+  circle.cx = 8.0;
+  circle.cy = 8.0;
+  circle.r = 1e308;
+  vgg_raster_element(&r, &circle.header);
+  circle.cx = -1e308;
+  circle.r = 1.7e308;
+  vgg_raster_element(&r, &circle.header);
+  vgg_raster_line(&r, 1e308, -1e308, -1e308, 1e308, red);
+  area = vgg_test_raster_red(&r);
+  assert(area >= 0.0 && area <= 16.0 * 16.0);
+}
+
+void vgg_test_document_render(void)
+{
+#define RENDER_COUNT 300
+  static unsigned char arena_memory[262144];
+  static unsigned char cache_buffer[65536];
+  static unsigned char full_buffer[65536];
+
+  vgg_arena arena = vgg_arena_create(arena_memory, 262144);
+  vgg_svg_writer cache = vgg_svg_writer_create(cache_buffer, 65536);
+  vgg_svg_writer full = vgg_svg_writer_create(full_buffer, 65536);
+  vgg_document doc;
+  vgg_element element;
+  unsigned long seed = 42;
+  unsigned int i, round;
+  int same = 1;
+
+  vgg_document_init(&doc, &arena);
+
+  for (i = 0; i < RENDER_COUNT; ++i)
+  {
+    vgg_rect rect = {0};
+    vgg_text text = {0};
+
+    rect.header.type = VGG_TYPE_RECT;
+    rect.header.id = i;
+    rect.x = (double)i;
+    rect.width = 1.0;
+    rect.height = 1.0;
+
+    text.header.type = VGG_TYPE_TEXT;
+    text.header.id = i;
+    text.text = "label";
+
+    vgg_document_add(&doc, (i % 10 == 9) ? (vgg_header *)&text : (vgg_header *)&rect);
+  }
+
+  assert(vgg_document_render(&doc, &cache));
+
+  for (round = 0; round < 20; ++round)
+  {
+    /* Fill changes keep the length, geometry and text changes do not */
+    for (i = 0; i < 10; ++i)
+    {
+      unsigned int index;
+      vgg_color color;
+
+      seed = (seed * 1103515245UL + 12345UL) & 0x7FFFFFFFUL;
+      index = (unsigned int)(seed % RENDER_COUNT);
+      color.r = (int)(seed & 0xFF);
+      color.g = 0;
+      color.b = 0;
+
+      vgg_document_element(&doc, index, &element);
+      if (round % 2 == 0)
+      {
+        vgg_document_set_fill(&doc, index, color);
+      }
+      else if (element.header.type == VGG_TYPE_RECT)
+      {
+        element.rect.x = (double)(seed % 100000) * 0.125;
+        element.rect.height = (double)(seed % 7);
+        vgg_document_set(&doc, index, &element.header);
+      }
+      else
+      {
+        element.text.text = (seed & 1) ? "" : "a longer label";
+        vgg_document_set(&doc, index, &element.header);
+      }
+    }
+
+    /* Touching an element twice keeps one entry */
+    vgg_document_set_fill(&doc, 0, element.header.color_fill);
+    vgg_document_set_fill(&doc, 0, element.header.color_fill);
+
+    if (round == 10)
+    {
+      vgg_document_add(&doc, &element.header);
+    }
+
+    same &= vgg_document_render(&doc, &cache);
+
+    full.length = 0;
+    vgg_document_write(&doc, &full);
+    same &= (cache.length == full.length) && vgg_test_bytes_equal(cache.buffer, full.buffer, full.length);
+  }
+  assert(same);
+  assert(doc.count == RENDER_COUNT + 1);
+
+  /* Type changes are refused */
+  element.header.type = VGG_TYPE_CIRCLE;
+  assert(!vgg_document_set(&doc, 0, &element.header));
+
+  /* A cache without spare room fails and renders everything on the next call */
+  vgg_document_set_fill(&doc, 5, element.header.color_fill);
+  cache.capacity = cache.length;
+  assert(!vgg_document_render(&doc, &cache));
+  assert(doc.dirty_count == 0);
+  cache.capacity = 65536;
+  assert(vgg_document_render(&doc, &cache));
+  assert(cache.length == full.length);
+  assert(vgg_test_bytes_equal(cache.buffer, full.buffer, full.length));
+}
+
+void vgg_test_document_update(void)
+{
+  static unsigned char arena_memory[16384];
+  static char long_label[512];
+
+  vgg_arena arena = vgg_arena_create(arena_memory, 16384);
+  vgg_document doc;
+  vgg_element element;
+  vgg_text text = {0};
+  vgg_data_field fields[2];
+  unsigned long used;
+  int i, reused = 1;
+
+  fields[0].key = "value";
+  fields[0].value = "10";
+  fields[1].key = "unit";
+  fields[1].value = "ms";
+
+  text.header.type = VGG_TYPE_TEXT;
+  text.header.data_fields = fields;
+  text.header.data_fields_count = 1;
+  text.text = "10 ms";
+
+  vgg_document_init(&doc, &arena);
+  assert(vgg_document_add(&doc, &text.header) == 0);
+
+  /* Live updates overwrite the strings in place, the arena does not grow */
+  text.header.data_fields_count = 2;
+  text.text = "1000 ms";
+  assert(vgg_document_set(&doc, 0, &text.header));
+  used = arena.used;
+
+  for (i = 0; i <= 10000; ++i)
+  {
+    fields[0].value = (i & 1) ? "7" : "1000";
+    text.header.data_fields_count = (i & 1) ? 1u : 2u;
+    text.text = (i & 1) ? "7 ms" : "1000 ms";
+    reused &= vgg_document_set(&doc, 0, &text.header);
+  }
+  assert(reused);
+  assert(arena.used == used);
+
+  vgg_document_element(&doc, 0, &element);
+  assert(vgg_test_string_equals(element.text.text, "1000 ms"));
+  assert(element.header.data_fields_count == 2 && vgg_test_string_equals(element.header.data_fields[0].value, "1000"));
+
+  /* A failed update leaves the element unchanged */
+  for (i = 0; i < 511; ++i)
+  {
+    long_label[i] = 'x';
+  }
+  vgg_document_element(&doc, 0, &element);
+  element.header.id = 99;
+  element.text.text = long_label;
+  arena.capacity = arena.used + 64;
+  assert(!vgg_document_set(&doc, 0, &element.header));
+  assert(arena.exhausted);
+
+  vgg_document_element(&doc, 0, &element);
+  assert(element.header.id == 0);
+  assert(vgg_test_string_equals(element.text.text, "1000 ms"));
+  assert(element.header.data_fields_count == 2 && vgg_test_string_equals(element.header.data_fields[1].key, "unit"));
+}
+
+void vgg_test_hash(void)
+{
+  vgg_hash a, b;
+  char hex_a[16], hex_b[16];
+
+  vgg_hash_init(&a);
+  vgg_hash_init(&b);
+  vgg_hash_string(&a, "M0 0L10 10");
+  vgg_hash_string(&b, "M0 0L10 10");
+  vgg_hash_hex(&a, hex_a);
+  vgg_hash_hex(&b, hex_b);
+  assert(vgg_test_bytes_equal((unsigned char *)hex_a, (unsigned char *)hex_b, 16));
+
+  /* One byte, trailing zero and order differences */
+  vgg_hash_init(&b);
+  vgg_hash_string(&b, "M0 0L10 11");
+  vgg_hash_hex(&b, hex_b);
+  assert(!vgg_test_bytes_equal((unsigned char *)hex_a, (unsigned char *)hex_b, 16));
+
+  vgg_hash_init(&a);
+  vgg_hash_init(&b);
+  vgg_hash_bytes(&a, "ab", 2);
+  vgg_hash_bytes(&b, "ab\0", 3);
+  vgg_hash_hex(&a, hex_a);
+  vgg_hash_hex(&b, hex_b);
+  assert(!vgg_test_bytes_equal((unsigned char *)hex_a, (unsigned char *)hex_b, 16));
+
+  vgg_hash_init(&a);
+  vgg_hash_init(&b);
+  vgg_hash_double(&a, 1.0);
+  vgg_hash_double(&a, 2.0);
+  vgg_hash_double(&b, 2.0);
+  vgg_hash_double(&b, 1.0);
+  vgg_hash_hex(&a, hex_a);
+  vgg_hash_hex(&b, hex_b);
+  assert(!vgg_test_bytes_equal((unsigned char *)hex_a, (unsigned char *)hex_b, 16));
+  assert(hex_a[0] >= '0' && hex_a[0] <= 'f');
+}
+
+void vgg_test_platform_cache(void)
+{
+  static unsigned char arena_memory[65536];
+  static unsigned char scratch_buffer[16384];
+  static unsigned char first_buffer[16384];
+  static unsigned char second_buffer[16384];
+  static unsigned char fragment_data[1000];
+
+  vgg_arena arena = vgg_arena_create(arena_memory, 65536);
+  vgg_svg_writer scratch = vgg_svg_writer_create(scratch_buffer, 16384);
+  vgg_svg_writer first = vgg_svg_writer_create(first_buffer, 16384);
+  vgg_svg_writer second = vgg_svg_writer_create(second_buffer, 16384);
+  vgg_platform_cache cache;
+  vgg_document doc;
+  vgg_rect rect = {0};
+  char key[VGG_PLATFORM_CACHE_KEY_SIZE + 1];
+  unsigned int i;
+  int bounded = 1;
+
+  assert(vgg_platform_cache_open(&cache, "test_cache", 4096));
+  vgg_platform_cache_clear(&cache);
+  assert(cache.size == 0);
+
+  vgg_document_init(&doc, &arena);
+  rect.header.type = VGG_TYPE_RECT;
+  rect.width = 2.0;
+  rect.height = 3.0;
+  for (i = 0; i < 50; ++i)
+  {
+    rect.header.id = i;
+    rect.x = (double)i;
+    vgg_document_add(&doc, &rect.header);
+  }
+
+  /* Miss renders and stores, hit returns the same bytes */
+  assert(!vgg_platform_cache_document(&cache, &doc, &first, &scratch));
+  assert(cache.misses == 1);
+  assert(first.length > 0);
+
+  assert(vgg_platform_cache_document(&cache, &doc, &second, &scratch));
+  assert(cache.hits == 1);
+  assert(cache.size == (unsigned long)first.length);
+  assert(second.length == first.length);
+  assert(vgg_test_bytes_equal(first.buffer, second.buffer, first.length));
+
+  /* Another element misses */
+  vgg_document_add(&doc, &rect.header);
+  assert(!vgg_platform_cache_document(&cache, &doc, &second, &scratch));
+  assert(cache.misses == 2);
+
+  /* A reopened cache finds the fragments of earlier runs */
+  assert(vgg_platform_cache_open(&cache, "test_cache", 4096));
+  assert(cache.size > (unsigned long)first.length);
+
+  /* Size stays bounded, the fragment just stored is kept */
+  for (i = 1; i < VGG_PLATFORM_CACHE_KEY_SIZE; ++i)
+  {
+    key[i] = '0';
+  }
+  key[VGG_PLATFORM_CACHE_KEY_SIZE] = '\0';
+
+  for (i = 0; i < 16; ++i)
+  {
+    vgg_platform_cache_fragment fragment;
+
+    key[0] = (char)('a' + i);
+    fragment_data[0] = (unsigned char)i;
+    bounded &= vgg_platform_cache_put(&cache, key, fragment_data, 1000);
+    bounded &= cache.size <= 4096;
+    bounded &= vgg_platform_cache_get(&cache, key, &fragment);
+    bounded &= fragment.size == 1000 && fragment.data[0] == (unsigned char)i;
+    vgg_platform_cache_release(&fragment);
+  }
+  assert(bounded);
+  assert(cache.evictions > 0);
+
+  /* A second cache in the same process writes the same key through its own temporary file */
+  {
+    vgg_platform_cache other;
+    vgg_platform_cache_fragment fragment;
+
+    assert(vgg_platform_cache_open(&other, "test_cache", 4096));
+    fragment_data[0] = 42;
+    assert(vgg_platform_cache_put(&other, key, fragment_data, 1000));
+    assert(vgg_platform_cache_put(&cache, key, fragment_data, 1000));
+    assert(other.temporaries == 1 && cache.temporaries > 1);
+    assert(vgg_platform_cache_get(&other, key, &fragment) && fragment.size == 1000 && fragment.data[0] == 42);
+    vgg_platform_cache_release(&fragment);
+  }
+
+  vgg_platform_cache_clear(&cache);
+}
+
+void vgg_test_platform_parallel(void)
+{
+#define PARALLEL_COUNT 2000
+  static vgg_element elements[PARALLEL_COUNT];
+  static vgg_header *headers[PARALLEL_COUNT];
+  static unsigned char serial_buffer[262144];
+  static unsigned char parallel_buffer[262144];
+  static unsigned char shard_memory[65536];
+  static unsigned char arena_memory[524288];
+  static vgg_data_field fields[1];
+
+  vgg_svg_writer serial = vgg_svg_writer_create(serial_buffer, 262144);
+  vgg_svg_writer parallel = vgg_svg_writer_create(parallel_buffer, 262144);
+  vgg_arena arena = vgg_arena_create(arena_memory, 524288);
+  vgg_document doc;
+  unsigned int i, threads;
+  int same = 1;
+
+  fields[0].key = "series";
+  fields[0].value = "temperature";
+
+  vgg_document_init(&doc, &arena);
+  for (i = 0; i < PARALLEL_COUNT; ++i)
+  {
+    vgg_element *element = &elements[i];
+
+    element->header.id = i;
+    element->header.color_fill.r = (int)(i & 0xFF);
+    if (i % 4 == 0)
+    {
+      element->header.type = VGG_TYPE_RECT;
+      element->rect.x = (double)i * 0.5;
+      element->rect.width = 1.5;
+      element->rect.height = (double)(i % 17);
+    }
+    else if (i % 4 == 1)
+    {
+      element->header.type = VGG_TYPE_CIRCLE;
+      element->circle.cx = (double)i;
+      element->circle.r = 2.25;
+      element->header.data_fields = fields;
+      element->header.data_fields_count = 1;
+    }
+    else if (i % 4 == 2)
+    {
+      element->header.type = VGG_TYPE_TEXT;
+      element->text.x = (double)i;
+      element->text.text = "label";
+    }
+    else
+    {
+      element->header.type = VGG_TYPE_PATH;
+      element->path.d = "M0 0L10 10";
+    }
+    headers[i] = &element->header;
+    vgg_document_add(&doc, headers[i]);
+  }
+
+  /* Small shard memory forces several rounds and shards that run out of room */
+  for (i = 0; i < PARALLEL_COUNT; ++i)
+  {
+    vgg_svg_element_add(&serial, headers[i]);
+  }
+  for (threads = 1; threads <= 8; threads *= 2)
+  {
+    parallel.length = 0;
+    vgg_platform_parallel_elements_add(&parallel, headers, PARALLEL_COUNT, threads, shard_memory, 65536);
+    same &= (parallel.length == serial.length) && vgg_test_bytes_equal(parallel.buffer, serial.buffer, serial.length);
+
+    parallel.length = 0;
+    vgg_platform_parallel_document_write(&parallel, &doc, threads, shard_memory, 65536);
+    same &= (parallel.length == serial.length) && vgg_test_bytes_equal(parallel.buffer, serial.buffer, serial.length);
+  }
+  assert(same);
+
+  /* Culling counts sum up over the shards */
+  serial.length = 0;
+  vgg_svg_cull(&serial, 1);
+  serial.cull_viewport.x1 = 500.0;
+  serial.cull_viewport.y1 = 500.0;
+  vgg_document_write(&doc, &serial);
+
+  parallel.length = 0;
+  vgg_svg_cull(&parallel, 1);
+  parallel.cull_viewport = serial.cull_viewport;
+  vgg_platform_parallel_document_write(&parallel, &doc, 4, shard_memory, 4096);
+  assert(serial.culled > 0);
+  assert(parallel.culled == serial.culled);
+  assert(parallel.length == serial.length);
+  assert(vgg_test_bytes_equal(parallel.buffer, serial.buffer, serial.length));
+}
+
+void vgg_test_svg_write_truncated(void)
+{
+  static unsigned char binary_buffer[16];
+
+  vgg_svg_writer w = vgg_svg_writer_create(binary_buffer, 16);
+
+  vgg_test_scene_write(&w);
+
+  assert(w.truncated);
+  assert(w.length == 16);
+  assert(!vgg_svg_writer_flush(&w));
+}
+
+void vgg_test_svg_stats(void)
+{
+  static unsigned char fixed_buffer[4096];
+  static unsigned char small_buffer[100];
+  static unsigned char chunk_buffer[64];
+  static unsigned char sink_buffer[4096];
+
+  vgg_svg_writer fixed = vgg_svg_writer_create(fixed_buffer, 4096);
+  vgg_svg_writer small = vgg_svg_writer_create(small_buffer, 100);
+  vgg_svg_writer stream;
+  vgg_svg_writer batch = vgg_svg_writer_create(fixed_buffer, 4096);
+  vgg_test_memory_sink sink = {0};
+  vgg_header header = {0};
+  double x[3] = {10.0, 900.0, 30.0};
+  double y[3] = {10.0, 900.0, 30.0};
+  double r[3] = {5.0, 5.0, 5.0};
+  unsigned long element_bytes = 0;
+  int i;
+
+  vgg_test_scene_write(&fixed);
+  for (i = VGG_TYPE_RECT; i <= VGG_TYPE_PATH; ++i)
+  {
+    element_bytes += fixed.stats.bytes[i];
+  }
+  assert(fixed.stats.elements[VGG_TYPE_RECT] == 1);
+  assert(fixed.stats.elements[VGG_TYPE_PATH] == 1);
+  assert(fixed.stats.bytes[VGG_TYPE_CIRCLE] == (unsigned long)vgg_svg_strlen("  <circle cx=\"200\" cy=\"200\" r=\"100\" id=\"2\" fill=\"#FF0000\" />\n"));
+  assert(element_bytes > 0 && element_bytes < (unsigned long)fixed.length);
+  assert(fixed.stats.high_water == fixed.length);
+  assert(fixed.stats.dropped == 0);
+  assert(fixed.stats.flushes == 0);
+
+  /* Everything beyond the capacity is counted as dropped */
+  vgg_test_scene_write(&small);
+  assert(small.truncated);
+  assert(small.stats.high_water == 100);
+  assert(small.stats.dropped == (unsigned long)fixed.length - 100);
+  assert(small.stats.elements[VGG_TYPE_TEXT] == 1);
+
+  sink.data = sink_buffer;
+  sink.capacity = 4096;
+  stream = vgg_svg_writer_create_stream(chunk_buffer, 64, vgg_test_memory_sink_flush, &sink);
+  vgg_test_scene_write(&stream);
+  assert(stream.stats.flushed == (unsigned long)fixed.length);
+  assert(stream.stats.flushes == (unsigned long)sink.calls);
+  assert(stream.stats.high_water <= 64);
+  assert(stream.stats.bytes[VGG_TYPE_CIRCLE] == fixed.stats.bytes[VGG_TYPE_CIRCLE]);
+
+  /* Culled batch elements are not counted */
+  vgg_svg_start(&batch, "stats", 100, 100);
+  vgg_svg_cull(&batch, 1);
+  vgg_svg_circles_add(&batch, 3, 0, x, y, r, 0);
+  vgg_svg_path_begin(&batch);
+  vgg_svg_path_move_to(&batch, 500.0, 500.0);
+  vgg_svg_path_line_to(&batch, 600.0, 600.0);
+  vgg_svg_path_end(&batch, &header);
+  assert(batch.culled == 2);
+  assert(batch.stats.elements[VGG_TYPE_CIRCLE] == 2);
+  assert(batch.stats.elements[VGG_TYPE_PATH] == 0);
+}
+
+/* Batches, rounding edge cases, culling and the path builder */
+void vgg_test_measure_document(vgg_svg_writer *w, vgg_svg_style *style)
+{
+  double x[4] = {-0.0004, 12345678901.5, 2.5e20, 0.1235};
+  double y[4] = {1.0005, -3.25, 7.0, 0.0};
+  double r[4] = {1.0, 2.0, 3.0, 40.0};
+  vgg_color colors[4] = {{1, 2, 3}, {4, 5, 6}, {1, 2, 3}, {7, 8, 9}};
+  vgg_header header = {0};
+
+  vgg_svg_start(w, "measure", 100.0, 100.0);
+  if (style)
+  {
+    vgg_svg_style_use(w, style);
+  }
+  vgg_svg_rects_add(w, 4, 0, x, y, r, r, colors);
+  vgg_svg_circles_add(w, 4, 10, x, y, r, 0);
+
+  vgg_svg_cull(w, 1);
+  vgg_svg_lines_add(w, 4, 20, x, y, r, r, colors);
+  vgg_svg_path_begin(w);
+  vgg_svg_path_move_to(w, x[0], y[0]);
+  vgg_svg_path_lines_to(w, 4, x, y);
+  vgg_svg_path_end(w, &header);
+  vgg_svg_path_begin(w);
+  vgg_svg_path_move_to(w, 500.0, 500.0);
+  vgg_svg_path_line_to(w, 600.0, 600.0);
+  vgg_svg_path_end(w, &header);
+  vgg_svg_end(w);
+}
+
+void vgg_test_svg_measure(void)
+{
+  static unsigned char fixed_buffer[8192];
+  static unsigned char reference_buffer[8192];
+  static vgg_svg_style fixed_style;
+  static vgg_svg_style measure_style;
+
+  double values[8] = {0.0, -0.0, 0.5, -2.0005, 999999999.9999, 4294967296.75, 1e300, 123.456789};
+  vgg_svg_writer fixed = vgg_svg_writer_create(fixed_buffer, 8192);
+  vgg_svg_writer measure = vgg_svg_writer_create_measure();
+  char buffer[VGG_FMT_DOUBLE_SIZE_MAX + 1];
+  double zero = 0.0;
+  vgg_color known = {7, 8, 9};
+  int precision, mismatches = 0;
+  unsigned int i;
+
+  vgg_test_scene_write(&fixed);
+  vgg_test_scene_write(&measure);
+  assert(measure.length == fixed.length);
+  assert(!measure.truncated);
+
+  fixed = vgg_svg_writer_create(fixed_buffer, 8192);
+  measure = vgg_svg_writer_create_measure();
+  vgg_test_measure_document(&fixed, 0);
+  vgg_test_measure_document(&measure, 0);
+  assert(!fixed.truncated);
+  assert(measure.culled == fixed.culled);
+  assert(measure.length == fixed.length);
+
+  /* Style interning changes the fill attribute and adds a <style> block */
+  vgg_svg_style_init(&fixed_style);
+  vgg_svg_style_init(&measure_style);
+  fixed = vgg_svg_writer_create(fixed_buffer, 8192);
+  measure = vgg_svg_writer_create_measure();
+  vgg_test_measure_document(&fixed, &fixed_style);
+  vgg_test_measure_document(&measure, &measure_style);
+  assert(measure.length == fixed.length);
+
+  /* The measuring pass leaves its style intact, the real pass reusing it writes the same bytes */
+  vgg_svg_style_init(&fixed_style);
+  vgg_svg_style_intern(&fixed_style, known);
+  fixed = vgg_svg_writer_create(reference_buffer, 8192);
+  vgg_test_measure_document(&fixed, &fixed_style);
+  vgg_svg_style_init(&measure_style);
+  vgg_svg_style_intern(&measure_style, known);
+  measure = vgg_svg_writer_create_measure();
+  vgg_test_measure_document(&measure, &measure_style);
+  assert(measure.length == fixed.length);
+  fixed = vgg_svg_writer_create(fixed_buffer, measure.length);
+  vgg_test_measure_document(&fixed, &measure_style);
+  assert(!fixed.truncated);
+  assert(fixed.length == measure.length);
+  assert(vgg_test_bytes_equal(fixed_buffer, reference_buffer, fixed.length));
+
+  /* Size without formatting matches the formatted length, NaN and infinity included */
+  values[1] = zero / zero;
+  values[6] = 1.0 / zero;
+  for (precision = 0; precision <= VGG_FMT_PRECISION_MAX; ++precision)
+  {
+    for (i = 0; i < 8 * 2; ++i)
+    {
+      double d = values[i / 2];
+      int trim = (int)(i & 1);
+      mismatches += vgg_fmt_double_size(d, precision, trim) != (int)(vgg_fmt_double(buffer, d, precision, trim) - buffer);
+      mismatches += vgg_fmt_double_size(-d, precision, trim) != (int)(vgg_fmt_double(buffer, -d, precision, trim) - buffer);
+    }
+  }
+  assert(mismatches == 0);
+}
+
+void vgg_test_svg_write_stream_file(void)
+{
+  static unsigned char chunk_buffer[64];
+
+  vgg_platform_stream file;
+  vgg_svg_writer w;
+
+  assert(vgg_platform_stream_open(&file, "test_stream.svg"));
+
+  w = vgg_svg_writer_create_stream(chunk_buffer, 64, vgg_platform_stream_sink, &file);
+
+  vgg_test_scene_write(&w);
+
+  assert(vgg_svg_writer_flush(&w));
+  assert(vgg_platform_stream_close(&file));
+}
+
+#ifndef _WIN32
+/* Reads a whole file back, -1 if it does not exist */
+int vgg_test_read_file(char *filename, unsigned char *buffer, int capacity)
+{
+  int fd = open(filename, O_RDONLY);
+  int length = 0;
+  ssize_t n;
+
+  if (fd < 0)
+  {
+    return -1;
+  }
+  while ((n = read(fd, buffer + length, (size_t)(capacity - length))) > 0)
+  {
+    length += (int)n;
+  }
+  close(fd);
+  return length;
+}
+#endif
+
+void vgg_test_platform_gather(void)
+{
+#define GATHER_FRAGMENTS 1100
+  static unsigned char writer_buffer[131072];
+  static unsigned char expected_buffer[131072];
+  static unsigned char read_buffer[131072];
+  static vgg_platform_span spans[2 * GATHER_FRAGMENTS + 2];
+  static unsigned char fragment[] = "<rect x=\"1\" y=\"2\" width=\"3\" height=\"4\"/>\n";
+
+  vgg_svg_writer w = vgg_svg_writer_create(writer_buffer, 131072);
+  vgg_svg_writer expected = vgg_svg_writer_create(expected_buffer, 131072);
+  vgg_platform_gather gather;
+  vgg_platform_stream file;
+  vgg_circle circle = {0};
+  unsigned int i;
+  int gathered = 1;
+
+  circle.header.type = VGG_TYPE_CIRCLE;
+  circle.r = 1.5;
+
+  /* Writer pieces between shared fragments, more spans than one writev takes */
+  vgg_platform_gather_init(&gather, spans, 2 * GATHER_FRAGMENTS + 2, &w);
+  vgg_svg_start(&w, "vgg_svg", 10, 10);
+  vgg_svg_start(&expected, "vgg_svg", 10, 10);
+  for (i = 0; i < GATHER_FRAGMENTS; ++i)
+  {
+    circle.header.id = i;
+    vgg_svg_element_add(&w, &circle.header);
+    vgg_svg_element_add(&expected, &circle.header);
+    gathered &= vgg_platform_gather_fragment(&gather, fragment, (unsigned long)(sizeof(fragment) - 1));
+    vgg_svg_putn(&expected, (char *)fragment, (int)(sizeof(fragment) - 1));
+  }
+  vgg_svg_end(&w);
+  vgg_svg_end(&expected);
+  assert(gathered);
+  assert(!expected.truncated);
+
+  assert(vgg_platform_stream_open(&file, "test_gather.svg"));
+  assert(vgg_platform_gather_write(&gather, &file));
+  assert(vgg_platform_stream_close(&file));
+  assert(gather.count == 2 * GATHER_FRAGMENTS + 1);
+
+  /* Full spans are reported */
+  vgg_platform_gather_init(&gather, spans, 1, &w);
+  vgg_svg_putc(&w, 'a');
+  assert(!vgg_platform_gather_fragment(&gather, fragment, 1));
+
+#ifndef _WIN32
+  assert(vgg_test_read_file("test_gather.svg", read_buffer, 131072) == expected.length);
+  assert(vgg_test_bytes_equal(read_buffer, expected.buffer, expected.length));
+#else
+  (void)read_buffer;
+#endif
+}
+
+/* Several pages of output */
+void vgg_test_atomic_scene(vgg_svg_writer *w)
+{
+  vgg_circle circle = {0};
+  unsigned int i;
+
+  circle.header.type = VGG_TYPE_CIRCLE;
+  vgg_svg_start(w, "vgg_svg", 100, 100);
+  for (i = 0; i < 1000; ++i)
+  {
+    circle.header.id = i;
+    circle.cx = (double)i * 0.125;
+    circle.r = 3.0;
+    vgg_svg_element_add(w, &circle.header);
+  }
+  vgg_svg_end(w);
+}
+
+void vgg_test_platform_atomic(void)
+{
+  static unsigned char expected_buffer[131072];
+  static unsigned char chunk_buffer[1000];
+  static unsigned char read_buffer[131072];
+
+  vgg_svg_writer expected = vgg_svg_writer_create(expected_buffer, 131072);
+  vgg_platform_atomic atomic;
+  vgg_svg_writer w;
+
+  vgg_test_atomic_scene(&expected);
+  assert(vgg_platform_write("test_atomic.svg", (unsigned char *)"old", 3));
+
+  /* Chunked writes, the target keeps its old content until commit */
+  assert(vgg_platform_atomic_open(&atomic, "test_atomic.svg", 100000, VGG_PLATFORM_SYNC_DIRECTORY));
+  w = vgg_svg_writer_create_stream(chunk_buffer, 1000, vgg_platform_atomic_sink, &atomic);
+  vgg_test_atomic_scene(&w);
+  assert(vgg_svg_writer_flush(&w));
+#ifndef _WIN32
+  assert(vgg_test_read_file("test_atomic.svg", read_buffer, 131072) == 3);
+#endif
+  assert(vgg_platform_atomic_commit(&atomic));
+#ifndef _WIN32
+  assert(vgg_test_read_file("test_atomic.svg", read_buffer, 131072) == expected.length);
+  assert(vgg_test_bytes_equal(read_buffer, expected.buffer, expected.length));
+  assert(vgg_test_read_file(atomic.path_temporary, read_buffer, 131072) == -1);
+#endif
+
+  /* Aborted output leaves the target alone */
+  assert(vgg_platform_atomic_open(&atomic, "test_atomic.svg", 0, VGG_PLATFORM_SYNC_NONE));
+  assert(vgg_platform_atomic_write(&atomic, (unsigned char *)"partial", 7));
+  vgg_platform_atomic_abort(&atomic);
+  assert(vgg_platform_write_atomic("test_atomic_small.svg", (unsigned char *)"small", 5, VGG_PLATFORM_SYNC_FILE));
+
+#ifndef _WIN32
+  assert(vgg_test_read_file("test_atomic.svg", read_buffer, 131072) == expected.length);
+  assert(vgg_test_read_file(atomic.path_temporary, read_buffer, 131072) == -1);
+  assert(vgg_test_read_file("test_atomic_small.svg", read_buffer, 131072) == 5);
+
+  /* Formatted straight into one page windows of the file, preallocation larger than the output is cut */
+  assert(vgg_platform_atomic_open(&atomic, "test_atomic.svg", 200000, VGG_PLATFORM_SYNC_FILE));
+  assert(vgg_platform_atomic_map(&atomic, &w, 1));
+  vgg_test_atomic_scene(&w);
+  assert(vgg_svg_writer_flush(&w));
+  assert(!w.truncated);
+  assert(vgg_platform_atomic_commit(&atomic));
+  assert(vgg_test_read_file("test_atomic.svg", read_buffer, 131072) == expected.length);
+  assert(vgg_test_bytes_equal(read_buffer, expected.buffer, expected.length));
+
+  /* Concurrent writers of one target use their own temporary files, the target keeps its permissions */
+  {
+    vgg_platform_atomic second;
+    struct stat info;
+
+    assert(chmod("test_atomic.svg", 0600) == 0);
+    assert(vgg_platform_atomic_open(&atomic, "test_atomic.svg", 0, VGG_PLATFORM_SYNC_NONE));
+    assert(vgg_platform_atomic_open(&second, "test_atomic.svg", 0, VGG_PLATFORM_SYNC_NONE));
+    assert(!vgg_test_string_equals(atomic.path_temporary, second.path_temporary));
+    assert(vgg_platform_atomic_write(&atomic, (unsigned char *)"first", 5));
+    assert(vgg_platform_atomic_write(&second, (unsigned char *)"second!", 7));
+    assert(vgg_platform_atomic_commit(&atomic));
+    assert(vgg_platform_atomic_commit(&second));
+    assert(vgg_test_read_file("test_atomic.svg", read_buffer, 131072) == 7);
+    assert(stat("test_atomic.svg", &info) == 0 && (info.st_mode & 0777) == 0600);
+    assert(chmod("test_atomic.svg", 0644) == 0);
+  }
+#else
+  (void)read_buffer;
+#endif
+}
+
+/* Minimal inflate for fixed Huffman blocks, checks vgg_gzip output */
+typedef struct vgg_test_inflate
+{
+  unsigned char *data;
+  unsigned long size;
+  unsigned long bit;
+
+} vgg_test_inflate;
+
+unsigned int vgg_test_inflate_bits(vgg_test_inflate *in, int count)
+{
+  unsigned int value = 0;
+  int i;
+
+  for (i = 0; i < count && (in->bit >> 3) < in->size; ++i, ++in->bit)
+  {
+    value |= (unsigned int)((in->data[in->bit >> 3] >> (in->bit & 7)) & 1) << i;
+  }
+  return value;
+}
+
+/* Huffman codes are stored most significant bit first */
+unsigned int vgg_test_inflate_symbol(vgg_test_inflate *in)
+{
+  unsigned int code = 0;
+  int i;
+
+  for (i = 0; i < 7; ++i)
+  {
+    code = (code << 1) | vgg_test_inflate_bits(in, 1);
+  }
+  if (code <= 23)
+  {
+    return 256 + code;
+  }
+  code = (code << 1) | vgg_test_inflate_bits(in, 1);
+  if (code >= 0x30 && code <= 0xBF)
+  {
+    return code - 0x30;
+  }
+  if (code >= 0xC0 && code <= 0xC7)
+  {
+    return 280 + code - 0xC0;
+  }
+  code = (code << 1) | vgg_test_inflate_bits(in, 1);
+  return 144 + code - 0x190;
+}
+
+/* Returns the inflated size or -1 */
+long vgg_test_gunzip(unsigned char *data, unsigned long size, unsigned char *out, unsigned long capacity)
+{
+  static const unsigned short length_base[29] = {3, 4, 5, 6, 7, 8, 9, 10, 11, 13, 15, 17, 19, 23, 27, 31, 35, 43, 51, 59, 67, 83, 99, 115, 131, 163, 195, 227, 258};
+  static const unsigned char length_extra[29] = {0, 0, 0, 0, 0, 0, 0, 0, 1, 1, 1, 1, 2, 2, 2, 2, 3, 3, 3, 3, 4, 4, 4, 4, 5, 5, 5, 5, 0};
+  static const unsigned short distance_base[30] = {1, 2, 3, 4, 5, 7, 9, 13, 17, 25, 33, 49, 65, 97, 129, 193, 257, 385, 513, 769, 1025, 1537, 2049, 3073, 4097, 6145, 8193, 12289, 16385, 24577};
+  static const unsigned char distance_extra[30] = {0, 0, 0, 0, 1, 1, 2, 2, 3, 3, 4, 4, 5, 5, 6, 6, 7, 7, 8, 8, 9, 9, 10, 10, 11, 11, 12, 12, 13, 13};
+
+  vgg_test_inflate in;
+  unsigned long length = 0, i, trailer;
+  unsigned int final = 0;
+
+  if (size < 18 || data[0] != 0x1F || data[1] != 0x8B || data[2] != 8 || data[3] != 0)
+  {
+    return -1;
+  }
+
+  in.data = data + 10;
+  in.size = size - 18;
+  in.bit = 0;
+
+  while (!final)
+  {
+    final = vgg_test_inflate_bits(&in, 1);
+    if (vgg_test_inflate_bits(&in, 2) != 1)
+    {
+      return -1;
+    }
+
+    for (;;)
+    {
+      unsigned int symbol = vgg_test_inflate_symbol(&in);
+      unsigned long match, distance;
+
+      if (symbol < 256)
+      {
+        if (length >= capacity)
+        {
+          return -1;
+        }
+        out[length++] = (unsigned char)symbol;
+        continue;
+      }
+      if (symbol == 256)
+      {
+        break;
+      }
+      if (symbol > 285)
+      {
+        return -1;
+      }
+
+      match = length_base[symbol - 257] + vgg_test_inflate_bits(&in, length_extra[symbol - 257]);
+      symbol = vgg_test_inflate_bits(&in, 5);
+      symbol = ((symbol & 1) << 4) | ((symbol & 2) << 2) | (symbol & 4) | ((symbol & 8) >> 2) | ((symbol & 16) >> 4);
+      if (symbol > 29)
+      {
+        return -1;
+      }
+      distance = distance_base[symbol] + vgg_test_inflate_bits(&in, distance_extra[symbol]);
+      if (distance > length || length + match > capacity)
+      {
+        return -1;
+      }
+      for (i = 0; i < match; ++i, ++length)
+      {
+        out[length] = out[length - distance];
+      }
+    }
+  }
+
+  /* Size modulo 2^32 in the trailer */
+  trailer = (unsigned long)data[size - 4] | ((unsigned long)data[size - 3] << 8) | ((unsigned long)data[size - 2] << 16) | ((unsigned long)data[size - 1] << 24);
+  return (trailer == length && (in.bit + 7) / 8 == in.size) ? (long)length : -1;
+}
+
+void vgg_test_gzip(void)
+{
+  static unsigned char plain_buffer[262144];
+  static unsigned char chunk_buffer[1000];
+  static unsigned char compressed_buffer[262144];
+  static unsigned char inflated[262144];
+  static vgg_gzip gz;
+
+  vgg_svg_writer plain = vgg_svg_writer_create(plain_buffer, 262144);
+  vgg_svg_writer compressed, w;
+  vgg_rect rect = {0};
+  unsigned long crc;
+  unsigned int i;
+  int level;
+
+  rect.header.type = VGG_TYPE_RECT;
+  vgg_svg_start(&plain, "vgg_svg", 1000, 1000);
+  for (i = 0; i < 3000; ++i)
+  {
+    rect.header.id = i;
+    rect.header.color_fill.r = (int)(i * 7 % 256);
+    rect.x = (double)(i % 100) * 1.5;
+    rect.y = (double)(i / 100) * 2.25;
+    rect.width = 1.5;
+    rect.height = (double)(i % 13);
+    vgg_svg_element_add(&plain, &rect.header);
+  }
+  vgg_svg_end(&plain);
+  assert(!plain.truncated);
+
+  for (level = VGG_GZIP_LEVEL_FAST; level <= VGG_GZIP_LEVEL_BEST; ++level)
+  {
+    long size;
+
+    /* Streamed in odd chunks through the sink */
+    compressed = vgg_svg_writer_create(compressed_buffer, 262144);
+    vgg_gzip_init(&gz, &compressed, level);
+    w = vgg_svg_writer_create_stream(chunk_buffer, 1000, vgg_gzip_sink, &gz);
+    vgg_svg_putn(&w, (char *)plain.buffer, plain.length);
+    assert(vgg_svg_writer_flush(&w));
+    assert(vgg_gzip_finish(&gz));
+
+    assert(compressed.length < plain.length / 4);
+    size = vgg_test_gunzip(compressed.buffer, (unsigned long)compressed.length, inflated, 262144);
+    assert(size == (long)plain.length);
+    assert(vgg_test_bytes_equal(inflated, plain.buffer, plain.length));
+
+    crc = vgg_gzip_crc32(gz.crc_table, 0, plain.buffer, (unsigned long)plain.length);
+    assert(compressed.buffer[compressed.length - 8] == (unsigned char)(crc & 0xFF));
+    assert(compressed.buffer[compressed.length - 5] == (unsigned char)((crc >> 24) & 0xFF));
+  }
+
+  /* Known CRC-32 check value and an empty member */
+  assert(vgg_gzip_crc32(gz.crc_table, 0, (unsigned char *)"123456789", 9) == 0xCBF43926UL);
+  compressed = vgg_svg_writer_create(compressed_buffer, 262144);
+  vgg_gzip_init(&gz, &compressed, VGG_GZIP_LEVEL_FAST);
+  assert(vgg_gzip_finish(&gz));
+  assert(vgg_test_gunzip(compressed.buffer, (unsigned long)compressed.length, inflated, 262144) == 0);
+}
+
 int main(void)
 {
   vgg_test_data_field();
+  vgg_test_itoa();
+  vgg_test_ftoa();
+  vgg_test_svg_put_double();
   vgg_test_color_map_linear();
+  vgg_test_color_map_linear_batch();
+  vgg_test_colormap();
   vgg_test_svg_write_rect();
   vgg_test_svg_write_circle();
-vgg_test_svg_write_text();
+  vgg_test_svg_write_text();
+  vgg_test_svg_write_stream();
+  vgg_test_svg_write_stream_failed();
+  vgg_test_platform_async();
+  vgg_test_svg_element_add_fast_path();
+  vgg_test_svg_batch_add();
+  vgg_test_svg_path_builder();
+  vgg_test_simplify();
+  vgg_test_svg_style();
+  vgg_test_bounds();
+  vgg_test_svg_cull();
+  vgg_test_grid();
+  vgg_test_bins();
+  vgg_test_document();
+  vgg_test_document_render();
+  vgg_test_document_update();
+  vgg_test_scene();
+  vgg_test_raster();
+  vgg_test_hash();
+  vgg_test_platform_cache();
+  vgg_test_platform_parallel();
+  vgg_test_svg_write_truncated();
+  vgg_test_svg_stats();
+  vgg_test_svg_measure();
+  vgg_test_svg_write_stream_file();
+  vgg_test_platform_gather();
+  vgg_test_platform_atomic();
+  vgg_test_gzip();
 
   return 0;
 }
@@ -30,6 +30,23 @@ LICENSE
 #define VGG_API static
 #endif
 
+/* The intrinsics headers below include <stdlib.h>, which fixes the libc feature set of the whole translation
+   unit. Strict ISO C builds on Linux (-std=c89) would then hide POSIX from the platform headers included after
+   vgg.h, so POSIX.1-2001 is requested here unless the build already chose a level.
+*/
+#if defined(__linux__) && defined(__STRICT_ANSI__) && !defined(_POSIX_C_SOURCE) && !defined(_XOPEN_SOURCE) && !defined(_GNU_SOURCE) && !defined(_DEFAULT_SOURCE)
+#define _POSIX_C_SOURCE 200112L
+#endif
+
+/* SIMD kernels are selected at compile time, define VGG_NO_SIMD to use the portable scalar code only */
+#if !defined(VGG_NO_SIMD) && defined(__AVX__)
+#include <immintrin.h>
+#define VGG_SIMD_AVX
+#elif !defined(VGG_NO_SIMD) && (defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2))
+#include <emmintrin.h>
+#define VGG_SIMD_SSE2
+#endif
+
 typedef struct vgg_color
 {
   int r;
@@ -123,14 +140,242 @@ typedef struct vgg_path
 
 } vgg_path;
 
+/* Axis aligned bounding box */
+typedef struct vgg_bounds
+{
+  double x0, y0, x1, y1;
+
+} vgg_bounds;
+
+struct vgg_svg_writer;
+
+/* Maximum number of distinct fill colors of a vgg_svg_style */
+#ifndef VGG_SVG_STYLE_CAPACITY
+#define VGG_SVG_STYLE_CAPACITY 256
+#endif
+
+/* Style interning: distinct fill colors become CSS classes (.c0, .c1, ...) written once
+   in a <style> block, elements only reference them with class="cN".
+   Colors beyond VGG_SVG_STYLE_CAPACITY are written inline as before.
+*/
+typedef struct vgg_svg_style
+{
+  unsigned long colors[VGG_SVG_STYLE_CAPACITY]; /* 0xRRGGBB of class c<index> */
+  int slots[2 * VGG_SVG_STYLE_CAPACITY];        /* Open addressing hash table, class index + 1 or 0 if empty */
+  int count;
+  int upfront; /* Classes declared right after the start tag, fixed by the first vgg_svg_style_use, -1 before */
+
+} vgg_svg_style;
+
+#ifdef VGG_STATS
+/* Opt-in writer statistics, define VGG_STATS before including vgg.h.
+   Counts elements and their bytes per vgg_header_type, bytes handed to the sink, bytes dropped because the
+   buffer was full and the fullest the buffer got. With VGG_STATS_CYCLES the processor cycles spent formatting
+   elements and in the sink are summed as well (__rdtsc on x86 unless VGG_STATS_CLOCK is defined).
+   Bytes appended pre-rendered (vgg_svg_putn, cache replays, parallel shards) only count towards the totals.
+*/
+#if defined(VGG_STATS_CYCLES) && !defined(VGG_STATS_CLOCK)
+#if defined(_MSC_VER) && (defined(_M_X64) || defined(_M_IX86))
+#include <intrin.h>
+#define VGG_STATS_CLOCK() ((unsigned long)__rdtsc())
+#elif defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#define VGG_STATS_CLOCK() ((unsigned long)__rdtsc())
+#else
+#error "vgg: VGG_STATS_CYCLES has no default clock on this architecture. please define VGG_STATS_CLOCK()"
+#endif
+#endif
+
+typedef struct vgg_svg_stats
+{
+  unsigned long elements[VGG_TYPE_PATH + 1]; /* Written elements per type, culled ones are not counted */
+  unsigned long bytes[VGG_TYPE_PATH + 1];    /* Bytes of these elements */
+  unsigned long flushed;                     /* Bytes consumed by the sink */
+  unsigned long flushes;                     /* Sink calls */
+  unsigned long dropped;                     /* Bytes that did not fit into the buffer */
+  int high_water;                            /* Largest buffer length seen */
+
+  double cycles_format; /* VGG_STATS_CYCLES: formatting elements into the buffer */
+  double cycles_sink;   /* VGG_STATS_CYCLES: inside the sink */
+
+  unsigned long mark;        /* Position where the current elements started */
+  unsigned int mark_count;   /* Elements started there */
+  unsigned int mark_culled;  /* w->culled at that point */
+  unsigned long mark_cycles; /* Clock at that point */
+
+} vgg_svg_stats;
+#endif
+
+/* Streaming sink of a writer.
+   Called whenever the buffer is full and on vgg_svg_writer_flush / vgg_svg_end.
+   It has to consume w->buffer[0..w->length) and make room again (usually by
+   resetting w->length to 0, it may also swap w->buffer and w->capacity).
+   Returns 0 on failure.
+*/
+typedef int (*vgg_svg_sink)(struct vgg_svg_writer *w);
+
 typedef struct vgg_svg_writer
 {
   unsigned char *buffer;
   int capacity;
   int length;
 
+  vgg_svg_sink sink; /* Optional, 0 for a fixed size buffer */
+  void *sink_user;   /* User data for the sink (e.g. a file handle) */
+
+  int truncated; /* Set once bytes had to be dropped */
+
+  vgg_svg_style *style; /* Optional style interning, see vgg_svg_style_use */
+  int style_written;    /* Classes of style already declared in this document */
+
+  int cull;                 /* Skip elements outside cull_viewport, see vgg_svg_cull */
+  unsigned int culled;      /* Number of skipped elements */
+  vgg_bounds cull_viewport; /* Document area of vgg_svg_start unless changed */
+  int path_start;           /* Offset of the open path of the path builder, -1 once flushed */
+  vgg_bounds path_bounds;   /* Bounds of the open path */
+
+#ifdef VGG_STATS
+  vgg_svg_stats stats;
+#endif
+
 } vgg_svg_writer;
 
+#ifdef VGG_STATS
+
+/* Bytes written so far, flushed ones included */
+VGG_API VGG_INLINE unsigned long vgg_svg_stats_position(vgg_svg_writer *w)
+{
+  return w->stats.flushed + (unsigned long)w->length;
+}
+
+VGG_API VGG_INLINE void vgg_svg_stats_high_water(vgg_svg_writer *w)
+{
+  w->stats.high_water = (w->length > w->stats.high_water) ? w->length : w->stats.high_water;
+}
+
+/* count elements start at the current position */
+VGG_API VGG_INLINE void vgg_svg_stats_mark(vgg_svg_writer *w, unsigned int count)
+{
+  vgg_svg_stats_high_water(w);
+  w->stats.mark = vgg_svg_stats_position(w);
+  w->stats.mark_count = count;
+  w->stats.mark_culled = w->culled;
+#ifdef VGG_STATS_CLOCK
+  w->stats.mark_cycles = VGG_STATS_CLOCK();
+#endif
+}
+
+/* The elements since vgg_svg_stats_mark are written, except the culled ones */
+VGG_API VGG_INLINE void vgg_svg_stats_elements(vgg_svg_writer *w, vgg_header_type type)
+{
+  unsigned long position = vgg_svg_stats_position(w);
+
+#ifdef VGG_STATS_CLOCK
+  w->stats.cycles_format += (double)(VGG_STATS_CLOCK() - w->stats.mark_cycles);
+#endif
+  vgg_svg_stats_high_water(w);
+  w->stats.elements[type] += w->stats.mark_count - (w->culled - w->stats.mark_culled);
+  w->stats.bytes[type] += (position > w->stats.mark) ? position - w->stats.mark : 0;
+}
+
+#define VGG_SVG_STATS_MARK(w, count) vgg_svg_stats_mark(w, count)
+#define VGG_SVG_STATS_ELEMENTS(w, type) vgg_svg_stats_elements(w, type)
+
+#else
+
+#define VGG_SVG_STATS_MARK(w, count)
+#define VGG_SVG_STATS_ELEMENTS(w, type)
+
+#endif
+
+/* Writer that fills a fixed size buffer. Bytes exceeding the capacity are dropped and "truncated" is set.
+   A buffer of 0 measures instead, see vgg_svg_writer_create_measure.
+*/
+VGG_API VGG_INLINE vgg_svg_writer vgg_svg_writer_create(unsigned char *buffer, int capacity)
+{
+  vgg_svg_writer w;
+  w.buffer = buffer;
+  w.capacity = capacity;
+  w.length = 0;
+  w.sink = 0;
+  w.sink_user = 0;
+  w.truncated = 0;
+  w.style = 0;
+  w.style_written = 0;
+  w.cull = 0;
+  w.culled = 0;
+  w.cull_viewport.x0 = 0.0;
+  w.cull_viewport.y0 = 0.0;
+  w.cull_viewport.x1 = 0.0;
+  w.cull_viewport.y1 = 0.0;
+  w.path_start = -1;
+  w.path_bounds = w.cull_viewport;
+#ifdef VGG_STATS
+  {
+    unsigned char *stats = (unsigned char *)&w.stats;
+    unsigned long i;
+    for (i = 0; i < (unsigned long)sizeof(w.stats); ++i)
+    {
+      stats[i] = 0;
+    }
+  }
+#endif
+  return w;
+}
+
+/* Writer without a buffer that only counts: every call advances length by the bytes it would write.
+   A first pass with it gives the exact size of a document, e.g. to allocate its buffer or file once.
+*/
+VGG_API VGG_INLINE vgg_svg_writer vgg_svg_writer_create_measure(void)
+{
+  return vgg_svg_writer_create(0, 0);
+}
+
+/* Writer that uses buffer as a chunk buffer and hands it to sink whenever it is full.
+   Documents of any size can be written in constant memory.
+*/
+VGG_API VGG_INLINE vgg_svg_writer vgg_svg_writer_create_stream(unsigned char *buffer, int capacity, vgg_svg_sink sink, void *sink_user)
+{
+  vgg_svg_writer w = vgg_svg_writer_create(buffer, capacity);
+  w.sink = sink;
+  w.sink_user = sink_user;
+  return w;
+}
+
+/* Hand all buffered bytes to the sink. Returns 0 if the sink failed or bytes were dropped. */
+VGG_API VGG_INLINE int vgg_svg_writer_flush(vgg_svg_writer *w)
+{
+  if (w->sink && w->length > 0)
+  {
+#ifdef VGG_STATS
+    int length = w->length;
+#ifdef VGG_STATS_CLOCK
+    unsigned long cycles = VGG_STATS_CLOCK();
+#endif
+    vgg_svg_stats_high_water(w);
+#endif
+
+    if (!w->sink(w))
+    {
+      /* Stop streaming, everything written afterwards is dropped */
+      w->sink = 0;
+      w->truncated = 1;
+    }
+
+#ifdef VGG_STATS
+    w->stats.flushes++;
+    w->stats.flushed += (unsigned long)(length - w->length);
+#ifdef VGG_STATS_CLOCK
+    w->stats.cycles_sink += (double)(VGG_STATS_CLOCK() - cycles);
+#endif
+#endif
+
+    /* An open path can no longer be rolled back */
+    w->path_start = -1;
+  }
+  return !w->truncated;
+}
+
 VGG_API VGG_INLINE vgg_color vgg_color_map_linear(
     double value_current,
     double value_min,
@@ -162,509 +407,3602 @@ VGG_API VGG_INLINE vgg_color vgg_color_map_linear(
   return color;
 }
 
-/* Convert datatypes to string */
-
-/* Write integer value as decimal string into buffer.
-   buffer must have enough space.
-   Returns pointer to buffer.
-*/
-VGG_API VGG_INLINE char *vgg_itoa(int value, char *buffer)
+/* Scalar version of vgg_color_map_linear_batch */
+VGG_API VGG_INLINE void vgg_color_map_linear_batch_scalar(
+    double *values,
+    unsigned int count,
+    double value_min,
+    double value_max,
+    vgg_color color_start,
+    vgg_color color_end,
+    unsigned char *rgb)
 {
-  char temp[12]; /* enough for 32-bit int */
-  int i = 0, j, sign;
+  unsigned int i;
 
-  if (value == 0)
+  for (i = 0; i < count; ++i)
   {
-    buffer[0] = '0';
-    buffer[1] = 0;
-    return buffer;
+    vgg_color color = vgg_color_map_linear(values[i], value_min, value_max, color_start, color_end);
+    rgb[0] = (unsigned char)color.r;
+    rgb[1] = (unsigned char)color.g;
+    rgb[2] = (unsigned char)color.b;
+    rgb += 3;
   }
+}
 
-  sign = (value < 0) ? -1 : 1;
-  if (sign == -1)
-  {
-    value = -value;
-  }
+/* Maps count values like vgg_color_map_linear and writes packed 8-bit RGB triples into rgb (3 * count bytes).
+   Uses AVX or SSE2 kernels if available, the results are identical to the scalar function.
+*/
+VGG_API VGG_INLINE void vgg_color_map_linear_batch(
+    double *values,
+    unsigned int count,
+    double value_min,
+    double value_max,
+    vgg_color color_start,
+    vgg_color color_end,
+    unsigned char *rgb)
+{
+  unsigned int i = 0;
 
-  while (value != 0)
-  {
-    temp[i++] = (char)('0' + (value % 10));
-    value /= 10;
-  }
-  if (sign == -1)
+  /* Same arithmetic as the scalar function: start + clamp((v - min) / (max - min)) * (end - start), truncated */
+  if (value_max > value_min)
   {
-    temp[i++] = '-';
-  }
+#if defined(VGG_SIMD_AVX)
+    __m256d min = _mm256_set1_pd(value_min);
+    __m256d range = _mm256_set1_pd(value_max - value_min);
+    __m256d zero = _mm256_setzero_pd();
+    __m256d one = _mm256_set1_pd(1.0);
+    __m256d start_r = _mm256_set1_pd((double)color_start.r);
+    __m256d start_g = _mm256_set1_pd((double)color_start.g);
+    __m256d start_b = _mm256_set1_pd((double)color_start.b);
+    __m256d delta_r = _mm256_set1_pd((double)(color_end.r - color_start.r));
+    __m256d delta_g = _mm256_set1_pd((double)(color_end.g - color_start.g));
+    __m256d delta_b = _mm256_set1_pd((double)(color_end.b - color_start.b));
+    int r[4], g[4], b[4], k;
+
+    for (; i + 4 <= count; i += 4)
+    {
+      __m256d t = _mm256_div_pd(_mm256_sub_pd(_mm256_loadu_pd(values + i), min), range);
+      t = _mm256_min_pd(_mm256_max_pd(t, zero), one);
 
-  /* reverse */
-  for (j = 0; j < i; ++j)
-  {
-    buffer[j] = temp[i - j - 1];
+      _mm_storeu_si128((__m128i *)r, _mm256_cvttpd_epi32(_mm256_add_pd(start_r, _mm256_mul_pd(t, delta_r))));
+      _mm_storeu_si128((__m128i *)g, _mm256_cvttpd_epi32(_mm256_add_pd(start_g, _mm256_mul_pd(t, delta_g))));
+      _mm_storeu_si128((__m128i *)b, _mm256_cvttpd_epi32(_mm256_add_pd(start_b, _mm256_mul_pd(t, delta_b))));
+
+      for (k = 0; k < 4; ++k)
+      {
+        rgb[0] = (unsigned char)r[k];
+        rgb[1] = (unsigned char)g[k];
+        rgb[2] = (unsigned char)b[k];
+        rgb += 3;
+      }
+    }
+#elif defined(VGG_SIMD_SSE2)
+    __m128d min = _mm_set1_pd(value_min);
+    __m128d range = _mm_set1_pd(value_max - value_min);
+    __m128d zero = _mm_setzero_pd();
+    __m128d one = _mm_set1_pd(1.0);
+    __m128d start_r = _mm_set1_pd((double)color_start.r);
+    __m128d start_g = _mm_set1_pd((double)color_start.g);
+    __m128d start_b = _mm_set1_pd((double)color_start.b);
+    __m128d delta_r = _mm_set1_pd((double)(color_end.r - color_start.r));
+    __m128d delta_g = _mm_set1_pd((double)(color_end.g - color_start.g));
+    __m128d delta_b = _mm_set1_pd((double)(color_end.b - color_start.b));
+
+    for (; i + 2 <= count; i += 2)
+    {
+      __m128d t = _mm_div_pd(_mm_sub_pd(_mm_loadu_pd(values + i), min), range);
+      __m128i r, g, b;
+
+      t = _mm_min_pd(_mm_max_pd(t, zero), one);
+
+      r = _mm_cvttpd_epi32(_mm_add_pd(start_r, _mm_mul_pd(t, delta_r)));
+      g = _mm_cvttpd_epi32(_mm_add_pd(start_g, _mm_mul_pd(t, delta_g)));
+      b = _mm_cvttpd_epi32(_mm_add_pd(start_b, _mm_mul_pd(t, delta_b)));
+
+      rgb[0] = (unsigned char)_mm_cvtsi128_si32(r);
+      rgb[1] = (unsigned char)_mm_cvtsi128_si32(g);
+      rgb[2] = (unsigned char)_mm_cvtsi128_si32(b);
+      rgb[3] = (unsigned char)_mm_cvtsi128_si32(_mm_srli_si128(r, 4));
+      rgb[4] = (unsigned char)_mm_cvtsi128_si32(_mm_srli_si128(g, 4));
+      rgb[5] = (unsigned char)_mm_cvtsi128_si32(_mm_srli_si128(b, 4));
+      rgb += 6;
+    }
+#endif
   }
-  buffer[i] = 0;
-  return buffer;
+
+  /* Remaining values (or all without SIMD) */
+  vgg_color_map_linear_batch_scalar(values + i, count - i, value_min, value_max, color_start, color_end, rgb);
 }
 
-/* Same for long */
-VGG_API VGG_INLINE char *vgg_ltoa(long value, char *buffer)
+/* Number of entries of a vgg_colormap lookup table (e.g. 256 or 4096) */
+#ifndef VGG_COLORMAP_SIZE
+#define VGG_COLORMAP_SIZE 256
+#endif
+
+/* Multi-stop gradient baked into a lookup table.
+   Mapping a value is an index computation and a table load, the hex string of
+   every entry is pre-rendered for the SVG fill attribute.
+*/
+typedef struct vgg_colormap
 {
-  char temp[20]; /* enough for 64-bit long */
-  int i = 0, j;
-  int sign = (value < 0) ? -1 : 1;
+  double value_min;
+  double scale; /* (VGG_COLORMAP_SIZE - 1) / (value_max - value_min) */
 
-  if (value == 0)
-  {
-    buffer[0] = '0';
-    buffer[1] = 0;
-    return buffer;
-  }
+  vgg_color colors[VGG_COLORMAP_SIZE];
+  char hex[VGG_COLORMAP_SIZE][6]; /* RRGGBB, not null terminated */
+
+} vgg_colormap;
+
+/* Bake stops_count (>= 1) color stops into the table.
+   positions are the ascending stop positions in [0, 1], 0 places the stops evenly.
+   Values are mapped from [value_min, value_max] onto the gradient and clamped.
+*/
+VGG_API VGG_INLINE void vgg_colormap_init(
+    vgg_colormap *map,
+    vgg_color *stops,
+    double *positions,
+    unsigned int stops_count,
+    double value_min,
+    double value_max)
+{
+  static const char hex[] = "0123456789ABCDEF";
+  unsigned int i, segment = 0;
 
-  if (sign == -1)
-    value = -value;
+  map->value_min = value_min;
+  map->scale = (value_max > value_min) ? (double)(VGG_COLORMAP_SIZE - 1) / (value_max - value_min) : 0.0;
 
-  while (value != 0)
+  for (i = 0; i < VGG_COLORMAP_SIZE; ++i)
   {
-    temp[i++] = (char)('0' + (value % 10));
-    value /= 10;
+    double t = (double)i / (double)(VGG_COLORMAP_SIZE - 1);
+    double t0, t1;
+    vgg_color color;
+
+    if (stops_count < 2)
+    {
+      color = stops[0];
+    }
+    else
+    {
+      /* Find the segment containing t */
+      for (;;)
+      {
+        t1 = positions ? positions[segment + 1] : (double)(segment + 1) / (double)(stops_count - 1);
+        if (t <= t1 || segment + 2 >= stops_count)
+        {
+          break;
+        }
+        segment++;
+      }
+      t0 = positions ? positions[segment] : (double)segment / (double)(stops_count - 1);
+
+      color = vgg_color_map_linear(t, t0, t1, stops[segment], stops[segment + 1]);
+    }
+
+    map->colors[i] = color;
+    map->hex[i][0] = hex[(color.r >> 4) & 0xF];
+    map->hex[i][1] = hex[(color.r) & 0xF];
+    map->hex[i][2] = hex[(color.g >> 4) & 0xF];
+    map->hex[i][3] = hex[(color.g) & 0xF];
+    map->hex[i][4] = hex[(color.b >> 4) & 0xF];
+    map->hex[i][5] = hex[(color.b) & 0xF];
   }
-  if (sign == -1)
+}
+
+/* Table index of a value (nearest entry, clamped) */
+VGG_API VGG_INLINE int vgg_colormap_index(vgg_colormap *map, double value)
+{
+  double t = (value - map->value_min) * map->scale + 0.5;
+
+  /* Also catches NaN */
+  if (!(t >= 0.0))
   {
-    temp[i++] = '-';
+    return 0;
   }
-
-  for (j = 0; j < i; ++j)
+  if (t >= (double)(VGG_COLORMAP_SIZE - 1))
   {
-    buffer[j] = temp[i - j - 1];
+    return VGG_COLORMAP_SIZE - 1;
   }
-  buffer[i] = 0;
-  return buffer;
+  return (int)t;
 }
 
-/* Unsigned long to string */
-VGG_API VGG_INLINE char *vgg_ultoa(unsigned long value, char *buffer)
+VGG_API VGG_INLINE vgg_color vgg_colormap_map(vgg_colormap *map, double value)
 {
-  char temp[20];
-  int i = 0, j;
+  return map->colors[vgg_colormap_index(map, value)];
+}
+
+/* Number formatting engine.
+   All number to string conversions write through these functions.
+   They write into p without bounds checks and return the position after the last character.
+*/
 
-  if (value == 0)
+/* Write exactly count digits of val (zero padded), two digits at a time */
+VGG_API VGG_INLINE char *vgg_fmt_digits(char *p, unsigned long val, int count)
+{
+  static const char pairs[201] =
+      "00010203040506070809"
+      "10111213141516171819"
+      "20212223242526272829"
+      "30313233343536373839"
+      "40414243444546474849"
+      "50515253545556575859"
+      "60616263646566676869"
+      "70717273747576777879"
+      "80818283848586878889"
+      "90919293949596979899";
+
+  char *end = p + count;
+
+  p = end;
+  while (count >= 2)
   {
-    buffer[0] = '0';
-    buffer[1] = 0;
-    return buffer;
+    unsigned long q = val / 100;
+    unsigned long r = (val - q * 100) * 2;
+    p -= 2;
+    p[0] = pairs[r];
+    p[1] = pairs[r + 1];
+    val = q;
+    count -= 2;
   }
-
-  while (value != 0)
+  if (count)
   {
-    temp[i++] = (char)('0' + (value % 10));
-    value /= 10;
+    *--p = (char)('0' + val);
   }
 
-  for (j = 0; j < i; ++j)
+  return end;
+}
+
+/* Number of decimal digits of val */
+VGG_API VGG_INLINE int vgg_fmt_digit_count(unsigned long val)
+{
+  int count = 1;
+  for (;;)
   {
-    buffer[j] = temp[i - j - 1];
+    if (val < 10)
+    {
+      return count;
+    }
+    if (val < 100)
+    {
+      return count + 1;
+    }
+    if (val < 1000)
+    {
+      return count + 2;
+    }
+    if (val < 10000)
+    {
+      return count + 3;
+    }
+    val /= 10000;
+    count += 4;
   }
-  buffer[i] = 0;
-  return buffer;
 }
 
-VGG_API VGG_INLINE char *vgg_ftoa(double value, char *buffer, int precision)
+/* Maximum fractional digits and upper bound of the characters written by vgg_fmt_double */
+#define VGG_FMT_PRECISION_MAX 9
+#define VGG_FMT_DOUBLE_SIZE_MAX (1 + 309 + 1 + VGG_FMT_PRECISION_MAX)
+
+/* Integer valued doubles >= 2^53 are written exactly with base 10000 limbs */
+VGG_API VGG_INLINE char *vgg_fmt_double_large(char *p, double a)
 {
-  int int_part, frac_part, i = 0, j;
-  int multiplier = 1;
+  unsigned long limbs[80];
+  unsigned long hi, carry;
+  double rest;
+  int count = 0, exponent = 0, i;
 
-  if (precision < 0)
+  /* a = m * 2^exponent with m < 2^53 */
+  while (a >= 9007199254740992.0 * 4294967296.0)
   {
-    precision = 0;
+    a *= 1.0 / 4294967296.0;
+    exponent += 32;
   }
-  if (precision > 9)
+  while (a >= 9007199254740992.0)
   {
-    precision = 9; /* prevent overflow */
+    a *= 0.5;
+    exponent++;
   }
 
-  /* Sign */
-  if (value < 0)
+  hi = (unsigned long)(a / 1e8);
+  rest = a - (double)hi * 1e8;
+  if (rest < 0.0)
   {
-    value = -value;
-    buffer[i++] = '-';
+    hi--;
+    rest += 1e8;
   }
 
-  /* Integer part */
-  int_part = (int)value;
-  vgg_itoa(int_part, buffer + i);
+  limbs[0] = (unsigned long)rest % 10000;
+  limbs[1] = (unsigned long)rest / 10000;
+  limbs[2] = hi % 10000;
+  limbs[3] = hi / 10000;
+  count = 4;
+
+  while (exponent > 0)
+  {
+    int shift = exponent > 16 ? 16 : exponent;
+
+    carry = 0;
+    for (i = 0; i < count; ++i)
+    {
+      unsigned long t = (limbs[i] << shift) + carry;
+      limbs[i] = t % 10000;
+      carry = t / 10000;
+    }
+    while (carry)
+    {
+      limbs[count++] = carry % 10000;
+      carry /= 10000;
+    }
+    exponent -= shift;
+  }
 
-  /* Advance i to end of int_part string */
-  while (buffer[i] != '\0')
+  while (count > 1 && limbs[count - 1] == 0)
   {
-    i++;
+    count--;
   }
 
-  if (precision == 0)
+  p = vgg_fmt_digits(p, limbs[count - 1], vgg_fmt_digit_count(limbs[count - 1]));
+  for (i = count - 2; i >= 0; --i)
   {
-    buffer[i] = '\0';
-    return buffer;
+    p = vgg_fmt_digits(p, limbs[i], 4);
   }
+  return p;
+}
 
-  buffer[i++] = '.';
+/* Decides the rounding of r = a * scale when the fraction of r is exactly 0.5.
+   The rounding error e of the product (Dekker) tells on which side the exact value is,
+   exact ties are rounded to even.
+*/
+VGG_API VGG_INLINE int vgg_fmt_round_half_up(double a, double scale, double r, unsigned long odd)
+{
+  double c, ah, al, bh, bl, e;
+
+  c = 134217729.0 * a;
+  ah = c - (c - a);
+  al = a - ah;
+  c = 134217729.0 * scale;
+  bh = c - (c - scale);
+  bl = scale - bh;
+  e = ((ah * bh - r) + ah * bl + al * bh) + al * bl;
+
+  return e > 0.0 || (e == 0.0 && odd);
+}
+
+/* Rounds a * 10^precision for 0 <= a < 2^53 into the integer part hi * 1e9 + lo and precision fractional digits frac */
+VGG_API VGG_INLINE void vgg_fmt_double_split(double a, int precision, unsigned long *hi, unsigned long *lo, unsigned long *frac)
+{
+  static const double scales[VGG_FMT_PRECISION_MAX + 1] = {1e0, 1e1, 1e2, 1e3, 1e4, 1e5, 1e6, 1e7, 1e8, 1e9};
+  static const unsigned long iscales[VGG_FMT_PRECISION_MAX + 1] = {1, 10, 100, 1000, 10000, 100000, 1000000, 10000000, 100000000, 1000000000};
+
+  unsigned long n;
+  double r = a * scales[precision], half;
 
-  /* Calculate fractional part multiplier */
-  for (j = 0; j < precision; ++j)
-    multiplier *= 10;
+  *hi = 0;
 
-  /* Extract fractional part */
-  frac_part = (int)((value - int_part) * multiplier + 0.5); /* round */
+  if (r < 2e9)
+  {
+    /* Fast path: the scaled value fits into a long */
+    n = (unsigned long)(long)r;
+    half = r - (double)(long)n;
+
+    if (half > 0.5 || (half == 0.5 && vgg_fmt_round_half_up(a, scales[precision], r, n & 1)))
+    {
+      n++;
+    }
 
-  /* Write zero-padded fractional part */
+    *lo = n / iscales[precision];
+    *frac = n - *lo * iscales[precision];
+  }
+  else
   {
-    char temp[10];
-    int k = 0;
+    /* Split into integer part hi * 1e9 + lo and the exact fraction */
+    double rest;
 
-    if (frac_part == 0)
+    if (a < 4e9)
     {
-      for (j = 0; j < precision; ++j)
-        buffer[i++] = '0';
+      *lo = (unsigned long)a;
     }
     else
     {
-      /* Build fractional string backwards */
-      while (frac_part > 0 || k < precision)
+      *hi = (unsigned long)(a / 1e9);
+      rest = a - (double)*hi * 1e9;
+      if (rest < 0.0)
       {
-        temp[k++] = (char)('0' + (frac_part % 10));
-        frac_part /= 10;
+        (*hi)--;
+        rest += 1e9;
       }
-
-      /* Zero padding if needed */
-      while (k < precision)
+      else if (rest >= 1e9)
       {
-        temp[k++] = '0';
+        (*hi)++;
+        rest -= 1e9;
       }
+      *lo = (unsigned long)rest;
+      a = rest;
+    }
 
-      /* Copy reversed string to buffer */
-      while (k > 0)
+    rest = a - (double)*lo;
+    r = rest * scales[precision];
+    n = (unsigned long)r;
+    half = r - (double)n;
+
+    if (half > 0.5 || (half == 0.5 && vgg_fmt_round_half_up(rest, scales[precision], r, precision > 0 ? (n & 1) : (*lo & 1))))
+    {
+      n++;
+    }
+
+    *frac = n;
+    if (n == iscales[precision])
+    {
+      /* Carry into the integer part */
+      *frac = 0;
+      if (++*lo == 1000000000 && *hi > 0)
       {
-        buffer[i++] = temp[--k];
+        *lo = 0;
+        (*hi)++;
       }
     }
   }
-
-  buffer[i] = '\0';
-  return buffer;
-}
-
-VGG_API VGG_INLINE vgg_data_field vgg_data_field_create_int(char *key, int value, char *value_buffer)
-{
-  vgg_data_field df;
-  df.key = key;
-  vgg_itoa(value, value_buffer);
-  df.value = value_buffer;
-  return df;
-}
-
-VGG_API VGG_INLINE vgg_data_field vgg_data_field_create_long(char *key, long value, char *value_buffer)
-{
-  vgg_data_field df;
-  df.key = key;
-  vgg_ltoa(value, value_buffer);
-  df.value = value_buffer;
-  return df;
-}
-
-VGG_API VGG_INLINE vgg_data_field vgg_data_field_create_unsigned_long(char *key, unsigned long value, char *value_buffer)
-{
-  vgg_data_field df;
-  df.key = key;
-  vgg_ultoa(value, value_buffer);
-  df.value = value_buffer;
-  return df;
-}
-
-VGG_API VGG_INLINE vgg_data_field vgg_data_field_create_float(char *key, float value, int precision, char *value_buffer)
-{
-  vgg_data_field df;
-  df.key = key;
-  vgg_ftoa((double)value, value_buffer, precision);
-  df.value = value_buffer;
-  return df;
 }
 
-VGG_API VGG_INLINE vgg_data_field vgg_data_field_create_double(char *key, double value, int precision, char *value_buffer)
+/* Write d with precision (0..9) fractional digits, correctly rounded (ties to even).
+   If trim is set trailing fractional zeros and a trailing '.' are left out.
+   NaN and infinity are written as "nan", "inf" and "-inf".
+   Values that round to zero are written without sign.
+*/
+VGG_API VGG_INLINE char *vgg_fmt_double(char *p, double d, int precision, int trim)
 {
-  vgg_data_field df;
-  df.key = key;
-  vgg_ftoa(value, value_buffer, precision);
-  df.value = value_buffer;
-  return df;
-}
+  unsigned long hi, lo, frac;
+  double a;
+  int negative;
 
-/* Write a string literal to the buffer */
-VGG_API VGG_INLINE void vgg_svg_puts(vgg_svg_writer *w, char *s)
-{
-  while (*s && w->length < w->capacity)
+  if (d != d)
   {
-    w->buffer[w->length++] = (unsigned char)*s++;
+    p[0] = 'n';
+    p[1] = 'a';
+    p[2] = 'n';
+    return p + 3;
   }
-}
 
-/* Write a single character */
-VGG_API VGG_INLINE void vgg_svg_putc(vgg_svg_writer *w, char c)
-{
-  if (w->length < w->capacity)
+  if (precision < 0)
   {
-    w->buffer[w->length++] = (unsigned char)c;
+    precision = 0;
+  }
+  if (precision > VGG_FMT_PRECISION_MAX)
+  {
+    precision = VGG_FMT_PRECISION_MAX;
   }
-}
+
+  negative = d < 0.0;
+  a = negative ? -d : d;
+
+  if (a < 9007199254740992.0)
+  {
+    vgg_fmt_double_split(a, precision, &hi, &lo, &frac);
+  }
+  else if (a - a == 0.0)
+  {
+    /* Integer valued */
+    if (negative)
+    {
+      *p++ = '-';
+    }
+    p = vgg_fmt_double_large(p, a);
+    if (precision > 0 && !trim)
+    {
+      *p++ = '.';
+      p = vgg_fmt_digits(p, 0, precision);
+    }
+    return p;
+  }
+  else
+  {
+    /* Infinity is the only value for which a - a is not zero */
+    if (negative)
+    {
+      *p++ = '-';
+    }
+    p[0] = 'i';
+    p[1] = 'n';
+    p[2] = 'f';
+    return p + 3;
+  }
+
+  if (negative && (hi | lo | frac))
+  {
+    *p++ = '-';
+  }
+
+  if (hi)
+  {
+    p = vgg_fmt_digits(p, hi, vgg_fmt_digit_count(hi));
+    p = vgg_fmt_digits(p, lo, 9);
+  }
+  else
+  {
+    p = vgg_fmt_digits(p, lo, vgg_fmt_digit_count(lo));
+  }
+
+  if (precision > 0 && !(trim && frac == 0))
+  {
+    *p++ = '.';
+    p = vgg_fmt_digits(p, frac, precision);
+
+    if (trim)
+    {
+      while (p[-1] == '0')
+      {
+        p--;
+      }
+    }
+  }
+
+  return p;
+}
+
+/* Number of characters vgg_fmt_double writes for d, without writing them */
+VGG_API VGG_INLINE int vgg_fmt_double_size(double d, int precision, int trim)
+{
+  unsigned long hi, lo, frac;
+  double a = (d < 0.0) ? -d : d;
+  int size;
+
+  /* NaN, infinity and integers beyond 2^53 are rare, they are formatted */
+  if (!(a < 9007199254740992.0))
+  {
+    char buffer[VGG_FMT_DOUBLE_SIZE_MAX];
+    return (int)(vgg_fmt_double(buffer, d, precision, trim) - buffer);
+  }
+
+  precision = (precision < 0) ? 0 : precision;
+  precision = (precision > VGG_FMT_PRECISION_MAX) ? VGG_FMT_PRECISION_MAX : precision;
+
+  vgg_fmt_double_split(a, precision, &hi, &lo, &frac);
+
+  size = (d < 0.0 && (hi | lo | frac)) ? 1 : 0;
+  size += hi ? vgg_fmt_digit_count(hi) + 9 : vgg_fmt_digit_count(lo);
+
+  if (precision > 0 && !(trim && frac == 0))
+  {
+    size += 1 + precision;
+
+    while (trim && frac % 10 == 0)
+    {
+      frac /= 10;
+      size--;
+    }
+  }
+
+  return size;
+}
+
+/* Upper bound of the characters written by vgg_fmt_long / vgg_fmt_ulong (64-bit long) */
+#define VGG_FMT_LONG_SIZE_MAX 21
+
+VGG_API VGG_INLINE char *vgg_fmt_ulong(char *p, unsigned long val)
+{
+  return vgg_fmt_digits(p, val, vgg_fmt_digit_count(val));
+}
+
+VGG_API VGG_INLINE char *vgg_fmt_long(char *p, long val)
+{
+  if (val < 0)
+  {
+    *p++ = '-';
+    /* Negate in unsigned arithmetic, -LONG_MIN does not fit into a long */
+    return vgg_fmt_ulong(p, 0UL - (unsigned long)val);
+  }
+  return vgg_fmt_ulong(p, (unsigned long)val);
+}
+
+/* Convert datatypes to string */
+
+/* Write integer value as decimal string into buffer.
+   buffer must have enough space.
+   Returns pointer to buffer.
+*/
+VGG_API VGG_INLINE char *vgg_itoa(int value, char *buffer)
+{
+  *vgg_fmt_long(buffer, (long)value) = '\0';
+  return buffer;
+}
+
+/* Same for long */
+VGG_API VGG_INLINE char *vgg_ltoa(long value, char *buffer)
+{
+  *vgg_fmt_long(buffer, value) = '\0';
+  return buffer;
+}
+
+/* Unsigned long to string */
+VGG_API VGG_INLINE char *vgg_ultoa(unsigned long value, char *buffer)
+{
+  *vgg_fmt_ulong(buffer, value) = '\0';
+  return buffer;
+}
+
+/* Write a double with precision (0..9) fractional digits into buffer.
+   The value is correctly rounded and the full double range is supported,
+   buffer must have room for VGG_FMT_DOUBLE_SIZE_MAX + 1 characters.
+   Returns pointer to buffer.
+*/
+VGG_API VGG_INLINE char *vgg_ftoa(double value, char *buffer, int precision)
+{
+  *vgg_fmt_double(buffer, value, precision, 0) = '\0';
+  return buffer;
+}
+
+VGG_API VGG_INLINE vgg_data_field vgg_data_field_create_int(char *key, int value, char *value_buffer)
+{
+  vgg_data_field df;
+  df.key = key;
+  vgg_itoa(value, value_buffer);
+  df.value = value_buffer;
+  return df;
+}
+
+VGG_API VGG_INLINE vgg_data_field vgg_data_field_create_long(char *key, long value, char *value_buffer)
+{
+  vgg_data_field df;
+  df.key = key;
+  vgg_ltoa(value, value_buffer);
+  df.value = value_buffer;
+  return df;
+}
+
+VGG_API VGG_INLINE vgg_data_field vgg_data_field_create_unsigned_long(char *key, unsigned long value, char *value_buffer)
+{
+  vgg_data_field df;
+  df.key = key;
+  vgg_ultoa(value, value_buffer);
+  df.value = value_buffer;
+  return df;
+}
+
+VGG_API VGG_INLINE vgg_data_field vgg_data_field_create_float(char *key, float value, int precision, char *value_buffer)
+{
+  vgg_data_field df;
+  df.key = key;
+  vgg_ftoa((double)value, value_buffer, precision);
+  df.value = value_buffer;
+  return df;
+}
+
+VGG_API VGG_INLINE vgg_data_field vgg_data_field_create_double(char *key, double value, int precision, char *value_buffer)
+{
+  vgg_data_field df;
+  df.key = key;
+  vgg_ftoa(value, value_buffer, precision);
+  df.value = value_buffer;
+  return df;
+}
+
+/* Fractional digits of the coordinates, trailing zeros are left out */
+#ifndef VGG_SVG_DOUBLE_PRECISION
+#define VGG_SVG_DOUBLE_PRECISION 3
+#endif
+
+/* Upper bounds of the characters written for a number.
+   The double bound holds for magnitudes below 2^53 (at most 16 integer digits), see vgg_svg_double_raw.
+*/
+#define VGG_SVG_UINT_SIZE_MAX 10
+#define VGG_SVG_DOUBLE_SIZE_MAX (1 + 16 + 1 + VGG_SVG_DOUBLE_PRECISION)
+
+/* Upper bound of the tag and attribute names of an element */
+#define VGG_SVG_ELEMENT_TAGS_SIZE_MAX 80
+
+/* Unchecked writes into a span returned by vgg_svg_reserve.
+   Each function returns the position after the written characters.
+*/
+VGG_API VGG_INLINE char *vgg_svg_raw_copy(char *p, char *s, int length)
+{
+  while (length-- > 0)
+  {
+    *p++ = *s++;
+  }
+  return p;
+}
+
+/* Copy a string literal, its length is known at compile time */
+#define VGG_SVG_RAW_LITERAL(p, s) vgg_svg_raw_copy((p), (s), (int)sizeof(s) - 1)
+
+VGG_API VGG_INLINE char *vgg_svg_raw_string(char *p, char *s)
+{
+  while (*s)
+  {
+    *p++ = *s++;
+  }
+  return p;
+}
+
+VGG_API VGG_INLINE char *vgg_svg_raw_uint(char *p, unsigned int val)
+{
+  return vgg_fmt_ulong(p, (unsigned long)val);
+}
+
+/* Coordinate with VGG_SVG_DOUBLE_PRECISION fractional digits */
+VGG_API VGG_INLINE char *vgg_svg_raw_double(char *p, double d)
+{
+  return vgg_fmt_double(p, d, VGG_SVG_DOUBLE_PRECISION, 1);
+}
+
+/* Whether vgg_svg_raw_double writes d within VGG_SVG_DOUBLE_SIZE_MAX: magnitudes below 2^53, NaN and infinity.
+   Larger integers are written by the checked vgg_svg_put_double.
+*/
+VGG_API VGG_INLINE int vgg_svg_double_raw(double d)
+{
+  return (d < 9007199254740992.0 && d > -9007199254740992.0) || d - d != 0.0;
+}
+
+/* End of the elements [first, end) whose coordinates (columns a, b and the optional c, d) can be written unchecked */
+VGG_API VGG_INLINE unsigned int vgg_svg_raw_end(double *a, double *b, double *c, double *d, unsigned int first, unsigned int end)
+{
+  for (; first < end; ++first)
+  {
+    if (!vgg_svg_double_raw(a[first]) || !vgg_svg_double_raw(b[first]) || (c && !vgg_svg_double_raw(c[first])) || (d && !vgg_svg_double_raw(d[first])))
+    {
+      break;
+    }
+  }
+  return first;
+}
+
+/* Color as 6 hex digits (RRGGBB) */
+VGG_API VGG_INLINE char *vgg_svg_raw_color(char *p, vgg_color color)
+{
+  static const char hex[] = "0123456789ABCDEF";
+  p[0] = hex[(color.r >> 4) & 0xF];
+  p[1] = hex[(color.r) & 0xF];
+  p[2] = hex[(color.g >> 4) & 0xF];
+  p[3] = hex[(color.g) & 0xF];
+  p[4] = hex[(color.b >> 4) & 0xF];
+  p[5] = hex[(color.b) & 0xF];
+  return p + 6;
+}
+
+/* Writes color as 6 hex digits (RRGGBB), kept for existing callers */
+#define VGG_SVG_PUT_COLOR(w, color)            \
+  do                                           \
+  {                                            \
+    char buf_color[6];                         \
+    vgg_svg_raw_color(buf_color, (color));     \
+    vgg_svg_putn((w), buf_color, 6);           \
+  } while (0)
+
+VGG_API VGG_INLINE void vgg_svg_style_init(vgg_svg_style *style)
+{
+  int i;
+  for (i = 0; i < 2 * VGG_SVG_STYLE_CAPACITY; ++i)
+  {
+    style->slots[i] = 0;
+  }
+  style->count = 0;
+  style->upfront = -1;
+}
+
+/* Class index of a fill color, registers new colors. Returns -1 if the table is full. */
+VGG_API VGG_INLINE int vgg_svg_style_intern(vgg_svg_style *style, vgg_color color)
+{
+  unsigned long key = ((unsigned long)(color.r & 0xFF) << 16) | ((unsigned long)(color.g & 0xFF) << 8) | (unsigned long)(color.b & 0xFF);
+  unsigned long slot = ((key * 2654435761UL) >> 8) % (2 * VGG_SVG_STYLE_CAPACITY);
+
+  for (;;)
+  {
+    int index = style->slots[slot] - 1;
+
+    if (index < 0)
+    {
+      break;
+    }
+    if (style->colors[index] == key)
+    {
+      return index;
+    }
+    slot = (slot + 1) % (2 * VGG_SVG_STYLE_CAPACITY);
+  }
+
+  if (style->count >= VGG_SVG_STYLE_CAPACITY)
+  {
+    return -1;
+  }
+
+  style->colors[style->count] = key;
+  style->slots[slot] = ++style->count;
+  return style->count - 1;
+}
+
+/* fill="#RRGGBB" or, with style interning, class="cN" */
+VGG_API VGG_INLINE char *vgg_svg_raw_fill(char *p, vgg_svg_style *style, vgg_color color)
+{
+  int index;
+
+  if (style && (index = vgg_svg_style_intern(style, color)) >= 0)
+  {
+    p = VGG_SVG_RAW_LITERAL(p, "class=\"c");
+    p = vgg_fmt_ulong(p, (unsigned long)index);
+    return VGG_SVG_RAW_LITERAL(p, "\" ");
+  }
+
+  p = VGG_SVG_RAW_LITERAL(p, "fill=\"#");
+  p = vgg_svg_raw_color(p, color);
+  return VGG_SVG_RAW_LITERAL(p, "\" ");
+}
+
+/* Called when the buffer is full. Returns 1 if there is room again, 0 if the bytes have to be dropped. */
+VGG_API VGG_INLINE int vgg_svg_writer_overflow(vgg_svg_writer *w)
+{
+  /* Measuring writer, vgg_svg_writer_skip counts the bytes */
+  if (!w->buffer)
+  {
+    return 0;
+  }
+
+  if (w->sink && vgg_svg_writer_flush(w) && w->length < w->capacity)
+  {
+    return 1;
+  }
+  w->truncated = 1;
+  return 0;
+}
+
+/* length bytes and the characters of s (if not 0) did not fit.
+   Measuring writers count them, other writers drop them.
+*/
+VGG_API VGG_INLINE void vgg_svg_writer_skip(vgg_svg_writer *w, char *s, int length)
+{
+  while (s && *s++)
+  {
+    length++;
+  }
+
+  if (!w->buffer)
+  {
+    w->length += length;
+  }
+#ifdef VGG_STATS
+  else
+  {
+    w->stats.dropped += (unsigned long)length;
+  }
+#endif
+}
+
+/* Copy that allows dst and src to overlap */
+VGG_API VGG_INLINE void vgg_move_bytes(unsigned char *dst, unsigned char *src, unsigned long size)
+{
+  unsigned long i = 0;
+
+  if (dst < src)
+  {
+#if defined(VGG_SIMD_AVX) || defined(VGG_SIMD_SSE2)
+    /* Each block is loaded before it is stored, writes stay behind the next read */
+    for (; i + 16 <= size; i += 16)
+    {
+      _mm_storeu_si128((__m128i *)(void *)(dst + i), _mm_loadu_si128((__m128i *)(void *)(src + i)));
+    }
+#endif
+    for (; i < size; ++i)
+    {
+      dst[i] = src[i];
+    }
+  }
+  else if (dst > src)
+  {
+    i = size;
+#if defined(VGG_SIMD_AVX) || defined(VGG_SIMD_SSE2)
+    for (; i >= 16; i -= 16)
+    {
+      _mm_storeu_si128((__m128i *)(void *)(dst + i - 16), _mm_loadu_si128((__m128i *)(void *)(src + i - 16)));
+    }
+#endif
+    while (i-- > 0)
+    {
+      dst[i] = src[i];
+    }
+  }
+}
+
+/* Write a string literal to the buffer */
+VGG_API VGG_INLINE void vgg_svg_puts(vgg_svg_writer *w, char *s)
+{
+  while (*s)
+  {
+    if (w->length >= w->capacity && !vgg_svg_writer_overflow(w))
+    {
+      vgg_svg_writer_skip(w, s, 0);
+      return;
+    }
+    w->buffer[w->length++] = (unsigned char)*s++;
+  }
+}
+
+/* Write length characters */
+VGG_API VGG_INLINE void vgg_svg_putn(vgg_svg_writer *w, char *s, int length)
+{
+  while (length > 0)
+  {
+    int n;
+
+    if (w->length >= w->capacity && !vgg_svg_writer_overflow(w))
+    {
+      vgg_svg_writer_skip(w, 0, length);
+      return;
+    }
+
+    /* As much as fits in one block copy */
+    n = w->capacity - w->length;
+    n = (n < length) ? n : length;
+    vgg_move_bytes(w->buffer + w->length, (unsigned char *)s, (unsigned long)n);
+    w->length += n;
+    s += n;
+    length -= n;
+  }
+}
+
+/* Write a single character */
+VGG_API VGG_INLINE void vgg_svg_putc(vgg_svg_writer *w, char c)
+{
+  if (w->length >= w->capacity && !vgg_svg_writer_overflow(w))
+  {
+    vgg_svg_writer_skip(w, 0, 1);
+    return;
+  }
+  w->buffer[w->length++] = (unsigned char)c;
+}
 
 /* Write an unsigned int */
 VGG_API VGG_INLINE void vgg_svg_put_uint(vgg_svg_writer *w, unsigned int val)
 {
-  char buf[10];
-  int i = 10;
-  if (val == 0)
+  char buf[VGG_SVG_UINT_SIZE_MAX];
+
+  if (!w->buffer)
+  {
+    w->length += vgg_fmt_digit_count((unsigned long)val);
+    return;
+  }
+  vgg_svg_putn(w, buf, (int)(vgg_svg_raw_uint(buf, val) - buf));
+}
+
+/* Write a coordinate with VGG_SVG_DOUBLE_PRECISION fractional digits */
+VGG_API VGG_INLINE void vgg_svg_put_double(vgg_svg_writer *w, double d)
+{
+  char buf[VGG_FMT_DOUBLE_SIZE_MAX];
+
+  if (!w->buffer)
+  {
+    w->length += vgg_fmt_double_size(d, VGG_SVG_DOUBLE_PRECISION, 1);
+    return;
+  }
+  vgg_svg_putn(w, buf, (int)(vgg_svg_raw_double(buf, d) - buf));
+}
+
+/* Reserve size bytes for unchecked vgg_svg_raw_* writes and return their start.
+   Streaming writers flush first if needed. Returns 0 if the bytes do not fit,
+   callers then fall back to the checked vgg_svg_put* functions.
+   The written bytes are taken over with vgg_svg_commit.
+*/
+VGG_API VGG_INLINE char *vgg_svg_reserve(vgg_svg_writer *w, int size)
+{
+  if (w->capacity - w->length < size)
+  {
+    if (!w->sink || size > w->capacity || !vgg_svg_writer_flush(w) || w->capacity - w->length < size)
+    {
+      return 0;
+    }
+  }
+  return (char *)(w->buffer + w->length);
+}
+
+VGG_API VGG_INLINE void vgg_svg_commit(vgg_svg_writer *w, char *end)
+{
+  w->length = (int)(end - (char *)w->buffer);
+}
+
+VGG_API VGG_INLINE void vgg_svg_start(vgg_svg_writer *w, char *id, double width, double height)
+{
+  w->cull_viewport.x0 = 0.0;
+  w->cull_viewport.y0 = 0.0;
+  w->cull_viewport.x1 = width;
+  w->cull_viewport.y1 = height;
+
+  vgg_svg_puts(w, "<svg ");
+
+  /* ID field */
+  vgg_svg_puts(w, "id=\"");
+  vgg_svg_puts(w, id);
+  vgg_svg_puts(w, "\" ");
+
+  /* XMLNS */
+  vgg_svg_puts(w, "xmlns=\"http://www.w3.org/2000/svg\" ");
+
+  /* Width of svg */
+  vgg_svg_puts(w, "width=\"");
+  vgg_svg_put_double(w, width);
+  vgg_svg_puts(w, "\" ");
+
+  /* Height of svg */
+  vgg_svg_puts(w, "height=\"");
+  vgg_svg_put_double(w, height);
+  vgg_svg_puts(w, "\">\n");
+}
+
+/* Declare the classes [w->style_written, end) as a <style> block.
+   The progress is kept per writer, so a measuring pass leaves the style as it found it.
+*/
+VGG_API VGG_INLINE void vgg_svg_style_write(vgg_svg_writer *w, int end)
+{
+  vgg_svg_style *style = w->style;
+  char buf[32];
+  char *p;
+
+  if (!style || w->style_written >= end)
+  {
+    return;
+  }
+
+  vgg_svg_puts(w, "  <style>");
+  for (; w->style_written < end; ++w->style_written)
+  {
+    vgg_color color;
+    color.r = (int)((style->colors[w->style_written] >> 16) & 0xFF);
+    color.g = (int)((style->colors[w->style_written] >> 8) & 0xFF);
+    color.b = (int)(style->colors[w->style_written] & 0xFF);
+
+    p = VGG_SVG_RAW_LITERAL(buf, ".c");
+    p = vgg_fmt_ulong(p, (unsigned long)w->style_written);
+    p = VGG_SVG_RAW_LITERAL(p, "{fill:#");
+    p = vgg_svg_raw_color(p, color);
+    p = VGG_SVG_RAW_LITERAL(p, "}");
+    vgg_svg_putn(w, buf, (int)(p - buf));
+  }
+  vgg_svg_puts(w, "</style>\n");
+}
+
+/* Enable style interning, call right after vgg_svg_start.
+   Colors registered up front with vgg_svg_style_intern are written immediately,
+   colors first seen while adding elements are written in a <style> block by vgg_svg_end.
+   Every writer using the style declares the same up front classes, so a measuring pass and the
+   real pass that reuses its style produce the same bytes.
+*/
+VGG_API VGG_INLINE void vgg_svg_style_use(vgg_svg_writer *w, vgg_svg_style *style)
+{
+  if (style->upfront < 0)
+  {
+    style->upfront = style->count;
+  }
+  w->style = style;
+  w->style_written = 0;
+  vgg_svg_style_write(w, style->upfront);
+}
+
+VGG_API VGG_INLINE void vgg_svg_end(vgg_svg_writer *w)
+{
+  /* CSS applies to the whole document, classes found while streaming are declared at the end */
+  if (w->style)
+  {
+    vgg_svg_style_write(w, w->style->count);
+  }
+
+  vgg_svg_puts(w, "</svg>\n");
+
+#ifdef VGG_STATS
+  vgg_svg_stats_high_water(w);
+#endif
+
+  /* Streaming writers hand over the remaining bytes */
+  if (w->sink)
+  {
+    vgg_svg_writer_flush(w);
+  }
+}
+
+VGG_API VGG_INLINE int vgg_svg_strlen(char *s)
+{
+  int length = 0;
+  while (s[length])
+  {
+    length++;
+  }
+  return length;
+}
+
+/* Upper bound of the tags, id, fill and data fields of an element */
+VGG_API VGG_INLINE int vgg_svg_attributes_size_max(vgg_header *header)
+{
+  int size = VGG_SVG_ELEMENT_TAGS_SIZE_MAX + VGG_SVG_UINT_SIZE_MAX + 6;
+  unsigned int i;
+
+  /* data-key="value" */
+  for (i = 0; i < header->data_fields_count; ++i)
+  {
+    size += 9 + vgg_svg_strlen(header->data_fields[i].key) + vgg_svg_strlen(header->data_fields[i].value);
+  }
+
+  return size;
+}
+
+/* Upper bound of the characters vgg_svg_element_add writes for an element */
+VGG_API VGG_INLINE int vgg_svg_element_size_max(vgg_header *header)
+{
+  int size = vgg_svg_attributes_size_max(header);
+
+  if (header->type == VGG_TYPE_RECT || header->type == VGG_TYPE_LINE || header->type == VGG_TYPE_ELLIPSE)
+  {
+    size += 4 * VGG_SVG_DOUBLE_SIZE_MAX;
+  }
+  else if (header->type == VGG_TYPE_CIRCLE)
+  {
+    size += 3 * VGG_SVG_DOUBLE_SIZE_MAX;
+  }
+  else if (header->type == VGG_TYPE_TEXT)
+  {
+    size += 2 * VGG_SVG_DOUBLE_SIZE_MAX + vgg_svg_strlen(((vgg_text *)header)->text);
+  }
+  else if (header->type == VGG_TYPE_PATH)
+  {
+    size += vgg_svg_strlen(((vgg_path *)header)->d);
+  }
+
+  return size;
+}
+
+/* Whether vgg_svg_element_size_max holds for the coordinates of an element, see vgg_svg_double_raw */
+VGG_API VGG_INLINE int vgg_svg_element_raw(vgg_header *header)
+{
+  if (header->type == VGG_TYPE_RECT)
+  {
+    vgg_rect *rect = (vgg_rect *)header;
+    return vgg_svg_double_raw(rect->x) && vgg_svg_double_raw(rect->y) && vgg_svg_double_raw(rect->width) && vgg_svg_double_raw(rect->height);
+  }
+  if (header->type == VGG_TYPE_LINE)
+  {
+    vgg_line *line = (vgg_line *)header;
+    return vgg_svg_double_raw(line->x1) && vgg_svg_double_raw(line->y1) && vgg_svg_double_raw(line->x2) && vgg_svg_double_raw(line->y2);
+  }
+  if (header->type == VGG_TYPE_ELLIPSE)
+  {
+    vgg_ellipse *ellipse = (vgg_ellipse *)header;
+    return vgg_svg_double_raw(ellipse->cx) && vgg_svg_double_raw(ellipse->cy) && vgg_svg_double_raw(ellipse->rx) && vgg_svg_double_raw(ellipse->ry);
+  }
+  if (header->type == VGG_TYPE_CIRCLE)
+  {
+    vgg_circle *circle = (vgg_circle *)header;
+    return vgg_svg_double_raw(circle->cx) && vgg_svg_double_raw(circle->cy) && vgg_svg_double_raw(circle->r);
+  }
+  if (header->type == VGG_TYPE_TEXT)
+  {
+    vgg_text *text = (vgg_text *)header;
+    return vgg_svg_double_raw(text->x) && vgg_svg_double_raw(text->y);
+  }
+  return 1;
+}
+
+/* Bounds of elements for culling */
+VGG_API VGG_INLINE vgg_bounds vgg_bounds_empty(void)
+{
+  vgg_bounds bounds;
+  bounds.x0 = 1e300;
+  bounds.y0 = 1e300;
+  bounds.x1 = -1e300;
+  bounds.y1 = -1e300;
+  return bounds;
+}
+
+/* NaN coordinates stick, the bounds then overlap everything and the element is never culled */
+VGG_API VGG_INLINE void vgg_bounds_include(vgg_bounds *bounds, double x, double y)
+{
+  bounds->x0 = (x < bounds->x0 || x != x) ? x : bounds->x0;
+  bounds->y0 = (y < bounds->y0 || y != y) ? y : bounds->y0;
+  bounds->x1 = (x > bounds->x1 || x != x) ? x : bounds->x1;
+  bounds->y1 = (y > bounds->y1 || y != y) ? y : bounds->y1;
+}
+
+/* 0 only if a and b are certainly apart (NaN counts as overlapping) */
+VGG_API VGG_INLINE int vgg_bounds_overlap(vgg_bounds *a, vgg_bounds *b)
+{
+  return !(a->x1 < b->x0 || a->x0 > b->x1 || a->y1 < b->y0 || a->y0 > b->y1);
+}
+
+/* Parses a number of a path string, returns its end or 0 if there is none */
+VGG_API VGG_INLINE char *vgg_bounds_parse_number(char *s, double *value)
+{
+  double result = 0.0, scale = 1.0;
+  int negative = 0, digits = 0, exponent = 0, exponent_negative = 0;
+
+  while (*s == ' ' || *s == ',' || *s == '\t' || *s == '\n' || *s == '\r')
+  {
+    s++;
+  }
+
+  if (*s == '-' || *s == '+')
+  {
+    negative = (*s++ == '-');
+  }
+
+  for (; *s >= '0' && *s <= '9'; ++s, ++digits)
+  {
+    result = result * 10.0 + (double)(*s - '0');
+  }
+
+  if (*s == '.')
+  {
+    for (++s; *s >= '0' && *s <= '9'; ++s, ++digits)
+    {
+      scale *= 0.1;
+      result += (double)(*s - '0') * scale;
+    }
+  }
+
+  if (!digits)
+  {
+    return 0;
+  }
+
+  if ((*s == 'e' || *s == 'E') && (s[1] == '-' || s[1] == '+' || (s[1] >= '0' && s[1] <= '9')))
+  {
+    s++;
+    if (*s == '-' || *s == '+')
+    {
+      exponent_negative = (*s++ == '-');
+    }
+    for (; *s >= '0' && *s <= '9'; ++s)
+    {
+      exponent = (exponent < 1000) ? exponent * 10 + (*s - '0') : exponent;
+    }
+    for (; exponent > 0; --exponent)
+    {
+      result = exponent_negative ? result * 0.1 : result * 10.0;
+    }
+  }
+
+  *value = negative ? -result : result;
+  return s;
+}
+
+/* Bounds of all end and control points of a path string (a superset of the drawn area).
+   Returns 0 if the string can not be parsed.
+*/
+VGG_API VGG_INLINE int vgg_bounds_path(char *d, vgg_bounds *bounds)
+{
+  double v[7];
+  double cx = 0.0, cy = 0.0, start_x = 0.0, start_y = 0.0;
+  char command = 0;
+  int any = 0;
+
+  for (;;)
+  {
+    double ox, oy;
+    char upper;
+    int count, i;
+
+    while (*d == ' ' || *d == ',' || *d == '\t' || *d == '\n' || *d == '\r')
+    {
+      d++;
+    }
+
+    if (!*d)
+    {
+      break;
+    }
+
+    if ((*d >= 'A' && *d <= 'Z') || (*d >= 'a' && *d <= 'z'))
+    {
+      command = *d++;
+      if (command == 'Z' || command == 'z')
+      {
+        cx = start_x;
+        cy = start_y;
+        continue;
+      }
+    }
+
+    upper = (command >= 'a') ? (char)(command - 'a' + 'A') : command;
+
+    if (upper == 'M' || upper == 'L' || upper == 'T')
+    {
+      count = 2;
+    }
+    else if (upper == 'H' || upper == 'V')
+    {
+      count = 1;
+    }
+    else if (upper == 'S' || upper == 'Q')
+    {
+      count = 4;
+    }
+    else if (upper == 'C')
+    {
+      count = 6;
+    }
+    else if (upper == 'A')
+    {
+      count = 7;
+    }
+    else
+    {
+      return 0;
+    }
+
+    for (i = 0; i < count; ++i)
+    {
+      if (!(d = vgg_bounds_parse_number(d, &v[i])))
+      {
+        return 0;
+      }
+    }
+
+    /* Relative coordinates start at the current point */
+    ox = (command >= 'a') ? cx : 0.0;
+    oy = (command >= 'a') ? cy : 0.0;
+
+    if (upper == 'H')
+    {
+      cx = ox + v[0];
+    }
+    else if (upper == 'V')
+    {
+      cy = oy + v[0];
+    }
+    else if (upper == 'A')
+    {
+      /* The arc stays within its diameter (radii grow to at least half the chord) of the start point */
+      double dx = v[5] + ox - cx, dy = v[6] + oy - cy;
+      double rx = (v[0] < 0.0) ? -v[0] : v[0], ry = (v[1] < 0.0) ? -v[1] : v[1];
+      double pad = 2.0 * ((rx > ry) ? rx : ry) + ((dx < 0.0) ? -dx : dx) + ((dy < 0.0) ? -dy : dy);
+      vgg_bounds_include(bounds, cx - pad, cy - pad);
+      vgg_bounds_include(bounds, cx + pad, cy + pad);
+      cx = v[5] + ox;
+      cy = v[6] + oy;
+    }
+    else
+    {
+      for (i = 0; i < count; i += 2)
+      {
+        vgg_bounds_include(bounds, ox + v[i], oy + v[i + 1]);
+      }
+      cx = ox + v[count - 2];
+      cy = oy + v[count - 1];
+    }
+
+    vgg_bounds_include(bounds, cx, cy);
+    any = 1;
+
+    if (upper == 'M')
+    {
+      /* Further coordinate pairs are implicit line to commands */
+      start_x = cx;
+      start_y = cy;
+      command = (command == 'm') ? 'l' : 'L';
+    }
+  }
+
+  return any;
+}
+
+/* Bounds of an element, returns 0 if unknown (text, unparsable path) */
+VGG_API VGG_INLINE int vgg_bounds_element(vgg_header *header, vgg_bounds *bounds)
+{
+  *bounds = vgg_bounds_empty();
+
+  if (header->type == VGG_TYPE_RECT)
+  {
+    vgg_rect *rect = (vgg_rect *)header;
+    vgg_bounds_include(bounds, rect->x, rect->y);
+    vgg_bounds_include(bounds, rect->x + rect->width, rect->y + rect->height);
+  }
+  else if (header->type == VGG_TYPE_LINE)
+  {
+    vgg_line *line = (vgg_line *)header;
+    vgg_bounds_include(bounds, line->x1, line->y1);
+    vgg_bounds_include(bounds, line->x2, line->y2);
+  }
+  else if (header->type == VGG_TYPE_ELLIPSE)
+  {
+    vgg_ellipse *ellipse = (vgg_ellipse *)header;
+    vgg_bounds_include(bounds, ellipse->cx - ellipse->rx, ellipse->cy - ellipse->ry);
+    vgg_bounds_include(bounds, ellipse->cx + ellipse->rx, ellipse->cy + ellipse->ry);
+  }
+  else if (header->type == VGG_TYPE_CIRCLE)
+  {
+    vgg_circle *circle = (vgg_circle *)header;
+    vgg_bounds_include(bounds, circle->cx - circle->r, circle->cy - circle->r);
+    vgg_bounds_include(bounds, circle->cx + circle->r, circle->cy + circle->r);
+  }
+  else if (header->type == VGG_TYPE_PATH)
+  {
+    return vgg_bounds_path(((vgg_path *)header)->d, bounds);
+  }
+  else
+  {
+    return 0;
+  }
+
+  return 1;
+}
+
+/* Opt-in viewport culling: elements entirely outside w->cull_viewport are skipped
+   and counted in w->culled. Elements with unknown bounds (text) are always written.
+*/
+VGG_API VGG_INLINE void vgg_svg_cull(vgg_svg_writer *w, int enabled)
+{
+  w->cull = enabled;
+}
+
+/* Returns 1 (and counts it) if bounds are outside the viewport */
+VGG_API VGG_INLINE int vgg_svg_cull_bounds(vgg_svg_writer *w, vgg_bounds *bounds)
+{
+  if (vgg_bounds_overlap(bounds, &w->cull_viewport))
+  {
+    return 0;
+  }
+  w->culled++;
+  return 1;
+}
+
+/* Culling test of the box spanned by two corners */
+VGG_API VGG_INLINE int vgg_svg_cull_box(vgg_svg_writer *w, double x0, double y0, double x1, double y1)
+{
+  vgg_bounds bounds = vgg_bounds_empty();
+  vgg_bounds_include(&bounds, x0, y0);
+  vgg_bounds_include(&bounds, x1, y1);
+  return vgg_svg_cull_bounds(w, &bounds);
+}
+
+VGG_API VGG_INLINE int vgg_svg_cull_element(vgg_svg_writer *w, vgg_header *header)
+{
+  vgg_bounds bounds;
+  return w->cull && vgg_bounds_element(header, &bounds) && vgg_svg_cull_bounds(w, &bounds);
+}
+
+/* Unchecked element writers, each ends with a separating space */
+VGG_API VGG_INLINE char *vgg_svg_raw_rect(char *p, double x, double y, double width, double height)
+{
+  p = VGG_SVG_RAW_LITERAL(p, "  <rect x=\"");
+  p = vgg_svg_raw_double(p, x);
+  p = VGG_SVG_RAW_LITERAL(p, "\" y=\"");
+  p = vgg_svg_raw_double(p, y);
+  p = VGG_SVG_RAW_LITERAL(p, "\" width=\"");
+  p = vgg_svg_raw_double(p, width);
+  p = VGG_SVG_RAW_LITERAL(p, "\" height=\"");
+  p = vgg_svg_raw_double(p, height);
+  return VGG_SVG_RAW_LITERAL(p, "\" ");
+}
+
+VGG_API VGG_INLINE char *vgg_svg_raw_line(char *p, double x1, double y1, double x2, double y2)
+{
+  p = VGG_SVG_RAW_LITERAL(p, "  <line x1=\"");
+  p = vgg_svg_raw_double(p, x1);
+  p = VGG_SVG_RAW_LITERAL(p, "\" y1=\"");
+  p = vgg_svg_raw_double(p, y1);
+  p = VGG_SVG_RAW_LITERAL(p, "\" x2=\"");
+  p = vgg_svg_raw_double(p, x2);
+  p = VGG_SVG_RAW_LITERAL(p, "\" y2=\"");
+  p = vgg_svg_raw_double(p, y2);
+  return VGG_SVG_RAW_LITERAL(p, "\" ");
+}
+
+VGG_API VGG_INLINE char *vgg_svg_raw_ellipse(char *p, double cx, double cy, double rx, double ry)
+{
+  p = VGG_SVG_RAW_LITERAL(p, "  <ellipse cx=\"");
+  p = vgg_svg_raw_double(p, cx);
+  p = VGG_SVG_RAW_LITERAL(p, "\" cy=\"");
+  p = vgg_svg_raw_double(p, cy);
+  p = VGG_SVG_RAW_LITERAL(p, "\" rx=\"");
+  p = vgg_svg_raw_double(p, rx);
+  p = VGG_SVG_RAW_LITERAL(p, "\" ry=\"");
+  p = vgg_svg_raw_double(p, ry);
+  return VGG_SVG_RAW_LITERAL(p, "\" ");
+}
+
+VGG_API VGG_INLINE char *vgg_svg_raw_circle(char *p, double cx, double cy, double r)
+{
+  p = VGG_SVG_RAW_LITERAL(p, "  <circle cx=\"");
+  p = vgg_svg_raw_double(p, cx);
+  p = VGG_SVG_RAW_LITERAL(p, "\" cy=\"");
+  p = vgg_svg_raw_double(p, cy);
+  p = VGG_SVG_RAW_LITERAL(p, "\" r=\"");
+  p = vgg_svg_raw_double(p, r);
+  return VGG_SVG_RAW_LITERAL(p, "\" ");
+}
+
+VGG_API VGG_INLINE char *vgg_svg_raw_text(char *p, double x, double y)
+{
+  p = VGG_SVG_RAW_LITERAL(p, "  <text x=\"");
+  p = vgg_svg_raw_double(p, x);
+  p = VGG_SVG_RAW_LITERAL(p, "\" y=\"");
+  p = vgg_svg_raw_double(p, y);
+  return VGG_SVG_RAW_LITERAL(p, "\" ");
+}
+
+VGG_API VGG_INLINE char *vgg_svg_raw_path(char *p, char *d)
+{
+  p = VGG_SVG_RAW_LITERAL(p, "  <path d=\"");
+  p = vgg_svg_raw_string(p, d);
+  return VGG_SVG_RAW_LITERAL(p, "\" ");
+}
+
+/* id, fill color and data fields shared by all elements */
+VGG_API VGG_INLINE char *vgg_svg_raw_attributes(char *p, vgg_svg_style *style, unsigned int id, vgg_color color_fill, vgg_data_field *data_fields, unsigned int data_fields_count)
+{
+  unsigned int i;
+
+  p = VGG_SVG_RAW_LITERAL(p, "id=\"");
+  p = vgg_svg_raw_uint(p, id);
+  p = VGG_SVG_RAW_LITERAL(p, "\" ");
+  p = vgg_svg_raw_fill(p, style, color_fill);
+
+  for (i = 0; i < data_fields_count; ++i)
+  {
+    p = VGG_SVG_RAW_LITERAL(p, "data-");
+    p = vgg_svg_raw_string(p, data_fields[i].key);
+    p = VGG_SVG_RAW_LITERAL(p, "=\"");
+    p = vgg_svg_raw_string(p, data_fields[i].value);
+    p = VGG_SVG_RAW_LITERAL(p, "\" ");
+  }
+
+  return p;
+}
+
+/* Number of characters of a string literal */
+#define VGG_SVG_LITERAL_SIZE(s) ((int)sizeof(s) - 1)
+
+/* Exact number of characters vgg_svg_element_add writes for an element that is not culled.
+   Used by measuring writers, registers the fill color like vgg_svg_raw_fill if w interns styles.
+*/
+VGG_API VGG_INLINE int vgg_svg_element_size(vgg_svg_writer *w, vgg_header *header)
+{
+  int size = 0, index;
+  unsigned int i;
+
+  if (header->type == VGG_TYPE_RECT)
+  {
+    vgg_rect *rect = (vgg_rect *)header;
+    size = VGG_SVG_LITERAL_SIZE("  <rect x=\"\" y=\"\" width=\"\" height=\"\" ");
+    size += vgg_fmt_double_size(rect->x, VGG_SVG_DOUBLE_PRECISION, 1) + vgg_fmt_double_size(rect->y, VGG_SVG_DOUBLE_PRECISION, 1);
+    size += vgg_fmt_double_size(rect->width, VGG_SVG_DOUBLE_PRECISION, 1) + vgg_fmt_double_size(rect->height, VGG_SVG_DOUBLE_PRECISION, 1);
+  }
+  else if (header->type == VGG_TYPE_LINE)
+  {
+    vgg_line *line = (vgg_line *)header;
+    size = VGG_SVG_LITERAL_SIZE("  <line x1=\"\" y1=\"\" x2=\"\" y2=\"\" ");
+    size += vgg_fmt_double_size(line->x1, VGG_SVG_DOUBLE_PRECISION, 1) + vgg_fmt_double_size(line->y1, VGG_SVG_DOUBLE_PRECISION, 1);
+    size += vgg_fmt_double_size(line->x2, VGG_SVG_DOUBLE_PRECISION, 1) + vgg_fmt_double_size(line->y2, VGG_SVG_DOUBLE_PRECISION, 1);
+  }
+  else if (header->type == VGG_TYPE_ELLIPSE)
+  {
+    vgg_ellipse *ellipse = (vgg_ellipse *)header;
+    size = VGG_SVG_LITERAL_SIZE("  <ellipse cx=\"\" cy=\"\" rx=\"\" ry=\"\" ");
+    size += vgg_fmt_double_size(ellipse->cx, VGG_SVG_DOUBLE_PRECISION, 1) + vgg_fmt_double_size(ellipse->cy, VGG_SVG_DOUBLE_PRECISION, 1);
+    size += vgg_fmt_double_size(ellipse->rx, VGG_SVG_DOUBLE_PRECISION, 1) + vgg_fmt_double_size(ellipse->ry, VGG_SVG_DOUBLE_PRECISION, 1);
+  }
+  else if (header->type == VGG_TYPE_CIRCLE)
+  {
+    vgg_circle *circle = (vgg_circle *)header;
+    size = VGG_SVG_LITERAL_SIZE("  <circle cx=\"\" cy=\"\" r=\"\" ");
+    size += vgg_fmt_double_size(circle->cx, VGG_SVG_DOUBLE_PRECISION, 1) + vgg_fmt_double_size(circle->cy, VGG_SVG_DOUBLE_PRECISION, 1);
+    size += vgg_fmt_double_size(circle->r, VGG_SVG_DOUBLE_PRECISION, 1);
+  }
+  else if (header->type == VGG_TYPE_TEXT)
+  {
+    vgg_text *text = (vgg_text *)header;
+    size = VGG_SVG_LITERAL_SIZE("  <text x=\"\" y=\"\" >") + VGG_SVG_LITERAL_SIZE("</text>\n") - VGG_SVG_LITERAL_SIZE("/>\n");
+    size += vgg_fmt_double_size(text->x, VGG_SVG_DOUBLE_PRECISION, 1) + vgg_fmt_double_size(text->y, VGG_SVG_DOUBLE_PRECISION, 1);
+    size += vgg_svg_strlen(text->text);
+  }
+  else if (header->type == VGG_TYPE_PATH)
+  {
+    size = VGG_SVG_LITERAL_SIZE("  <path d=\"\" ") + vgg_svg_strlen(((vgg_path *)header)->d);
+  }
+
+  /* id="N" and the fill, the closing tag of text replaced "/>\n" above */
+  size += VGG_SVG_LITERAL_SIZE("id=\"\" ") + vgg_fmt_digit_count((unsigned long)header->id) + VGG_SVG_LITERAL_SIZE("/>\n");
+
+  if (w->style && (index = vgg_svg_style_intern(w->style, header->color_fill)) >= 0)
+  {
+    size += VGG_SVG_LITERAL_SIZE("class=\"c\" ") + vgg_fmt_digit_count((unsigned long)index);
+  }
+  else
+  {
+    size += VGG_SVG_LITERAL_SIZE("fill=\"#RRGGBB\" ");
+  }
+
+  for (i = 0; i < header->data_fields_count; ++i)
+  {
+    size += VGG_SVG_LITERAL_SIZE("data-=\"\" ") + vgg_svg_strlen(header->data_fields[i].key) + vgg_svg_strlen(header->data_fields[i].value);
+  }
+
+  return size;
+}
+
+/* Checked version of vgg_svg_raw_attributes */
+VGG_API VGG_INLINE void vgg_svg_put_attributes(vgg_svg_writer *w, vgg_header *header)
+{
+  char buf[32];
+  unsigned int i;
+
+  /* ID field */
+  vgg_svg_puts(w, "id=\"");
+  vgg_svg_put_uint(w, header->id);
+  vgg_svg_puts(w, "\" ");
+
+  /* Fill color */
+  vgg_svg_putn(w, buf, (int)(vgg_svg_raw_fill(buf, w->style, header->color_fill) - buf));
+
+  /* Data fields */
+  for (i = 0; i < header->data_fields_count; ++i)
+  {
+    vgg_svg_puts(w, "data-");
+    vgg_svg_puts(w, header->data_fields[i].key);
+    vgg_svg_puts(w, "=\"");
+    vgg_svg_puts(w, header->data_fields[i].value);
+    vgg_svg_puts(w, "\" ");
+  }
+}
+
+/* Writes the element byte by byte with a bounds check on every write.
+   Used by vgg_svg_element_add when the worst case size does not fit into the buffer.
+*/
+VGG_API VGG_INLINE void vgg_svg_element_add_checked(
+    vgg_svg_writer *w,
+    vgg_header *header)
+{
+  /* Open element tag */
+  vgg_svg_puts(w, "  <");
+
+  /* Rectangular Shape */
+  if (header->type == VGG_TYPE_RECT)
+  {
+    vgg_rect *rect = (vgg_rect *)header;
+
+    vgg_svg_puts(w, "rect ");
+
+    /* Rect x value */
+    vgg_svg_puts(w, "x=\"");
+    vgg_svg_put_double(w, rect->x);
+    vgg_svg_puts(w, "\" ");
+
+    /* Rect y value */
+    vgg_svg_puts(w, "y=\"");
+    vgg_svg_put_double(w, rect->y);
+    vgg_svg_puts(w, "\" ");
+
+    /* Rect width value */
+    vgg_svg_puts(w, "width=\"");
+    vgg_svg_put_double(w, rect->width);
+    vgg_svg_puts(w, "\" ");
+
+    /* Rect height value */
+    vgg_svg_puts(w, "height=\"");
+    vgg_svg_put_double(w, rect->height);
+    vgg_svg_puts(w, "\" ");
+  }
+  else if (header->type == VGG_TYPE_LINE)
+  {
+    vgg_line *line = (vgg_line *)header;
+
+    vgg_svg_puts(w, "line ");
+
+    vgg_svg_puts(w, "x1=\"");
+    vgg_svg_put_double(w, line->x1);
+    vgg_svg_puts(w, "\" ");
+
+    vgg_svg_puts(w, "y1=\"");
+    vgg_svg_put_double(w, line->y1);
+    vgg_svg_puts(w, "\" ");
+
+    vgg_svg_puts(w, "x2=\"");
+    vgg_svg_put_double(w, line->x2);
+    vgg_svg_puts(w, "\" ");
+
+    vgg_svg_puts(w, "y2=\"");
+    vgg_svg_put_double(w, line->y2);
+    vgg_svg_puts(w, "\" ");
+  }
+  else if (header->type == VGG_TYPE_ELLIPSE)
+  {
+    vgg_ellipse *ellipse = (vgg_ellipse *)header;
+
+    vgg_svg_puts(w, "ellipse ");
+
+    vgg_svg_puts(w, "cx=\"");
+    vgg_svg_put_double(w, ellipse->cx);
+    vgg_svg_puts(w, "\" ");
+
+    vgg_svg_puts(w, "cy=\"");
+    vgg_svg_put_double(w, ellipse->cy);
+    vgg_svg_puts(w, "\" ");
+
+    vgg_svg_puts(w, "rx=\"");
+    vgg_svg_put_double(w, ellipse->rx);
+    vgg_svg_puts(w, "\" ");
+
+    vgg_svg_puts(w, "ry=\"");
+    vgg_svg_put_double(w, ellipse->ry);
+    vgg_svg_puts(w, "\" ");
+  }
+  else if (header->type == VGG_TYPE_CIRCLE)
+  {
+    vgg_circle *circle = (vgg_circle *)header;
+
+    vgg_svg_puts(w, "circle ");
+
+    vgg_svg_puts(w, "cx=\"");
+    vgg_svg_put_double(w, circle->cx);
+    vgg_svg_puts(w, "\" ");
+
+    vgg_svg_puts(w, "cy=\"");
+    vgg_svg_put_double(w, circle->cy);
+    vgg_svg_puts(w, "\" ");
+
+    vgg_svg_puts(w, "r=\"");
+    vgg_svg_put_double(w, circle->r);
+    vgg_svg_puts(w, "\" ");
+  }
+  else if (header->type == VGG_TYPE_TEXT)
+  {
+    vgg_text *text = (vgg_text *)header;
+
+    vgg_svg_puts(w, "text ");
+
+    vgg_svg_puts(w, "x=\"");
+    vgg_svg_put_double(w, text->x);
+    vgg_svg_puts(w, "\" ");
+
+    vgg_svg_puts(w, "y=\"");
+    vgg_svg_put_double(w, text->y);
+    vgg_svg_puts(w, "\" ");
+  }
+  else if (header->type == VGG_TYPE_PATH)
+  {
+    vgg_path *path = (vgg_path *)header;
+
+    vgg_svg_puts(w, "path d=\"");
+
+    vgg_svg_puts(w, path->d);
+    vgg_svg_puts(w, "\" ");
+  }
+
+  vgg_svg_put_attributes(w, header);
+
+  if (header->type != VGG_TYPE_TEXT)
+  {
+    /* Closing element tag */
+    vgg_svg_puts(w, "/>\n");
+  }
+  else
+  {
+    vgg_text *text = (vgg_text *)header;
+    vgg_svg_puts(w, ">");
+    vgg_svg_puts(w, text->text);
+    vgg_svg_puts(w, "</text>\n");
+  }
+}
+
+VGG_API VGG_INLINE void vgg_svg_element_add(
+    vgg_svg_writer *w,
+    vgg_header *header)
+{
+  char *p;
+
+  if (vgg_svg_cull_element(w, header))
+  {
+    return;
+  }
+
+  VGG_SVG_STATS_MARK(w, 1);
+
+  /* Measuring writers only count */
+  if (!w->buffer)
+  {
+    w->length += vgg_svg_element_size(w, header);
+    VGG_SVG_STATS_ELEMENTS(w, header->type);
+    return;
+  }
+
+  /* Reserve the worst case once and write without bounds checks, coordinates beyond 2^53 are written checked */
+  p = vgg_svg_element_raw(header) ? vgg_svg_reserve(w, vgg_svg_element_size_max(header)) : 0;
+
+  if (!p)
+  {
+    vgg_svg_element_add_checked(w, header);
+    VGG_SVG_STATS_ELEMENTS(w, header->type);
+    return;
+  }
+
+  if (header->type == VGG_TYPE_RECT)
+  {
+    vgg_rect *rect = (vgg_rect *)header;
+    p = vgg_svg_raw_rect(p, rect->x, rect->y, rect->width, rect->height);
+  }
+  else if (header->type == VGG_TYPE_LINE)
+  {
+    vgg_line *line = (vgg_line *)header;
+    p = vgg_svg_raw_line(p, line->x1, line->y1, line->x2, line->y2);
+  }
+  else if (header->type == VGG_TYPE_ELLIPSE)
+  {
+    vgg_ellipse *ellipse = (vgg_ellipse *)header;
+    p = vgg_svg_raw_ellipse(p, ellipse->cx, ellipse->cy, ellipse->rx, ellipse->ry);
+  }
+  else if (header->type == VGG_TYPE_CIRCLE)
+  {
+    vgg_circle *circle = (vgg_circle *)header;
+    p = vgg_svg_raw_circle(p, circle->cx, circle->cy, circle->r);
+  }
+  else if (header->type == VGG_TYPE_TEXT)
+  {
+    vgg_text *text = (vgg_text *)header;
+    p = vgg_svg_raw_text(p, text->x, text->y);
+  }
+  else if (header->type == VGG_TYPE_PATH)
+  {
+    vgg_path *path = (vgg_path *)header;
+    p = vgg_svg_raw_path(p, path->d);
+  }
+
+  p = vgg_svg_raw_attributes(p, w->style, header->id, header->color_fill, header->data_fields, header->data_fields_count);
+
+  if (header->type != VGG_TYPE_TEXT)
+  {
+    p = VGG_SVG_RAW_LITERAL(p, "/>\n");
+  }
+  else
+  {
+    p = VGG_SVG_RAW_LITERAL(p, ">");
+    p = vgg_svg_raw_string(p, ((vgg_text *)header)->text);
+    p = VGG_SVG_RAW_LITERAL(p, "</text>\n");
+  }
+
+  vgg_svg_commit(w, p);
+  VGG_SVG_STATS_ELEMENTS(w, header->type);
+}
+
+/* Batch emitters for columnar data.
+   Element i of a batch is written exactly like vgg_svg_element_add would write a header with
+   id = id_first + i, color_fill = color_fill[i] (black if color_fill is 0) and no data fields.
+*/
+
+/* Reserves room for the elements [first, count) of at most size bytes each.
+   Returns the end of the elements that fit, first if not even one fits.
+*/
+VGG_API VGG_INLINE unsigned int vgg_svg_reserve_batch(vgg_svg_writer *w, int size, unsigned int first, unsigned int count)
+{
+  unsigned int fit;
+
+  if (!vgg_svg_reserve(w, size))
+  {
+    return first;
+  }
+
+  fit = (unsigned int)((w->capacity - w->length) / size);
+  return (count - first < fit) ? count : first + fit;
+}
+
+VGG_API VGG_INLINE void vgg_svg_header_init(vgg_header *header, vgg_header_type type, unsigned int id, vgg_color *color_fill)
+{
+  header->type = type;
+  header->id = id;
+  header->data_fields = 0;
+  header->data_fields_count = 0;
+  header->color_fill.r = color_fill ? color_fill->r : 0;
+  header->color_fill.g = color_fill ? color_fill->g : 0;
+  header->color_fill.b = color_fill ? color_fill->b : 0;
+}
+
+VGG_API VGG_INLINE void vgg_svg_rects_add(
+    vgg_svg_writer *w,
+    unsigned int count,
+    unsigned int id_first,
+    double *x, double *y, double *width, double *height,
+    vgg_color *color_fill)
+{
+  int size = VGG_SVG_ELEMENT_TAGS_SIZE_MAX + VGG_SVG_UINT_SIZE_MAX + 6 + 4 * VGG_SVG_DOUBLE_SIZE_MAX;
+  vgg_color black = {0, 0, 0};
+  unsigned int i = 0, end;
+  char *p;
+
+  while (i < count)
+  {
+    end = vgg_svg_reserve_batch(w, size, i, count);
+    end = vgg_svg_raw_end(x, y, width, height, i, end);
+
+    if (end == i)
+    {
+      /* Not enough room for the worst case or coordinates beyond 2^53, write byte by byte */
+      vgg_rect rect;
+      vgg_svg_header_init(&rect.header, VGG_TYPE_RECT, id_first + i, color_fill ? &color_fill[i] : 0);
+      rect.x = x[i];
+      rect.y = y[i];
+      rect.width = width[i];
+      rect.height = height[i];
+      vgg_svg_element_add(w, (vgg_header *)&rect);
+      i++;
+      continue;
+    }
+
+    VGG_SVG_STATS_MARK(w, end - i);
+    p = (char *)(w->buffer + w->length);
+    for (; i < end; ++i)
+    {
+      if (w->cull && vgg_svg_cull_box(w, x[i], y[i], x[i] + width[i], y[i] + height[i]))
+      {
+        continue;
+      }
+      p = vgg_svg_raw_rect(p, x[i], y[i], width[i], height[i]);
+      p = vgg_svg_raw_attributes(p, w->style, id_first + i, color_fill ? color_fill[i] : black, 0, 0);
+      p = VGG_SVG_RAW_LITERAL(p, "/>\n");
+    }
+    vgg_svg_commit(w, p);
+    VGG_SVG_STATS_ELEMENTS(w, VGG_TYPE_RECT);
+  }
+}
+
+/* Rects whose fill is looked up in a colormap from values[i], the pre-rendered hex string is copied */
+VGG_API VGG_INLINE void vgg_svg_rects_add_colormap(
+    vgg_svg_writer *w,
+    unsigned int count,
+    unsigned int id_first,
+    double *x, double *y, double *width, double *height,
+    double *values,
+    vgg_colormap *map)
+{
+  int size = VGG_SVG_ELEMENT_TAGS_SIZE_MAX + VGG_SVG_UINT_SIZE_MAX + 6 + 4 * VGG_SVG_DOUBLE_SIZE_MAX;
+  unsigned int i = 0, end;
+  char *p;
+
+  while (i < count)
+  {
+    end = vgg_svg_reserve_batch(w, size, i, count);
+    end = vgg_svg_raw_end(x, y, width, height, i, end);
+
+    if (end == i)
+    {
+      /* Not enough room for the worst case or coordinates beyond 2^53, write byte by byte */
+      vgg_rect rect;
+      vgg_svg_header_init(&rect.header, VGG_TYPE_RECT, id_first + i, &map->colors[vgg_colormap_index(map, values[i])]);
+      rect.x = x[i];
+      rect.y = y[i];
+      rect.width = width[i];
+      rect.height = height[i];
+      vgg_svg_element_add(w, (vgg_header *)&rect);
+      i++;
+      continue;
+    }
+
+    VGG_SVG_STATS_MARK(w, end - i);
+    p = (char *)(w->buffer + w->length);
+    for (; i < end; ++i)
+    {
+      if (w->cull && vgg_svg_cull_box(w, x[i], y[i], x[i] + width[i], y[i] + height[i]))
+      {
+        continue;
+      }
+      p = vgg_svg_raw_rect(p, x[i], y[i], width[i], height[i]);
+      p = VGG_SVG_RAW_LITERAL(p, "id=\"");
+      p = vgg_svg_raw_uint(p, id_first + i);
+      p = VGG_SVG_RAW_LITERAL(p, "\" ");
+      if (w->style)
+      {
+        p = vgg_svg_raw_fill(p, w->style, map->colors[vgg_colormap_index(map, values[i])]);
+      }
+      else
+      {
+        p = VGG_SVG_RAW_LITERAL(p, "fill=\"#");
+        p = vgg_svg_raw_copy(p, map->hex[vgg_colormap_index(map, values[i])], 6);
+        p = VGG_SVG_RAW_LITERAL(p, "\" ");
+      }
+      p = VGG_SVG_RAW_LITERAL(p, "/>\n");
+    }
+    vgg_svg_commit(w, p);
+    VGG_SVG_STATS_ELEMENTS(w, VGG_TYPE_RECT);
+  }
+}
+
+VGG_API VGG_INLINE void vgg_svg_circles_add(
+    vgg_svg_writer *w,
+    unsigned int count,
+    unsigned int id_first,
+    double *cx, double *cy, double *r,
+    vgg_color *color_fill)
+{
+  int size = VGG_SVG_ELEMENT_TAGS_SIZE_MAX + VGG_SVG_UINT_SIZE_MAX + 6 + 3 * VGG_SVG_DOUBLE_SIZE_MAX;
+  vgg_color black = {0, 0, 0};
+  unsigned int i = 0, end;
+  char *p;
+
+  while (i < count)
+  {
+    end = vgg_svg_reserve_batch(w, size, i, count);
+    end = vgg_svg_raw_end(cx, cy, r, 0, i, end);
+
+    if (end == i)
+    {
+      /* Not enough room for the worst case or coordinates beyond 2^53, write byte by byte */
+      vgg_circle circle;
+      vgg_svg_header_init(&circle.header, VGG_TYPE_CIRCLE, id_first + i, color_fill ? &color_fill[i] : 0);
+      circle.cx = cx[i];
+      circle.cy = cy[i];
+      circle.r = r[i];
+      vgg_svg_element_add(w, (vgg_header *)&circle);
+      i++;
+      continue;
+    }
+
+    VGG_SVG_STATS_MARK(w, end - i);
+    p = (char *)(w->buffer + w->length);
+    for (; i < end; ++i)
+    {
+      if (w->cull && vgg_svg_cull_box(w, cx[i] - r[i], cy[i] - r[i], cx[i] + r[i], cy[i] + r[i]))
+      {
+        continue;
+      }
+      p = vgg_svg_raw_circle(p, cx[i], cy[i], r[i]);
+      p = vgg_svg_raw_attributes(p, w->style, id_first + i, color_fill ? color_fill[i] : black, 0, 0);
+      p = VGG_SVG_RAW_LITERAL(p, "/>\n");
+    }
+    vgg_svg_commit(w, p);
+    VGG_SVG_STATS_ELEMENTS(w, VGG_TYPE_CIRCLE);
+  }
+}
+
+VGG_API VGG_INLINE void vgg_svg_lines_add(
+    vgg_svg_writer *w,
+    unsigned int count,
+    unsigned int id_first,
+    double *x1, double *y1, double *x2, double *y2,
+    vgg_color *color_fill)
+{
+  int size = VGG_SVG_ELEMENT_TAGS_SIZE_MAX + VGG_SVG_UINT_SIZE_MAX + 6 + 4 * VGG_SVG_DOUBLE_SIZE_MAX;
+  vgg_color black = {0, 0, 0};
+  unsigned int i = 0, end;
+  char *p;
+
+  while (i < count)
+  {
+    end = vgg_svg_reserve_batch(w, size, i, count);
+    end = vgg_svg_raw_end(x1, y1, x2, y2, i, end);
+
+    if (end == i)
+    {
+      /* Not enough room for the worst case or coordinates beyond 2^53, write byte by byte */
+      vgg_line line;
+      vgg_svg_header_init(&line.header, VGG_TYPE_LINE, id_first + i, color_fill ? &color_fill[i] : 0);
+      line.x1 = x1[i];
+      line.y1 = y1[i];
+      line.x2 = x2[i];
+      line.y2 = y2[i];
+      vgg_svg_element_add(w, (vgg_header *)&line);
+      i++;
+      continue;
+    }
+
+    VGG_SVG_STATS_MARK(w, end - i);
+    p = (char *)(w->buffer + w->length);
+    for (; i < end; ++i)
+    {
+      if (w->cull && vgg_svg_cull_box(w, x1[i], y1[i], x2[i], y2[i]))
+      {
+        continue;
+      }
+      p = vgg_svg_raw_line(p, x1[i], y1[i], x2[i], y2[i]);
+      p = vgg_svg_raw_attributes(p, w->style, id_first + i, color_fill ? color_fill[i] : black, 0, 0);
+      p = VGG_SVG_RAW_LITERAL(p, "/>\n");
+    }
+    vgg_svg_commit(w, p);
+    VGG_SVG_STATS_ELEMENTS(w, VGG_TYPE_LINE);
+  }
+}
+
+/* Heap sort, no recursion and no scratch memory */
+VGG_API VGG_INLINE void vgg_sort_uint(unsigned int *values, unsigned int count)
+{
+  unsigned int start = count / 2, end = count;
+
+  while (end > 1)
+  {
+    unsigned int root, child, swap;
+
+    if (start > 0)
+    {
+      start--;
+    }
+    else
+    {
+      end--;
+      swap = values[end];
+      values[end] = values[0];
+      values[0] = swap;
+    }
+
+    /* Sift down */
+    for (root = start; (child = 2 * root + 1) < end; root = child)
+    {
+      if (child + 1 < end && values[child] < values[child + 1])
+      {
+        child++;
+      }
+      if (values[root] >= values[child])
+      {
+        break;
+      }
+      swap = values[root];
+      values[root] = values[child];
+      values[child] = swap;
+    }
+  }
+}
+
+/* Uniform grid over the bounds of elements for viewport queries on large scenes.
+   Each element is binned by the cell of its center, queries widen the viewport by the largest
+   half extent so elements reaching in from neighbouring cells are found too.
+   Elements far larger than a cell (or with unknown bounds) make every query scan more cells.
+*/
+typedef struct vgg_grid
+{
+  vgg_bounds area; /* Area covered by the cells, elements outside go to the border cells */
+  unsigned int columns;
+  unsigned int rows;
+  double scale_x; /* Cells per unit */
+  double scale_y;
+  double extent_x; /* Largest half width and height of an element */
+  double extent_y;
+  unsigned int *cells; /* columns * rows + 1 offsets into items */
+  unsigned int *items; /* Element indices ordered by cell */
+
+} vgg_grid;
+
+VGG_API VGG_INLINE unsigned int vgg_grid_cell(double value, double origin, double scale, unsigned int cells)
+{
+  double cell = (value - origin) * scale;
+
+  /* Also catches NaN before the conversion */
+  if (!(cell >= 0.0))
+  {
+    return 0;
+  }
+  return (cell >= (double)cells) ? cells - 1 : (unsigned int)cell;
+}
+
+/* Counting sort of the elements into the cells, cells needs columns * rows + 1 and items count entries */
+VGG_API VGG_INLINE void vgg_grid_build(
+    vgg_grid *grid,
+    vgg_bounds *bounds, unsigned int count,
+    vgg_bounds area, unsigned int columns, unsigned int rows,
+    unsigned int *cells, unsigned int *items)
+{
+  unsigned int cell_count = columns * rows;
+  unsigned int i;
+
+  grid->area = area;
+  grid->columns = columns;
+  grid->rows = rows;
+  grid->scale_x = (double)columns / (area.x1 - area.x0);
+  grid->scale_y = (double)rows / (area.y1 - area.y0);
+  grid->extent_x = 0.0;
+  grid->extent_y = 0.0;
+  grid->cells = cells;
+  grid->items = items;
+
+  for (i = 0; i <= cell_count; ++i)
+  {
+    cells[i] = 0;
+  }
+
+  for (i = 0; i < count; ++i)
+  {
+    double half_width = (bounds[i].x1 - bounds[i].x0) * 0.5;
+    double half_height = (bounds[i].y1 - bounds[i].y0) * 0.5;
+    unsigned int column = vgg_grid_cell(bounds[i].x0 + half_width, area.x0, grid->scale_x, columns);
+    unsigned int row = vgg_grid_cell(bounds[i].y0 + half_height, area.y0, grid->scale_y, rows);
+
+    grid->extent_x = (half_width > grid->extent_x) ? half_width : grid->extent_x;
+    grid->extent_y = (half_height > grid->extent_y) ? half_height : grid->extent_y;
+    cells[row * columns + column]++;
+  }
+
+  /* End of each cell, filling backwards turns it into the start and keeps the element order */
+  for (i = 1; i <= cell_count; ++i)
+  {
+    cells[i] += cells[i - 1];
+  }
+
+  for (i = count; i-- > 0;)
+  {
+    double half_width = (bounds[i].x1 - bounds[i].x0) * 0.5;
+    double half_height = (bounds[i].y1 - bounds[i].y0) * 0.5;
+    unsigned int column = vgg_grid_cell(bounds[i].x0 + half_width, area.x0, grid->scale_x, columns);
+    unsigned int row = vgg_grid_cell(bounds[i].y0 + half_height, area.y0, grid->scale_y, rows);
+
+    items[--cells[row * columns + column]] = i;
+  }
+}
+
+/* Writes the indices of the elements overlapping view to out in ascending (paint) order.
+   Returns their number, out needs room for all elements in the worst case.
+*/
+VGG_API VGG_INLINE unsigned int vgg_grid_query(vgg_grid *grid, vgg_bounds *bounds, vgg_bounds view, unsigned int *out)
+{
+  unsigned int column_first = vgg_grid_cell(view.x0 - grid->extent_x, grid->area.x0, grid->scale_x, grid->columns);
+  unsigned int column_last = vgg_grid_cell(view.x1 + grid->extent_x, grid->area.x0, grid->scale_x, grid->columns);
+  unsigned int row_first = vgg_grid_cell(view.y0 - grid->extent_y, grid->area.y0, grid->scale_y, grid->rows);
+  unsigned int row_last = vgg_grid_cell(view.y1 + grid->extent_y, grid->area.y0, grid->scale_y, grid->rows);
+  unsigned int row, column, k, n = 0;
+
+  for (row = row_first; row <= row_last; ++row)
+  {
+    for (column = column_first; column <= column_last; ++column)
+    {
+      unsigned int cell = row * grid->columns + column;
+
+      for (k = grid->cells[cell]; k < grid->cells[cell + 1]; ++k)
+      {
+        if (vgg_bounds_overlap(&bounds[grid->items[k]], &view))
+        {
+          out[n++] = grid->items[k];
+        }
+      }
+    }
+  }
+
+  vgg_sort_uint(out, n);
+  return n;
+}
+
+/* Level of detail for dense point sets: points are aggregated into square bins of a grid over the
+   document area in one streaming pass, and one element per non-empty bin is written, so the output
+   size is bounded by the canvas resolution instead of the number of points.
+*/
+typedef struct vgg_bins
+{
+  vgg_bounds area; /* Covered by the bins, usually w->cull_viewport after vgg_svg_start */
+  double cell_size;
+  unsigned int columns;
+  unsigned int rows;
+  unsigned int *counts; /* columns * rows */
+  double *sums;         /* Optional columns * rows sums of the point values, 0 to count only */
+  unsigned long points; /* Points added */
+  unsigned long dropped; /* Points outside the area (or NaN) */
+
+} vgg_bins;
+
+/* Columns * rows of square bins of cell_size covering area, the size of counts and sums.
+   0 if the area is empty or needs more than 0xFFFFFFFF bins, so the count fits a 32-bit unsigned long.
+*/
+VGG_API VGG_INLINE unsigned long vgg_bins_cells(vgg_bounds area, double cell_size)
+{
+  double columns = (area.x1 - area.x0) / cell_size, rows = (area.y1 - area.y0) / cell_size;
+  unsigned long c, r;
+
+  if (!(columns > 0.0) || !(rows > 0.0) || columns > 65536.0 || rows > 65536.0)
+  {
+    return 0;
+  }
+
+  c = (unsigned long)columns;
+  r = (unsigned long)rows;
+  c += ((double)c < columns);
+  r += ((double)r < rows);
+  return (r > 0xFFFFFFFFUL / c) ? 0 : c * r;
+}
+
+/* Zeroes counts (and sums) of vgg_bins_cells(area, cell_size) entries */
+VGG_API VGG_INLINE void vgg_bins_init(vgg_bins *bins, vgg_bounds area, double cell_size, unsigned int *counts, double *sums)
+{
+  unsigned long i, cells = vgg_bins_cells(area, cell_size);
+  double columns = (area.x1 - area.x0) / cell_size;
+
+  bins->area = area;
+  bins->cell_size = cell_size;
+  bins->columns = cells ? (unsigned int)columns + ((double)(unsigned int)columns < columns) : 0;
+  bins->rows = cells ? (unsigned int)(cells / bins->columns) : 0;
+  bins->counts = counts;
+  bins->sums = sums;
+  bins->points = 0;
+  bins->dropped = 0;
+
+  for (i = 0; i < cells; ++i)
+  {
+    counts[i] = 0;
+  }
+  for (i = 0; sums && i < cells; ++i)
+  {
+    sums[i] = 0.0;
+  }
+}
+
+/* Adds count points, values (summed per bin) may be 0 */
+VGG_API VGG_INLINE void vgg_bins_add(vgg_bins *bins, double *x, double *y, double *values, unsigned int count)
+{
+  double scale = 1.0 / bins->cell_size, columns = (double)bins->columns, rows = (double)bins->rows;
+  double x0 = bins->area.x0, y0 = bins->area.y0;
+  unsigned int i;
+
+  for (i = 0; i < count; ++i)
+  {
+    double column = (x[i] - x0) * scale;
+    double row = (y[i] - y0) * scale;
+    unsigned int cell;
+
+    /* Also catches NaN */
+    if (!(column >= 0.0 && column < columns && row >= 0.0 && row < rows))
+    {
+      bins->dropped++;
+      continue;
+    }
+
+    cell = (unsigned int)row * bins->columns + (unsigned int)column;
+    bins->counts[cell]++;
+    if (bins->sums && values)
+    {
+      bins->sums[cell] += values[i];
+    }
+  }
+
+  bins->points += count;
+}
+
+/* Writes one element per non-empty bin, colored by vgg_color_map_linear from color_start (smallest)
+   to color_end (largest) by the point count or, with use_mean and sums, the mean point value.
+   VGG_TYPE_RECT fills the bin, VGG_TYPE_CIRCLE is inscribed. Returns the number of elements written.
+*/
+VGG_API VGG_INLINE unsigned int vgg_bins_write(
+    vgg_svg_writer *w,
+    vgg_bins *bins,
+    vgg_header_type shape,
+    int use_mean,
+    vgg_color color_start,
+    vgg_color color_end,
+    unsigned int id_first)
+{
+  unsigned long i, cells = (unsigned long)bins->columns * (unsigned long)bins->rows;
+  double value_min = 0.0, value_max = 0.0, half = bins->cell_size * 0.5;
+  unsigned int n = 0;
+  int any = 0;
+  vgg_rect rect;
+  vgg_circle circle;
+
+  use_mean = use_mean && bins->sums;
+
+  /* Range of the non-empty bins, bounded by the canvas resolution */
+  for (i = 0; i < cells; ++i)
+  {
+    double value;
+
+    if (!bins->counts[i])
+    {
+      continue;
+    }
+
+    value = use_mean ? bins->sums[i] / (double)bins->counts[i] : (double)bins->counts[i];
+    value_min = (!any || value < value_min) ? value : value_min;
+    value_max = (!any || value > value_max) ? value : value_max;
+    any = 1;
+  }
+
+  for (i = 0; i < cells; ++i)
+  {
+    double x, y, value;
+    vgg_color color;
+
+    if (!bins->counts[i])
+    {
+      continue;
+    }
+
+    value = use_mean ? bins->sums[i] / (double)bins->counts[i] : (double)bins->counts[i];
+    color = vgg_color_map_linear(value, value_min, value_max, color_start, color_end);
+    x = bins->area.x0 + (double)(i % bins->columns) * bins->cell_size;
+    y = bins->area.y0 + (double)(i / bins->columns) * bins->cell_size;
+
+    if (shape == VGG_TYPE_CIRCLE)
+    {
+      vgg_svg_header_init(&circle.header, VGG_TYPE_CIRCLE, id_first + n, &color);
+      circle.cx = x + half;
+      circle.cy = y + half;
+      circle.r = half;
+      vgg_svg_element_add(w, &circle.header);
+    }
+    else
+    {
+      vgg_svg_header_init(&rect.header, VGG_TYPE_RECT, id_first + n, &color);
+      rect.x = x;
+      rect.y = y;
+      rect.width = bins->cell_size;
+      rect.height = bins->cell_size;
+      vgg_svg_element_add(w, &rect.header);
+    }
+    n++;
+  }
+
+  return n;
+}
+
+/* Polyline simplification, no allocations: the caller provides the scratch memory.
+   Both return the number of points written to out_x, out_y which may alias x, y (in place).
+*/
+
+/* Ramer-Douglas-Peucker: keeps the points farther than tolerance (e.g. one pixel in user units)
+   from the simplified line. Needs the scratch memory stack[2 * count] and keep[count].
+*/
+VGG_API VGG_INLINE unsigned int vgg_simplify_rdp(
+    double *x, double *y, unsigned int count,
+    double tolerance,
+    unsigned int *stack, unsigned char *keep,
+    double *out_x, double *out_y)
+{
+  double tolerance_sq = tolerance * tolerance;
+  unsigned int top = 0, n = 0, i;
+
+  if (count < 3)
+  {
+    for (i = 0; i < count; ++i)
+    {
+      out_x[i] = x[i];
+      out_y[i] = y[i];
+    }
+    return count;
+  }
+
+  for (i = 0; i < count; ++i)
+  {
+    keep[i] = 0;
+  }
+  keep[0] = 1;
+  keep[count - 1] = 1;
+
+  /* Segments still to split, at most one per interior point */
+  stack[top++] = 0;
+  stack[top++] = count - 1;
+
+  while (top)
+  {
+    unsigned int last = stack[--top];
+    unsigned int first = stack[--top];
+    unsigned int index = first;
+    double dx = x[last] - x[first];
+    double dy = y[last] - y[first];
+    double length_sq = dx * dx + dy * dy;
+    double distance_max = tolerance_sq;
+
+    for (i = first + 1; i < last; ++i)
+    {
+      double px = x[i] - x[first];
+      double py = y[i] - y[first];
+      double distance;
+
+      /* Distance to the segment, to the point if first and last coincide */
+      if (length_sq > 0.0)
+      {
+        double t = (px * dx + py * dy) / length_sq;
+        t = (t < 0.0) ? 0.0 : (t > 1.0 ? 1.0 : t);
+        px -= t * dx;
+        py -= t * dy;
+      }
+
+      distance = px * px + py * py;
+      if (distance > distance_max)
+      {
+        distance_max = distance;
+        index = i;
+      }
+    }
+
+    if (index != first)
+    {
+      keep[index] = 1;
+      if (index - first > 1)
+      {
+        stack[top++] = first;
+        stack[top++] = index;
+      }
+      if (last - index > 1)
+      {
+        stack[top++] = index;
+        stack[top++] = last;
+      }
+    }
+  }
+
+  for (i = 0; i < count; ++i)
+  {
+    if (keep[i])
+    {
+      out_x[n] = x[i];
+      out_y[n] = y[i];
+      n++;
+    }
+  }
+
+  return n;
+}
+
+/* Min/max decimation for ascending x: of all points within a pixel column of column_width
+   (starting at x_min) only the first, the minimum, the maximum and the last are kept.
+   The drawn envelope stays the same. Linear time, at most 4 points per column.
+*/
+VGG_API VGG_INLINE unsigned int vgg_simplify_minmax(
+    double *x, double *y, unsigned int count,
+    double x_min, double column_width,
+    double *out_x, double *out_y)
+{
+  double column_scale = 1.0 / column_width;
+  unsigned int i = 0, n = 0;
+
+  while (i < count)
+  {
+    long column = (long)((x[i] - x_min) * column_scale);
+    unsigned int picked[4];
+    unsigned int first = i, low = i, high = i, picked_count = 0, j;
+    double picked_x[4], picked_y[4];
+
+    for (++i; i < count && (long)((x[i] - x_min) * column_scale) == column; ++i)
+    {
+      if (y[i] < y[low])
+      {
+        low = i;
+      }
+      if (y[i] > y[high])
+      {
+        high = i;
+      }
+    }
+
+    /* Keep the original order, skip duplicates */
+    picked[0] = first;
+    picked[1] = (low < high) ? low : high;
+    picked[2] = (low < high) ? high : low;
+    picked[3] = i - 1;
+
+    for (j = 0; j < 4; ++j)
+    {
+      if (j == 0 || picked[j] != picked[j - 1])
+      {
+        picked_x[picked_count] = x[picked[j]];
+        picked_y[picked_count] = y[picked[j]];
+        picked_count++;
+      }
+    }
+
+    /* Read before writing, out may overlap the current column */
+    for (j = 0; j < picked_count; ++j)
+    {
+      out_x[n] = picked_x[j];
+      out_y[n] = picked_y[j];
+      n++;
+    }
+  }
+
+  return n;
+}
+
+/* Path builder: formats the path commands straight into the writer instead of a caller built vgg_path.d
+
+     vgg_svg_path_begin(w);
+     vgg_svg_path_move_to(w, 0.0, 0.0);
+     vgg_svg_path_lines_to(w, count, x, y);
+     vgg_svg_path_close(w);
+     vgg_svg_path_end(w, &header);
+
+   writes the same bytes as vgg_svg_element_add of a vgg_path with d = "M0 0Lx0 y0Lx1 y1...Z".
+*/
+VGG_API VGG_INLINE void vgg_svg_path_begin(vgg_svg_writer *w)
+{
+  /* With culling the path is rolled back in vgg_svg_path_end unless it was flushed in between */
+  w->path_start = w->length;
+  w->path_bounds = vgg_bounds_empty();
+
+  VGG_SVG_STATS_MARK(w, 1);
+  vgg_svg_puts(w, "  <path d=\"");
+}
+
+/* Command letter followed by count space separated numbers */
+VGG_API VGG_INLINE void vgg_svg_path_command(vgg_svg_writer *w, char command, double *values, int count)
+{
+  char *p = vgg_svg_reserve(w, 1 + count * (VGG_SVG_DOUBLE_SIZE_MAX + 1));
+  int i;
+
+  if (w->cull)
+  {
+    for (i = 0; i + 1 < count; i += 2)
+    {
+      vgg_bounds_include(&w->path_bounds, values[i], values[i + 1]);
+    }
+  }
+
+  for (i = 0; p && i < count; ++i)
+  {
+    p = vgg_svg_double_raw(values[i]) ? p : 0;
+  }
+
+  if (!p)
+  {
+    vgg_svg_putc(w, command);
+    for (i = 0; i < count; ++i)
+    {
+      if (i)
+      {
+        vgg_svg_putc(w, ' ');
+      }
+      vgg_svg_put_double(w, values[i]);
+    }
+    return;
+  }
+
+  *p++ = command;
+  for (i = 0; i < count; ++i)
+  {
+    if (i)
+    {
+      *p++ = ' ';
+    }
+    p = vgg_svg_raw_double(p, values[i]);
+  }
+  vgg_svg_commit(w, p);
+}
+
+VGG_API VGG_INLINE void vgg_svg_path_move_to(vgg_svg_writer *w, double x, double y)
+{
+  double values[2];
+  values[0] = x;
+  values[1] = y;
+  vgg_svg_path_command(w, 'M', values, 2);
+}
+
+VGG_API VGG_INLINE void vgg_svg_path_line_to(vgg_svg_writer *w, double x, double y)
+{
+  double values[2];
+  values[0] = x;
+  values[1] = y;
+  vgg_svg_path_command(w, 'L', values, 2);
+}
+
+VGG_API VGG_INLINE void vgg_svg_path_quad_to(vgg_svg_writer *w, double x1, double y1, double x, double y)
+{
+  double values[4];
+  values[0] = x1;
+  values[1] = y1;
+  values[2] = x;
+  values[3] = y;
+  vgg_svg_path_command(w, 'Q', values, 4);
+}
+
+VGG_API VGG_INLINE void vgg_svg_path_cubic_to(vgg_svg_writer *w, double x1, double y1, double x2, double y2, double x, double y)
+{
+  double values[6];
+  values[0] = x1;
+  values[1] = y1;
+  values[2] = x2;
+  values[3] = y2;
+  values[4] = x;
+  values[5] = y;
+  vgg_svg_path_command(w, 'C', values, 6);
+}
+
+/* Line to each point of the columns x, y */
+VGG_API VGG_INLINE void vgg_svg_path_lines_to(vgg_svg_writer *w, unsigned int count, double *x, double *y)
+{
+  int size = 2 + 2 * VGG_SVG_DOUBLE_SIZE_MAX;
+  unsigned int i = 0, end;
+  char *p;
+
+  while (i < count)
+  {
+    end = vgg_svg_reserve_batch(w, size, i, count);
+    end = vgg_svg_raw_end(x, y, 0, 0, i, end);
+
+    if (end == i)
+    {
+      vgg_svg_path_line_to(w, x[i], y[i]);
+      i++;
+      continue;
+    }
+
+    p = (char *)(w->buffer + w->length);
+    for (; i < end; ++i)
+    {
+      if (w->cull)
+      {
+        vgg_bounds_include(&w->path_bounds, x[i], y[i]);
+      }
+      *p++ = 'L';
+      p = vgg_svg_raw_double(p, x[i]);
+      *p++ = ' ';
+      p = vgg_svg_raw_double(p, y[i]);
+    }
+    vgg_svg_commit(w, p);
+  }
+}
+
+VGG_API VGG_INLINE void vgg_svg_path_close(vgg_svg_writer *w)
+{
+  vgg_svg_putc(w, 'Z');
+}
+
+/* Closes the d attribute and writes id, fill and data fields of header */
+VGG_API VGG_INLINE void vgg_svg_path_end(vgg_svg_writer *w, vgg_header *header)
+{
+  char *p;
+
+  if (w->cull && w->path_start >= 0 && vgg_svg_cull_bounds(w, &w->path_bounds))
+  {
+    w->length = w->path_start;
+    return;
+  }
+
+  p = vgg_svg_reserve(w, vgg_svg_attributes_size_max(header));
+
+  if (!p)
+  {
+    vgg_svg_puts(w, "\" ");
+    vgg_svg_put_attributes(w, header);
+    vgg_svg_puts(w, "/>\n");
+    VGG_SVG_STATS_ELEMENTS(w, VGG_TYPE_PATH);
+    return;
+  }
+
+  p = VGG_SVG_RAW_LITERAL(p, "\" ");
+  p = vgg_svg_raw_attributes(p, w->style, header->id, header->color_fill, header->data_fields, header->data_fields_count);
+  p = VGG_SVG_RAW_LITERAL(p, "/>\n");
+  vgg_svg_commit(w, p);
+  VGG_SVG_STATS_ELEMENTS(w, VGG_TYPE_PATH);
+}
+
+/* Open polyline through the columns x, y as a path, e.g. after vgg_simplify_rdp or vgg_simplify_minmax */
+VGG_API VGG_INLINE void vgg_svg_polyline_add(vgg_svg_writer *w, vgg_header *header, unsigned int count, double *x, double *y)
+{
+  if (!count)
   {
-    vgg_svg_putc(w, '0');
     return;
   }
-  while (val && i)
+
+  vgg_svg_path_begin(w);
+  vgg_svg_path_move_to(w, x[0], y[0]);
+  vgg_svg_path_lines_to(w, count - 1, x + 1, y + 1);
+  vgg_svg_path_end(w, header);
+}
+
+/* Bump allocator over caller provided memory, nothing is freed individually */
+typedef struct vgg_arena
+{
+  unsigned char *memory;
+  unsigned long capacity;
+  unsigned long used;
+  int exhausted; /* Set once an allocation did not fit */
+
+} vgg_arena;
+
+VGG_API VGG_INLINE vgg_arena vgg_arena_create(void *memory, unsigned long capacity)
+{
+  vgg_arena arena;
+  arena.memory = (unsigned char *)memory;
+  arena.capacity = capacity;
+  arena.used = 0;
+  arena.exhausted = 0;
+  return arena;
+}
+
+VGG_API VGG_INLINE void vgg_arena_reset(vgg_arena *arena)
+{
+  arena->used = 0;
+  arena->exhausted = 0;
+}
+
+/* Returns size bytes aligned for doubles and pointers or 0 if the arena is full */
+VGG_API VGG_INLINE void *vgg_arena_alloc(vgg_arena *arena, unsigned long size)
+{
+  unsigned long start = (arena->used + 7UL) & ~7UL;
+
+  if (start > arena->capacity || size > arena->capacity - start)
+  {
+    arena->exhausted = 1;
+    return 0;
+  }
+
+  arena->used = start + size;
+  return arena->memory + start;
+}
+
+/* Grows the allocation data of old_size bytes, in place if it is the last one */
+VGG_API VGG_INLINE void *vgg_arena_grow(vgg_arena *arena, void *data, unsigned long old_size, unsigned long size)
+{
+  unsigned char *grown;
+  unsigned long i;
+
+  if (data && (unsigned char *)data + old_size == arena->memory + arena->used && size - old_size <= arena->capacity - arena->used)
+  {
+    arena->used += size - old_size;
+    return data;
+  }
+
+  grown = (unsigned char *)vgg_arena_alloc(arena, size);
+  for (i = 0; grown && i < old_size; ++i)
+  {
+    grown[i] = ((unsigned char *)data)[i];
+  }
+  return grown;
+}
+
+VGG_API VGG_INLINE char *vgg_arena_string(vgg_arena *arena, char *s)
+{
+  unsigned long length = (unsigned long)vgg_svg_strlen(s) + 1;
+  char *copy = (char *)vgg_arena_alloc(arena, length);
+  unsigned long i;
+
+  for (i = 0; copy && i < length; ++i)
+  {
+    copy[i] = s[i];
+  }
+  return copy;
+}
+
+/* Any element, large enough for each of the vgg_header based types */
+typedef union vgg_element
+{
+  vgg_header header;
+  vgg_rect rect;
+  vgg_circle circle;
+  vgg_line line;
+  vgg_ellipse ellipse;
+  vgg_text text;
+  vgg_path path;
+
+} vgg_element;
+
+/* Geometry of one element type as columns, in the field order of the element struct
+   (rect: x, y, width, height; circle: cx, cy, r; text: x, y and the string; path: the string).
+*/
+typedef struct vgg_document_shapes
+{
+  double *values[4];
+  char **strings; /* Text or path d, 0 for the other types */
+  unsigned int count;
+  unsigned int capacity;
+
+} vgg_document_shapes;
+
+/* Paint order entry, the geometry is row index of shapes[type] */
+typedef struct vgg_document_item
+{
+  vgg_header_type type;
+  unsigned int index;
+  unsigned int id;
+  vgg_color color_fill;
+  vgg_data_field *data_fields;
+  unsigned int data_fields_count;
+  unsigned int data_fields_capacity; /* Fields allocated, their strings are reused by updates */
+
+  unsigned int span_offset; /* Serialized bytes in the cache of vgg_document_render */
+  unsigned int span_length;
+  int dirty;
+
+} vgg_document_item;
+
+/* Retained scene: elements, their data fields and strings live in an arena and can be
+   written any number of times. Serializes exactly like vgg_svg_element_add per element.
+*/
+typedef struct vgg_document
+{
+  vgg_arena *arena;
+  vgg_document_item *items;
+  unsigned int count;
+  unsigned int capacity;
+  vgg_document_shapes shapes[VGG_TYPE_PATH + 1];
+
+  /* Incremental rendering, see vgg_document_render */
+  unsigned int *dirty;         /* Changed items already in the cache */
+  unsigned int *dirty_lengths; /* Their new serialized length while rendering */
+  unsigned int dirty_count;
+  unsigned int rendered;       /* Items in the cache */
+  int rendered_length;         /* Cache length after the last render, -1 if the cache is invalid */
+
+} vgg_document;
+
+VGG_API VGG_INLINE void vgg_document_init(vgg_document *doc, vgg_arena *arena)
+{
+  unsigned int type, column;
+
+  doc->arena = arena;
+  doc->items = 0;
+  doc->count = 0;
+  doc->capacity = 0;
+  doc->dirty = 0;
+  doc->dirty_lengths = 0;
+  doc->dirty_count = 0;
+  doc->rendered = 0;
+  doc->rendered_length = -1;
+
+  for (type = 0; type <= VGG_TYPE_PATH; ++type)
+  {
+    for (column = 0; column < 4; ++column)
+    {
+      doc->shapes[type].values[column] = 0;
+    }
+    doc->shapes[type].strings = 0;
+    doc->shapes[type].count = 0;
+    doc->shapes[type].capacity = 0;
+  }
+}
+
+/* Number of double columns per type, in vgg_header_type order */
+VGG_API VGG_INLINE unsigned int vgg_document_columns(vgg_header_type type)
+{
+  static const unsigned char columns[VGG_TYPE_PATH + 1] = {4, 3, 4, 4, 2, 0};
+  return columns[type];
+}
+
+/* Doubles the capacity of all columns of a type, returns 0 if the arena is full */
+VGG_API VGG_INLINE int vgg_document_shapes_grow(vgg_document *doc, vgg_header_type type)
+{
+  vgg_document_shapes *shapes = &doc->shapes[type];
+  unsigned long capacity = shapes->capacity ? 2UL * shapes->capacity : 64UL;
+  unsigned int column;
+
+  for (column = 0; column < vgg_document_columns(type); ++column)
+  {
+    double *grown = (double *)vgg_arena_grow(doc->arena, shapes->values[column], shapes->capacity * (unsigned long)sizeof(double), capacity * (unsigned long)sizeof(double));
+    if (!grown)
+    {
+      return 0;
+    }
+    shapes->values[column] = grown;
+  }
+
+  if (type == VGG_TYPE_TEXT || type == VGG_TYPE_PATH)
+  {
+    char **grown = (char **)vgg_arena_grow(doc->arena, shapes->strings, shapes->capacity * (unsigned long)sizeof(char *), capacity * (unsigned long)sizeof(char *));
+    if (!grown)
+    {
+      return 0;
+    }
+    shapes->strings = grown;
+  }
+
+  shapes->capacity = (unsigned int)capacity;
+  return 1;
+}
+
+/* Document strings keep their capacity in front of them, updates overwrite them in place when they fit */
+#define VGG_DOCUMENT_STRING_PREFIX 8UL
+
+VGG_API VGG_INLINE unsigned long vgg_document_string_capacity(char *s)
+{
+  return s ? *(unsigned long *)(void *)(s - VGG_DOCUMENT_STRING_PREFIX) : 0;
+}
+
+/* Arena bytes needed to store s over the document string old (0 if none), 0 if it fits in place */
+VGG_API VGG_INLINE unsigned long vgg_document_string_size(char *old, char *s)
+{
+  unsigned long length = (unsigned long)vgg_svg_strlen(s) + 1;
+  return (length <= vgg_document_string_capacity(old)) ? 0 : VGG_DOCUMENT_STRING_PREFIX + ((length + 7UL) & ~7UL);
+}
+
+/* Copies s over old if it fits, otherwise into a new allocation. Returns 0 if the arena is full. */
+VGG_API VGG_INLINE char *vgg_document_string(vgg_arena *arena, char *old, char *s)
+{
+  unsigned long length = (unsigned long)vgg_svg_strlen(s) + 1;
+  unsigned long capacity = (length + 7UL) & ~7UL;
+  unsigned char *memory;
+  char *copy = old;
+  unsigned long i;
+
+  if (length > vgg_document_string_capacity(old))
+  {
+    if (!(memory = (unsigned char *)vgg_arena_alloc(arena, VGG_DOCUMENT_STRING_PREFIX + capacity)))
+    {
+      return 0;
+    }
+    *(unsigned long *)(void *)memory = capacity;
+    copy = (char *)memory + VGG_DOCUMENT_STRING_PREFIX;
+  }
+
+  for (i = 0; i < length; ++i)
+  {
+    copy[i] = s[i];
+  }
+  return copy;
+}
+
+/* Copies id, fill, data fields and geometry of header into item. Strings and data fields
+   reuse the storage of the element stored before when they fit, the arena only grows for
+   longer ones. Returns 0 and leaves item unchanged if the arena is full.
+*/
+VGG_API VGG_INLINE int vgg_document_store(vgg_document *doc, vgg_document_item *item, vgg_header *header)
+{
+  vgg_document_shapes *shapes = &doc->shapes[header->type];
+  vgg_arena *arena = doc->arena;
+  vgg_data_field *fields = item->data_fields;
+  unsigned int count = header->data_fields_count;
+  unsigned int row = item->index, i;
+  unsigned long size = 0, start;
+  double *values[4];
+  char **string = 0;
+  char *s = 0;
+
+  if (header->type == VGG_TYPE_TEXT)
+  {
+    string = &shapes->strings[row];
+    s = ((vgg_text *)header)->text;
+  }
+  else if (header->type == VGG_TYPE_PATH)
+  {
+    string = &shapes->strings[row];
+    s = ((vgg_path *)header)->d;
+  }
+
+  /* Everything that does not fit in place is checked up front, nothing is written on failure */
+  if (count > item->data_fields_capacity)
+  {
+    size += (count * (unsigned long)sizeof(vgg_data_field) + 7UL) & ~7UL;
+  }
+  for (i = 0; i < count; ++i)
+  {
+    size += vgg_document_string_size((i < item->data_fields_capacity) ? fields[i].key : 0, header->data_fields[i].key);
+    size += vgg_document_string_size((i < item->data_fields_capacity) ? fields[i].value : 0, header->data_fields[i].value);
+  }
+  if (string)
+  {
+    size += vgg_document_string_size(*string, s);
+  }
+
+  start = (arena->used + 7UL) & ~7UL;
+  if (start > arena->capacity || size > arena->capacity - start)
+  {
+    arena->exhausted = 1;
+    return 0;
+  }
+
+  /* Fields of the old array keep their strings for reuse */
+  if (count > item->data_fields_capacity)
+  {
+    fields = (vgg_data_field *)vgg_arena_alloc(arena, count * (unsigned long)sizeof(vgg_data_field));
+    for (i = 0; i < count; ++i)
+    {
+      fields[i].key = (i < item->data_fields_capacity) ? item->data_fields[i].key : 0;
+      fields[i].value = (i < item->data_fields_capacity) ? item->data_fields[i].value : 0;
+    }
+    item->data_fields = fields;
+    item->data_fields_capacity = count;
+  }
+  for (i = 0; i < count; ++i)
+  {
+    fields[i].key = vgg_document_string(arena, fields[i].key, header->data_fields[i].key);
+    fields[i].value = vgg_document_string(arena, fields[i].value, header->data_fields[i].value);
+  }
+  if (string)
+  {
+    *string = vgg_document_string(arena, *string, s);
+  }
+
+  item->id = header->id;
+  item->color_fill = header->color_fill;
+  item->data_fields_count = count;
+
+  for (i = 0; i < 4; ++i)
+  {
+    values[i] = (i < vgg_document_columns(header->type)) ? shapes->values[i] + row : 0;
+  }
+
+  if (header->type == VGG_TYPE_RECT)
+  {
+    vgg_rect *rect = (vgg_rect *)header;
+    *values[0] = rect->x;
+    *values[1] = rect->y;
+    *values[2] = rect->width;
+    *values[3] = rect->height;
+  }
+  else if (header->type == VGG_TYPE_CIRCLE)
+  {
+    vgg_circle *circle = (vgg_circle *)header;
+    *values[0] = circle->cx;
+    *values[1] = circle->cy;
+    *values[2] = circle->r;
+  }
+  else if (header->type == VGG_TYPE_LINE)
+  {
+    vgg_line *line = (vgg_line *)header;
+    *values[0] = line->x1;
+    *values[1] = line->y1;
+    *values[2] = line->x2;
+    *values[3] = line->y2;
+  }
+  else if (header->type == VGG_TYPE_ELLIPSE)
   {
-    buf[--i] = '0' + (char)(val % 10);
-    val /= 10;
+    vgg_ellipse *ellipse = (vgg_ellipse *)header;
+    *values[0] = ellipse->cx;
+    *values[1] = ellipse->cy;
+    *values[2] = ellipse->rx;
+    *values[3] = ellipse->ry;
   }
-  while (i < 10)
+  else if (header->type == VGG_TYPE_TEXT)
   {
-    vgg_svg_putc(w, buf[i++]);
+    vgg_text *text = (vgg_text *)header;
+    *values[0] = text->x;
+    *values[1] = text->y;
   }
+
+  return 1;
 }
 
-/* Write a float with 3-digit decimal precision */
-VGG_API VGG_INLINE void vgg_svg_put_double(vgg_svg_writer *w, double d)
+/* Copies an element with its strings and data fields into the document.
+   Returns its index in paint order or -1 if the arena is full.
+*/
+VGG_API VGG_INLINE int vgg_document_add(vgg_document *doc, vgg_header *header)
 {
-  int i = (int)d;
-  int frac;
+  vgg_document_shapes *shapes = &doc->shapes[header->type];
+  vgg_document_item *item;
 
-  if (d < 0)
+  if (doc->count == doc->capacity)
   {
-    vgg_svg_putc(w, '-');
-    d = -d;
-    i = -i;
+    unsigned long capacity = doc->capacity ? 2UL * doc->capacity : 64UL;
+    vgg_document_item *grown = (vgg_document_item *)vgg_arena_grow(doc->arena, doc->items, doc->capacity * (unsigned long)sizeof(vgg_document_item), capacity * (unsigned long)sizeof(vgg_document_item));
+    unsigned int *dirty = (unsigned int *)vgg_arena_grow(doc->arena, doc->dirty, doc->capacity * (unsigned long)sizeof(unsigned int), capacity * (unsigned long)sizeof(unsigned int));
+    unsigned int *dirty_lengths = (unsigned int *)vgg_arena_grow(doc->arena, doc->dirty_lengths, doc->capacity * (unsigned long)sizeof(unsigned int), capacity * (unsigned long)sizeof(unsigned int));
+    if (!grown || !dirty || !dirty_lengths)
+    {
+      return -1;
+    }
+    doc->items = grown;
+    doc->dirty = dirty;
+    doc->dirty_lengths = dirty_lengths;
+    doc->capacity = (unsigned int)capacity;
   }
 
-  vgg_svg_put_uint(w, (unsigned int)i);
-  vgg_svg_putc(w, '.');
-
-  frac = (int)((d - (double)i) * 1000.0);
-  if (frac < 0)
+  if (shapes->count == shapes->capacity && !vgg_document_shapes_grow(doc, header->type))
   {
-    frac = -frac;
+    return -1;
   }
-  if (frac < 100)
+
+  item = &doc->items[doc->count];
+  item->type = header->type;
+  item->index = shapes->count;
+  item->data_fields = 0;
+  item->data_fields_count = 0;
+  item->data_fields_capacity = 0;
+  item->span_offset = 0;
+  item->span_length = 0;
+  item->dirty = 0;
+
+  if (shapes->strings)
   {
-    vgg_svg_putc(w, '0');
+    shapes->strings[item->index] = 0;
   }
-  if (frac < 10)
+
+  if (!vgg_document_store(doc, item, header))
   {
-    vgg_svg_putc(w, '0');
+    return -1;
   }
-  vgg_svg_put_uint(w, (unsigned int)frac);
+
+  shapes->count++;
+  return (int)doc->count++;
 }
 
-VGG_API VGG_INLINE void vgg_svg_start(vgg_svg_writer *w, char *id, double width, double height)
+/* Marks an item for re-serialization by the next vgg_document_render */
+VGG_API VGG_INLINE void vgg_document_touch(vgg_document *doc, unsigned int index)
 {
-  vgg_svg_puts(w, "<svg ");
-
-  /* ID field */
-  vgg_svg_puts(w, "id=\"");
-  vgg_svg_puts(w, id);
-  vgg_svg_puts(w, "\" ");
+  /* Items not yet in the cache are appended anyway */
+  if (index < doc->rendered && !doc->items[index].dirty)
+  {
+    doc->items[index].dirty = 1;
+    doc->dirty[doc->dirty_count++] = index;
+  }
+}
 
-  /* XMLNS */
-  vgg_svg_puts(w, "xmlns=\"http://www.w3.org/2000/svg\" ");
+/* Replaces the element at index with one of the same type. Strings and data fields are
+   overwritten in place when they fit, updating in a loop does not exhaust the arena.
+   Returns 0 and leaves the element unchanged if the type differs or the arena is full.
+*/
+VGG_API VGG_INLINE int vgg_document_set(vgg_document *doc, unsigned int index, vgg_header *header)
+{
+  vgg_document_item *item = &doc->items[index];
 
-  /* Width of svg */
-  vgg_svg_puts(w, "width=\"");
-  vgg_svg_put_double(w, width);
-  vgg_svg_puts(w, "\" ");
+  if (item->type != header->type || !vgg_document_store(doc, item, header))
+  {
+    return 0;
+  }
 
-  /* Height of svg */
-  vgg_svg_puts(w, "height=\"");
-  vgg_svg_put_double(w, height);
-  vgg_svg_puts(w, "\">\n");
+  vgg_document_touch(doc, index);
+  return 1;
 }
 
-VGG_API VGG_INLINE void vgg_svg_end(vgg_svg_writer *w)
+VGG_API VGG_INLINE void vgg_document_set_fill(vgg_document *doc, unsigned int index, vgg_color color_fill)
 {
-  vgg_svg_puts(w, "</svg>\n");
+  doc->items[index].color_fill = color_fill;
+  vgg_document_touch(doc, index);
 }
 
-#define VGG_SVG_PUT_COLOR(w, color)               \
-  do                                              \
-  {                                               \
-    static const char hex[] = "0123456789ABCDEF"; \
-    char buf[6];                                  \
-    int i;                                        \
-    buf[0] = hex[(color.r >> 4) & 0xF];           \
-    buf[1] = hex[(color.r) & 0xF];                \
-    buf[2] = hex[(color.g >> 4) & 0xF];           \
-    buf[3] = hex[(color.g) & 0xF];                \
-    buf[4] = hex[(color.b >> 4) & 0xF];           \
-    buf[5] = hex[(color.b) & 0xF];                \
-    for (i = 0; i < 6; ++i)                       \
-    {                                             \
-      vgg_svg_putc((w), buf[i]);                  \
-    }                                             \
-  } while (0)
-
-VGG_API VGG_INLINE void vgg_svg_element_add(
-    vgg_svg_writer *w,
-    vgg_header *header)
+/* Element at index in paint order, strings and data fields point into the arena */
+VGG_API VGG_INLINE void vgg_document_element(vgg_document *doc, unsigned int index, vgg_element *element)
 {
+  vgg_document_item *item = &doc->items[index];
+  vgg_document_shapes *shapes = &doc->shapes[item->type];
+  double *values[4];
   unsigned int i;
 
-  /* Open element tag */
-  vgg_svg_puts(w, "  <");
+  for (i = 0; i < 4; ++i)
+  {
+    values[i] = (i < vgg_document_columns(item->type)) ? shapes->values[i] + item->index : 0;
+  }
 
-  /* Rectangular Shape */
-  if (header->type == VGG_TYPE_RECT)
+  element->header.type = item->type;
+  element->header.id = item->id;
+  element->header.color_fill = item->color_fill;
+  element->header.data_fields = item->data_fields;
+  element->header.data_fields_count = item->data_fields_count;
+
+  if (item->type == VGG_TYPE_RECT)
   {
-    vgg_rect *rect = (vgg_rect *)header;
+    element->rect.x = *values[0];
+    element->rect.y = *values[1];
+    element->rect.width = *values[2];
+    element->rect.height = *values[3];
+  }
+  else if (item->type == VGG_TYPE_CIRCLE)
+  {
+    element->circle.cx = *values[0];
+    element->circle.cy = *values[1];
+    element->circle.r = *values[2];
+  }
+  else if (item->type == VGG_TYPE_LINE)
+  {
+    element->line.x1 = *values[0];
+    element->line.y1 = *values[1];
+    element->line.x2 = *values[2];
+    element->line.y2 = *values[3];
+  }
+  else if (item->type == VGG_TYPE_ELLIPSE)
+  {
+    element->ellipse.cx = *values[0];
+    element->ellipse.cy = *values[1];
+    element->ellipse.rx = *values[2];
+    element->ellipse.ry = *values[3];
+  }
+  else if (item->type == VGG_TYPE_TEXT)
+  {
+    element->text.x = *values[0];
+    element->text.y = *values[1];
+    element->text.text = shapes->strings[item->index];
+  }
+  else if (item->type == VGG_TYPE_PATH)
+  {
+    element->path.d = shapes->strings[item->index];
+  }
+}
 
-    vgg_svg_puts(w, "rect ");
+/* Writes all elements in paint order, can be called for every render */
+VGG_API VGG_INLINE void vgg_document_write(vgg_document *doc, vgg_svg_writer *w)
+{
+  vgg_element element;
+  unsigned int i;
 
-    /* Rect x value */
-    vgg_svg_puts(w, "x=\"");
-    vgg_svg_put_double(w, rect->x);
-    vgg_svg_puts(w, "\" ");
+  for (i = 0; i < doc->count; ++i)
+  {
+    vgg_document_element(doc, i, &element);
+    vgg_svg_element_add(w, &element.header);
+  }
+}
 
-    /* Rect y value */
-    vgg_svg_puts(w, "y=\"");
-    vgg_svg_put_double(w, rect->y);
-    vgg_svg_puts(w, "\" ");
+/* Re-serializes the dirty items of the cache, see vgg_document_render */
+VGG_API VGG_INLINE int vgg_document_render_dirty(vgg_document *doc, vgg_svg_writer *cache)
+{
+  unsigned int *dirty = doc->dirty;
+  unsigned int *lengths = doc->dirty_lengths;
+  unsigned int count = doc->dirty_count;
+  unsigned int i, k, fragment;
+  int length = cache->length;
+  int fragments, delta = 0, shift, same_length = 1;
+  vgg_element element;
+
+  vgg_sort_uint(dirty, count);
+
+  /* Serialize the changed elements behind the cached bytes */
+  for (i = 0; i < count; ++i)
+  {
+    int start = cache->length;
 
-    /* Rect width value */
-    vgg_svg_puts(w, "width=\"");
-    vgg_svg_put_double(w, rect->width);
-    vgg_svg_puts(w, "\" ");
+    vgg_document_element(doc, dirty[i], &element);
+    vgg_svg_element_add(cache, &element.header);
 
-    /* Rect height value */
-    vgg_svg_puts(w, "height=\"");
-    vgg_svg_put_double(w, rect->height);
-    vgg_svg_puts(w, "\" ");
+    lengths[i] = (unsigned int)(cache->length - start);
+    delta += (int)lengths[i] - (int)doc->items[dirty[i]].span_length;
+    same_length &= (lengths[i] == doc->items[dirty[i]].span_length);
+    doc->items[dirty[i]].dirty = 0;
   }
-  else if (header->type == VGG_TYPE_LINE)
+  doc->dirty_count = 0;
+
+  if (cache->truncated)
   {
-    vgg_line *line = (vgg_line *)header;
+    return 0;
+  }
 
-    vgg_svg_puts(w, "line ");
+  fragments = length;
 
-    vgg_svg_puts(w, "x1=\"");
-    vgg_svg_put_double(w, line->x1);
-    vgg_svg_puts(w, "\" ");
+  if (same_length)
+  {
+    /* Patch in place, the cost only depends on the changed elements */
+    for (i = 0, fragment = (unsigned int)fragments; i < count; fragment += lengths[i++])
+    {
+      vgg_move_bytes(cache->buffer + doc->items[dirty[i]].span_offset, cache->buffer + fragment, lengths[i]);
+    }
+    cache->length = length;
+    return 1;
+  }
 
-    vgg_svg_puts(w, "y1=\"");
-    vgg_svg_put_double(w, line->y1);
-    vgg_svg_puts(w, "\" ");
+  /* Splice: keep the fragments clear of the grown document */
+  if (delta > 0)
+  {
+    if (cache->length + delta > cache->capacity)
+    {
+      cache->truncated = 1;
+      return 0;
+    }
+    vgg_move_bytes(cache->buffer + fragments + delta, cache->buffer + fragments, (unsigned long)(cache->length - fragments));
+    fragments += delta;
+  }
 
-    vgg_svg_puts(w, "x2=\"");
-    vgg_svg_put_double(w, line->x2);
-    vgg_svg_puts(w, "\" ");
+  /* Unchanged segment i ends at dirty item i (the last one at the old length).
+     Segments moving left are moved front to back, segments moving right back to front.
+  */
+  for (i = 0, shift = 0; i <= count; ++i)
+  {
+    unsigned int start = i ? doc->items[dirty[i - 1]].span_offset + doc->items[dirty[i - 1]].span_length : 0;
+    unsigned int end = (i < count) ? doc->items[dirty[i]].span_offset : (unsigned int)length;
 
-    vgg_svg_puts(w, "y2=\"");
-    vgg_svg_put_double(w, line->y2);
-    vgg_svg_puts(w, "\" ");
+    shift += i ? (int)lengths[i - 1] - (int)doc->items[dirty[i - 1]].span_length : 0;
+    if (shift < 0)
+    {
+      vgg_move_bytes(cache->buffer + (int)start + shift, cache->buffer + start, end - start);
+    }
   }
-  else if (header->type == VGG_TYPE_ELLIPSE)
+
+  for (i = count + 1, shift = delta; i-- > 0;)
   {
-    vgg_ellipse *ellipse = (vgg_ellipse *)header;
+    unsigned int start = i ? doc->items[dirty[i - 1]].span_offset + doc->items[dirty[i - 1]].span_length : 0;
+    unsigned int end = (i < count) ? doc->items[dirty[i]].span_offset : (unsigned int)length;
 
-    vgg_svg_puts(w, "ellipse ");
+    if (shift > 0)
+    {
+      vgg_move_bytes(cache->buffer + (int)start + shift, cache->buffer + start, end - start);
+    }
+    shift -= i ? (int)lengths[i - 1] - (int)doc->items[dirty[i - 1]].span_length : 0;
+  }
 
-    vgg_svg_puts(w, "cx=\"");
-    vgg_svg_put_double(w, ellipse->cx);
-    vgg_svg_puts(w, "\" ");
+  /* Fragments into their gaps, spans of all following items move along */
+  for (i = 0, fragment = (unsigned int)fragments, shift = 0; i < count; fragment += lengths[i++])
+  {
+    unsigned int offset = (unsigned int)((int)doc->items[dirty[i]].span_offset + shift);
+    vgg_move_bytes(cache->buffer + offset, cache->buffer + fragment, lengths[i]);
+    shift += (int)lengths[i] - (int)doc->items[dirty[i]].span_length;
+  }
 
-    vgg_svg_puts(w, "cy=\"");
-    vgg_svg_put_double(w, ellipse->cy);
-    vgg_svg_puts(w, "\" ");
+  for (i = dirty[0], k = 0, shift = 0; i < doc->rendered; ++i)
+  {
+    doc->items[i].span_offset = (unsigned int)((int)doc->items[i].span_offset + shift);
+    if (k < count && dirty[k] == i)
+    {
+      shift += (int)lengths[k] - (int)doc->items[i].span_length;
+      doc->items[i].span_length = lengths[k++];
+    }
+  }
 
-    vgg_svg_puts(w, "rx=\"");
-    vgg_svg_put_double(w, ellipse->rx);
-    vgg_svg_puts(w, "\" ");
+  cache->length = length + delta;
+  return 1;
+}
 
-    vgg_svg_puts(w, "ry=\"");
-    vgg_svg_put_double(w, ellipse->ry);
-    vgg_svg_puts(w, "\" ");
+/* Serializes doc into the fixed size writer cache and remembers the byte span of every element.
+   Later calls only re-serialize the elements changed with vgg_document_set / vgg_document_set_fill
+   (patched in place if their length stays the same, spliced in otherwise) and append new ones.
+   The cache holds the elements only, e.g. vgg_svg_putn(w, cache.buffer, cache.length) between
+   vgg_svg_start and vgg_svg_end. It needs spare room for the changed elements and should not use
+   style interning. Returns 0 if it is too small, the next call then renders everything again.
+*/
+VGG_API VGG_INLINE int vgg_document_render(vgg_document *doc, vgg_svg_writer *cache)
+{
+  vgg_element element;
+  unsigned int i;
+
+  if (doc->rendered_length < 0 || cache->length != doc->rendered_length)
+  {
+    for (i = 0; i < doc->dirty_count; ++i)
+    {
+      doc->items[doc->dirty[i]].dirty = 0;
+    }
+    doc->dirty_count = 0;
+    doc->rendered = 0;
+    cache->length = 0;
+    cache->truncated = 0;
   }
-  else if (header->type == VGG_TYPE_CIRCLE)
+  else if (doc->dirty_count && !vgg_document_render_dirty(doc, cache))
   {
-    vgg_circle *circle = (vgg_circle *)header;
+    doc->rendered_length = -1;
+    return 0;
+  }
 
-    vgg_svg_puts(w, "circle ");
+  /* Elements added since the last render */
+  for (i = doc->rendered; i < doc->count; ++i)
+  {
+    doc->items[i].span_offset = (unsigned int)cache->length;
+    vgg_document_element(doc, i, &element);
+    vgg_svg_element_add(cache, &element.header);
+    doc->items[i].span_length = (unsigned int)cache->length - doc->items[i].span_offset;
+  }
+  doc->rendered = doc->count;
 
-    vgg_svg_puts(w, "cx=\"");
-    vgg_svg_put_double(w, circle->cx);
-    vgg_svg_puts(w, "\" ");
+  doc->rendered_length = cache->truncated ? -1 : cache->length;
+  return !cache->truncated;
+}
 
-    vgg_svg_puts(w, "cy=\"");
-    vgg_svg_put_double(w, circle->cy);
-    vgg_svg_puts(w, "\" ");
+/* 64 bit non-cryptographic hash as two 32 bit lanes (C89 has no 64 bit integer),
+   used as content address of rendered bytes (see vgg_platform_cache.h).
+*/
+typedef struct vgg_hash
+{
+  unsigned long lanes[2];
+  unsigned long size;
 
-    vgg_svg_puts(w, "r=\"");
-    vgg_svg_put_double(w, circle->r);
-    vgg_svg_puts(w, "\" ");
-  }
-  else if (header->type == VGG_TYPE_TEXT)
-  {
-    vgg_text *text = (vgg_text *)header;
+} vgg_hash;
 
-    vgg_svg_puts(w, "text ");
+#define VGG_HASH_MASK 0xFFFFFFFFUL
 
-    vgg_svg_puts(w, "x=\"");
-    vgg_svg_put_double(w, text->x);
-    vgg_svg_puts(w, "\" ");
+VGG_API VGG_INLINE void vgg_hash_init(vgg_hash *hash)
+{
+  hash->lanes[0] = 0x9E3779B1UL;
+  hash->lanes[1] = 0x85EBCA77UL;
+  hash->size = 0;
+}
 
-    vgg_svg_puts(w, "y=\"");
-    vgg_svg_put_double(w, text->y);
-    vgg_svg_puts(w, "\" ");
+/* Both lanes take every 32 bit word, with different multipliers and rotations */
+VGG_API VGG_INLINE void vgg_hash_word(vgg_hash *hash, unsigned long word)
+{
+  unsigned long a = (hash->lanes[0] + word * 0x85EBCA77UL) & VGG_HASH_MASK;
+  unsigned long b = (hash->lanes[1] ^ (word * 0xC2B2AE3DUL)) & VGG_HASH_MASK;
+
+  a = ((a << 13) | (a >> 19)) & VGG_HASH_MASK;
+  b = ((b << 17) | (b >> 15)) & VGG_HASH_MASK;
+  hash->lanes[0] = (a * 0x9E3779B1UL) & VGG_HASH_MASK;
+  hash->lanes[1] = (b * 0x27D4EB2FUL + 0x165667B1UL) & VGG_HASH_MASK;
+}
+
+VGG_API VGG_INLINE void vgg_hash_bytes(vgg_hash *hash, void *data, unsigned long size)
+{
+  unsigned char *p = (unsigned char *)data;
+  unsigned long i;
+
+  for (i = 0; i + 4 <= size; i += 4)
+  {
+    vgg_hash_word(hash, (unsigned long)p[i] | ((unsigned long)p[i + 1] << 8) | ((unsigned long)p[i + 2] << 16) | ((unsigned long)p[i + 3] << 24));
   }
-  else if (header->type == VGG_TYPE_PATH)
+
+  /* Tail and length, "ab" and "ab\0" differ */
   {
-    vgg_path *path = (vgg_path *)header;
+    unsigned long word = 0;
+    for (; i < size; ++i)
+    {
+      word = (word << 8) | p[i];
+    }
+    vgg_hash_word(hash, word ^ ((size & 3UL) << 30));
+  }
 
-    vgg_svg_puts(w, "path d=\"");
+  hash->size += size;
+}
 
-    vgg_svg_puts(w, path->d);
-    vgg_svg_puts(w, "\" ");
+VGG_API VGG_INLINE void vgg_hash_string(vgg_hash *hash, char *s)
+{
+  vgg_hash_bytes(hash, s, (unsigned long)vgg_svg_strlen(s));
+}
+
+/* Fixed size, two words without the tail of vgg_hash_bytes */
+VGG_API VGG_INLINE void vgg_hash_double(vgg_hash *hash, double value)
+{
+  unsigned char *p = (unsigned char *)&value;
+
+  vgg_hash_word(hash, (unsigned long)p[0] | ((unsigned long)p[1] << 8) | ((unsigned long)p[2] << 16) | ((unsigned long)p[3] << 24));
+  vgg_hash_word(hash, (unsigned long)p[4] | ((unsigned long)p[5] << 8) | ((unsigned long)p[6] << 16) | ((unsigned long)p[7] << 24));
+  hash->size += 8;
+}
+
+/* Final avalanche, writes 16 lowercase hex characters (e.g. a file name) */
+VGG_API VGG_INLINE void vgg_hash_hex(vgg_hash *hash, char *out)
+{
+  static const char digits[] = "0123456789abcdef";
+  unsigned long lanes[2];
+  int lane, i;
+
+  for (lane = 0; lane < 2; ++lane)
+  {
+    unsigned long h = (hash->lanes[lane] ^ hash->size ^ hash->lanes[1 - lane]) & VGG_HASH_MASK;
+    h ^= h >> 15;
+    h = (h * 0x85EBCA77UL) & VGG_HASH_MASK;
+    h ^= h >> 13;
+    h = (h * 0xC2B2AE3DUL) & VGG_HASH_MASK;
+    h ^= h >> 16;
+    lanes[lane] = h;
   }
 
-  /* ID field */
-  vgg_svg_puts(w, "id=\"");
-  vgg_svg_put_uint(w, header->id);
-  vgg_svg_puts(w, "\" ");
+  for (i = 0; i < 16; ++i)
+  {
+    out[i] = digits[(lanes[i / 8] >> (28 - 4 * (i % 8))) & 0xF];
+  }
+}
 
-  /* Fill color */
-  vgg_svg_puts(w, "fill=\"#");
-  VGG_SVG_PUT_COLOR(w, header->color_fill);
-  vgg_svg_puts(w, "\" ");
+/* Everything vgg_svg_element_add output depends on */
+VGG_API VGG_INLINE void vgg_hash_element(vgg_hash *hash, vgg_header *header)
+{
+  unsigned int i;
+
+  vgg_hash_word(hash, (unsigned long)header->type);
+  vgg_hash_word(hash, (unsigned long)header->id & VGG_HASH_MASK);
+  vgg_hash_word(hash, ((unsigned long)(header->color_fill.r & 0xFF) << 16) | ((unsigned long)(header->color_fill.g & 0xFF) << 8) | (unsigned long)(header->color_fill.b & 0xFF));
 
-  /* Data fields */
   for (i = 0; i < header->data_fields_count; ++i)
   {
-    vgg_svg_puts(w, "data-");
-    vgg_svg_puts(w, header->data_fields[i].key);
-    vgg_svg_puts(w, "=\"");
-    vgg_svg_puts(w, header->data_fields[i].value);
-    vgg_svg_puts(w, "\" ");
+    vgg_hash_string(hash, header->data_fields[i].key);
+    vgg_hash_string(hash, header->data_fields[i].value);
   }
 
-  if (header->type != VGG_TYPE_TEXT)
+  if (header->type == VGG_TYPE_RECT)
   {
-    /* Closing element tag */
-    vgg_svg_puts(w, "/>\n");
+    vgg_rect *rect = (vgg_rect *)header;
+    vgg_hash_double(hash, rect->x);
+    vgg_hash_double(hash, rect->y);
+    vgg_hash_double(hash, rect->width);
+    vgg_hash_double(hash, rect->height);
   }
-  else
+  else if (header->type == VGG_TYPE_CIRCLE)
+  {
+    vgg_circle *circle = (vgg_circle *)header;
+    vgg_hash_double(hash, circle->cx);
+    vgg_hash_double(hash, circle->cy);
+    vgg_hash_double(hash, circle->r);
+  }
+  else if (header->type == VGG_TYPE_LINE)
+  {
+    vgg_line *line = (vgg_line *)header;
+    vgg_hash_double(hash, line->x1);
+    vgg_hash_double(hash, line->y1);
+    vgg_hash_double(hash, line->x2);
+    vgg_hash_double(hash, line->y2);
+  }
+  else if (header->type == VGG_TYPE_ELLIPSE)
+  {
+    vgg_ellipse *ellipse = (vgg_ellipse *)header;
+    vgg_hash_double(hash, ellipse->cx);
+    vgg_hash_double(hash, ellipse->cy);
+    vgg_hash_double(hash, ellipse->rx);
+    vgg_hash_double(hash, ellipse->ry);
+  }
+  else if (header->type == VGG_TYPE_TEXT)
   {
     vgg_text *text = (vgg_text *)header;
-    vgg_svg_puts(w, ">");
-    vgg_svg_puts(w, text->text);
-    vgg_svg_puts(w, "</text>\n");
+    vgg_hash_double(hash, text->x);
+    vgg_hash_double(hash, text->y);
+    vgg_hash_string(hash, text->text);
+  }
+  else if (header->type == VGG_TYPE_PATH)
+  {
+    vgg_hash_string(hash, ((vgg_path *)header)->d);
+  }
+}
+
+/* Hash of all elements of doc as written by vgg_document_write to w (including its culling settings) */
+VGG_API VGG_INLINE void vgg_hash_document(vgg_hash *hash, vgg_document *doc, vgg_svg_writer *w)
+{
+  vgg_element element;
+  unsigned int i;
+
+  /* Output format version */
+  vgg_hash_word(hash, VGG_SVG_DOUBLE_PRECISION);
+  vgg_hash_word(hash, (unsigned long)doc->count);
+
+  if (w->cull)
+  {
+    vgg_hash_double(hash, w->cull_viewport.x0);
+    vgg_hash_double(hash, w->cull_viewport.y0);
+    vgg_hash_double(hash, w->cull_viewport.x1);
+    vgg_hash_double(hash, w->cull_viewport.y1);
+  }
+
+  for (i = 0; i < doc->count; ++i)
+  {
+    vgg_document_element(doc, i, &element);
+    vgg_hash_element(hash, &element.header);
   }
 }
 
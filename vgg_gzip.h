@@ -0,0 +1,495 @@
+/* vgg_gzip.h - v0.1 - public domain data structures - nickscha 2025
+
+A C89 standard compliant, single header, nostdlib (no C Standard Library) streaming deflate encoder with gzip
+framing for vgg.h. It plugs in as the sink of a vgg_svg_writer and writes the compressed bytes to a second
+writer, so .svgz files are produced in one pass without a copy of the uncompressed document.
+
+The encoder uses LZ77 with hash chains and fixed Huffman codes (RFC 1951), wrapped in a gzip member (RFC 1952).
+
+LICENSE
+
+  Placed in the public domain and also MIT licensed.
+  See end of file for detailed license information.
+
+*/
+#ifndef VGG_GZIP_H
+#define VGG_GZIP_H
+
+#ifndef VGG_H
+#error "vgg_gzip: include vgg.h first"
+#endif
+
+#define VGG_GZIP_WINDOW 32768                /* Deflate history size */
+#define VGG_GZIP_WINDOW_MASK (VGG_GZIP_WINDOW - 1)
+#define VGG_GZIP_HASH_SIZE 32768             /* Hash table entries for 3 byte prefixes */
+#define VGG_GZIP_MATCH_MIN 3
+#define VGG_GZIP_MATCH_MAX 258
+#define VGG_GZIP_LOOKAHEAD (VGG_GZIP_MATCH_MAX + 2) /* Bytes needed after a position before it is encoded */
+
+#define VGG_GZIP_LEVEL_FAST 1 /* Short hash chains, no lazy matching */
+#define VGG_GZIP_LEVEL_BEST 2 /* Long hash chains with one step lazy matching */
+
+/* Encoder state, about 400 KB. Usually declared static. */
+typedef struct vgg_gzip
+{
+  vgg_svg_writer *out; /* Receives the gzip bytes */
+
+  int level;
+  int chain;       /* Maximum hash chain positions compared per match */
+  int match_nice;  /* Chain search stops at a match this long */
+  int match_good;  /* Matches at least this long are taken without lazy check */
+  int insert_max;  /* Positions inside longer matches are not hashed (fast level) */
+  int started;     /* gzip header and block header written */
+
+  unsigned long crc;  /* CRC-32 of the uncompressed bytes */
+  unsigned long size; /* Uncompressed size modulo 2^32 */
+
+  unsigned long bit_buffer;
+  int bit_count;
+
+  int position; /* Next window byte to encode */
+  int end;      /* Bytes in window */
+
+  unsigned long crc_table[4][256]; /* Slicing by 4 */
+  unsigned short codes[288];       /* Fixed literal/length codes, bit reversed */
+  unsigned char code_lengths[288];
+
+  int head[VGG_GZIP_HASH_SIZE]; /* Last window position per hash, -1 if none */
+  int prev[VGG_GZIP_WINDOW];    /* Previous position with the same hash */
+
+  unsigned char window[2 * VGG_GZIP_WINDOW];
+
+} vgg_gzip;
+
+VGG_API VGG_INLINE unsigned int vgg_gzip_reverse(unsigned int code, int length)
+{
+  unsigned int reversed = 0;
+  int i;
+
+  for (i = 0; i < length; ++i)
+  {
+    reversed = (reversed << 1) | ((code >> i) & 1U);
+  }
+  return reversed;
+}
+
+VGG_API VGG_INLINE unsigned long vgg_gzip_crc32(unsigned long table[4][256], unsigned long crc, unsigned char *data, unsigned long size)
+{
+  unsigned long i = 0;
+
+  crc = ~crc & 0xFFFFFFFFUL;
+
+  /* Four bytes per step */
+  for (; i + 4 <= size; i += 4)
+  {
+    crc ^= (unsigned long)data[i] | ((unsigned long)data[i + 1] << 8) | ((unsigned long)data[i + 2] << 16) | ((unsigned long)data[i + 3] << 24);
+    crc = table[3][crc & 0xFF] ^ table[2][(crc >> 8) & 0xFF] ^ table[1][(crc >> 16) & 0xFF] ^ table[0][(crc >> 24) & 0xFF];
+  }
+
+  for (; i < size; ++i)
+  {
+    crc = table[0][(crc ^ data[i]) & 0xFF] ^ (crc >> 8);
+  }
+  return ~crc & 0xFFFFFFFFUL;
+}
+
+/* level is VGG_GZIP_LEVEL_FAST or VGG_GZIP_LEVEL_BEST */
+VGG_API VGG_INLINE void vgg_gzip_init(vgg_gzip *gz, vgg_svg_writer *out, int level)
+{
+  unsigned int i;
+  int k;
+
+  gz->out = out;
+  gz->level = level;
+  gz->chain = (level >= VGG_GZIP_LEVEL_BEST) ? 64 : 4;
+  gz->match_nice = (level >= VGG_GZIP_LEVEL_BEST) ? 128 : 32;
+  gz->match_good = (level >= VGG_GZIP_LEVEL_BEST) ? 32 : VGG_GZIP_MATCH_MAX;
+  gz->insert_max = (level >= VGG_GZIP_LEVEL_BEST) ? VGG_GZIP_MATCH_MAX : 16;
+  gz->started = 0;
+  gz->crc = 0;
+  gz->size = 0;
+  gz->bit_buffer = 0;
+  gz->bit_count = 0;
+  gz->position = 0;
+  gz->end = 0;
+
+  for (i = 0; i < 256; ++i)
+  {
+    unsigned long c = i;
+    for (k = 0; k < 8; ++k)
+    {
+      c = (c & 1UL) ? (0xEDB88320UL ^ (c >> 1)) : (c >> 1);
+    }
+    gz->crc_table[0][i] = c;
+  }
+  for (i = 0; i < 256; ++i)
+  {
+    for (k = 1; k < 4; ++k)
+    {
+      unsigned long c = gz->crc_table[k - 1][i];
+      gz->crc_table[k][i] = gz->crc_table[0][c & 0xFF] ^ (c >> 8);
+    }
+  }
+
+  /* RFC 1951 3.2.6 */
+  for (i = 0; i < 288; ++i)
+  {
+    unsigned int code;
+    int length;
+
+    if (i < 144)
+    {
+      code = 0x30 + i;
+      length = 8;
+    }
+    else if (i < 256)
+    {
+      code = 0x190 + (i - 144);
+      length = 9;
+    }
+    else if (i < 280)
+    {
+      code = i - 256;
+      length = 7;
+    }
+    else
+    {
+      code = 0xC0 + (i - 280);
+      length = 8;
+    }
+    gz->codes[i] = (unsigned short)vgg_gzip_reverse(code, length);
+    gz->code_lengths[i] = (unsigned char)length;
+  }
+
+  for (k = 0; k < VGG_GZIP_HASH_SIZE; ++k)
+  {
+    gz->head[k] = -1;
+  }
+}
+
+VGG_API VGG_INLINE void vgg_gzip_bits(vgg_gzip *gz, unsigned long value, int count)
+{
+  gz->bit_buffer |= value << gz->bit_count;
+  gz->bit_count += count;
+
+  while (gz->bit_count >= 8)
+  {
+    vgg_svg_putc(gz->out, (char)(gz->bit_buffer & 0xFF));
+    gz->bit_buffer >>= 8;
+    gz->bit_count -= 8;
+  }
+}
+
+VGG_API VGG_INLINE void vgg_gzip_symbol(vgg_gzip *gz, unsigned int symbol)
+{
+  vgg_gzip_bits(gz, gz->codes[symbol], gz->code_lengths[symbol]);
+}
+
+/* Length 3..258 and distance 1..32768 with their extra bits */
+VGG_API VGG_INLINE void vgg_gzip_match(vgg_gzip *gz, unsigned int length, unsigned int distance)
+{
+  unsigned int x = length - 3, code;
+  int bits = 0;
+
+  if (length == 258)
+  {
+    vgg_gzip_symbol(gz, 285);
+  }
+  else if (x < 8)
+  {
+    vgg_gzip_symbol(gz, 257 + x);
+  }
+  else
+  {
+    while ((x >> (bits + 1)) != 0)
+    {
+      bits++;
+    }
+    /* bits = floor(log2 x), extra bits = bits - 2 */
+    vgg_gzip_symbol(gz, 257 + 4 * (unsigned int)(bits - 1) + ((x >> (bits - 2)) & 3U));
+    vgg_gzip_bits(gz, x & ((1UL << (bits - 2)) - 1), bits - 2);
+  }
+
+  x = distance - 1;
+  if (x < 4)
+  {
+    vgg_gzip_bits(gz, vgg_gzip_reverse(x, 5), 5);
+    return;
+  }
+
+  bits = 0;
+  while ((x >> (bits + 1)) != 0)
+  {
+    bits++;
+  }
+  code = 2 * (unsigned int)bits + ((x >> (bits - 1)) & 1U);
+  vgg_gzip_bits(gz, vgg_gzip_reverse(code, 5), 5);
+  vgg_gzip_bits(gz, x & ((1UL << (bits - 1)) - 1), bits - 1);
+}
+
+VGG_API VGG_INLINE unsigned int vgg_gzip_hash(unsigned char *p)
+{
+  return (((unsigned int)p[0] << 10) ^ ((unsigned int)p[1] << 5) ^ (unsigned int)p[2]) & (VGG_GZIP_HASH_SIZE - 1);
+}
+
+VGG_API VGG_INLINE void vgg_gzip_insert(vgg_gzip *gz, int position)
+{
+  unsigned int hash = vgg_gzip_hash(gz->window + position);
+
+  gz->prev[position & VGG_GZIP_WINDOW_MASK] = gz->head[hash];
+  gz->head[hash] = position;
+}
+
+/* Longest match for position along its hash chain, candidate is the chain head. Returns the length (0 if below 3). */
+VGG_API VGG_INLINE int vgg_gzip_longest(vgg_gzip *gz, int position, int candidate, int length_max, int *distance)
+{
+  unsigned char *window = gz->window;
+  unsigned char *p = window + position;
+  int best = VGG_GZIP_MATCH_MIN - 1;
+  int chain = gz->chain;
+  int nice = (gz->match_nice < length_max) ? gz->match_nice : length_max;
+
+  while (candidate >= 0 && candidate < position && position - candidate <= VGG_GZIP_WINDOW && chain-- > 0)
+  {
+    unsigned char *q = window + candidate;
+    int next;
+
+    if (q[best] == p[best] && q[0] == p[0] && q[1] == p[1])
+    {
+      int length = 2;
+      while (length < length_max && q[length] == p[length])
+      {
+        length++;
+      }
+
+      if (length > best)
+      {
+        best = length;
+        *distance = position - candidate;
+        if (length >= nice)
+        {
+          break;
+        }
+      }
+    }
+
+    /* Ring slots are reused, older positions only */
+    next = gz->prev[candidate & VGG_GZIP_WINDOW_MASK];
+    if (next >= candidate)
+    {
+      break;
+    }
+    candidate = next;
+  }
+
+  return best >= VGG_GZIP_MATCH_MIN ? best : 0;
+}
+
+/* Encodes window bytes up to limit */
+VGG_API VGG_INLINE void vgg_gzip_compress(vgg_gzip *gz, int limit)
+{
+  unsigned char *window = gz->window;
+  int position = gz->position;
+
+  while (position < limit)
+  {
+    int length_max = gz->end - position, length = 0, distance = 0;
+
+    length_max = (length_max < VGG_GZIP_MATCH_MAX) ? length_max : VGG_GZIP_MATCH_MAX;
+
+    if (length_max >= VGG_GZIP_MATCH_MIN)
+    {
+      int candidate = gz->head[vgg_gzip_hash(window + position)];
+      length = vgg_gzip_longest(gz, position, candidate, length_max, &distance);
+      vgg_gzip_insert(gz, position);
+
+      /* Lazy: a longer match at the next byte wins over this one */
+      if (length && length < gz->match_good && gz->level >= VGG_GZIP_LEVEL_BEST && length_max > length + 1)
+      {
+        int next_distance = 0;
+        int next_length = vgg_gzip_longest(gz, position + 1, gz->head[vgg_gzip_hash(window + position + 1)], length_max - 1, &next_distance);
+        if (next_length > length)
+        {
+          length = 0;
+        }
+      }
+    }
+
+    if (!length)
+    {
+      vgg_gzip_symbol(gz, window[position]);
+      position++;
+      continue;
+    }
+
+    vgg_gzip_match(gz, (unsigned int)length, (unsigned int)distance);
+
+    if (length <= gz->insert_max)
+    {
+      int i;
+      for (i = 1; i < length; ++i)
+      {
+        if (position + i + 2 < gz->end)
+        {
+          vgg_gzip_insert(gz, position + i);
+        }
+      }
+    }
+    position += length;
+  }
+
+  gz->position = position;
+}
+
+/* Drops the oldest half of the window */
+VGG_API VGG_INLINE void vgg_gzip_slide(vgg_gzip *gz)
+{
+  int i;
+
+  vgg_move_bytes(gz->window, gz->window + VGG_GZIP_WINDOW, (unsigned long)(gz->end - VGG_GZIP_WINDOW));
+  gz->end -= VGG_GZIP_WINDOW;
+  gz->position -= VGG_GZIP_WINDOW;
+
+  for (i = 0; i < VGG_GZIP_HASH_SIZE; ++i)
+  {
+    gz->head[i] = (gz->head[i] >= VGG_GZIP_WINDOW) ? gz->head[i] - VGG_GZIP_WINDOW : -1;
+  }
+  for (i = 0; i < VGG_GZIP_WINDOW; ++i)
+  {
+    gz->prev[i] = (gz->prev[i] >= VGG_GZIP_WINDOW) ? gz->prev[i] - VGG_GZIP_WINDOW : -1;
+  }
+}
+
+/* Member header and the header of the one fixed Huffman block */
+VGG_API VGG_INLINE void vgg_gzip_start(vgg_gzip *gz)
+{
+  /* Magic, deflate, no flags or time, extra flags (2 = best compression, 4 = fastest), unknown OS */
+  unsigned char header[10] = {0x1F, 0x8B, 8, 0, 0, 0, 0, 0, 4, 0xFF};
+  int i;
+
+  header[8] = (unsigned char)((gz->level >= VGG_GZIP_LEVEL_BEST) ? 2 : 4);
+  for (i = 0; i < 10; ++i)
+  {
+    vgg_svg_putc(gz->out, (char)header[i]);
+  }
+
+  vgg_gzip_bits(gz, 2, 3); /* BFINAL 0, BTYPE 01 */
+  gz->started = 1;
+}
+
+/* Appends size uncompressed bytes */
+VGG_API VGG_INLINE void vgg_gzip_write(vgg_gzip *gz, unsigned char *data, unsigned long size)
+{
+  if (!gz->started)
+  {
+    vgg_gzip_start(gz);
+  }
+
+  gz->crc = vgg_gzip_crc32(gz->crc_table, gz->crc, data, size);
+  gz->size = (gz->size + size) & 0xFFFFFFFFUL;
+
+  while (size > 0)
+  {
+    unsigned long room = (unsigned long)(2 * VGG_GZIP_WINDOW - gz->end);
+    unsigned long n = (size < room) ? size : room;
+
+    vgg_move_bytes(gz->window + gz->end, data, n);
+    gz->end += (int)n;
+    data += n;
+    size -= n;
+
+    if (gz->end == 2 * VGG_GZIP_WINDOW)
+    {
+      vgg_gzip_compress(gz, gz->end - VGG_GZIP_LOOKAHEAD);
+      vgg_gzip_slide(gz);
+    }
+  }
+}
+
+/* Sink for vgg_svg_writer_create_stream, sink_user has to point to an initialized vgg_gzip */
+VGG_API VGG_INLINE int vgg_gzip_sink(vgg_svg_writer *w)
+{
+  vgg_gzip *gz = (vgg_gzip *)w->sink_user;
+
+  vgg_gzip_write(gz, w->buffer, (unsigned long)w->length);
+  w->length = 0;
+  return !gz->out->truncated;
+}
+
+/* Encodes the remaining bytes and writes the gzip trailer, flushes out if it streams.
+   Call after the last flush of the uncompressed writer (vgg_svg_end). Returns 0 if bytes were dropped.
+*/
+VGG_API VGG_INLINE int vgg_gzip_finish(vgg_gzip *gz)
+{
+  int i;
+
+  if (!gz->started)
+  {
+    vgg_gzip_start(gz);
+  }
+
+  vgg_gzip_compress(gz, gz->end);
+
+  /* End of block, then an empty final block */
+  vgg_gzip_symbol(gz, 256);
+  vgg_gzip_bits(gz, 3, 3); /* BFINAL 1, BTYPE 01 */
+  vgg_gzip_symbol(gz, 256);
+  vgg_gzip_bits(gz, 0, 7); /* Byte align */
+  gz->bit_buffer = 0;
+  gz->bit_count = 0;
+
+  for (i = 0; i < 4; ++i)
+  {
+    vgg_svg_putc(gz->out, (char)((gz->crc >> (8 * i)) & 0xFF));
+  }
+  for (i = 0; i < 4; ++i)
+  {
+    vgg_svg_putc(gz->out, (char)((gz->size >> (8 * i)) & 0xFF));
+  }
+
+  return vgg_svg_writer_flush(gz->out);
+}
+
+#endif /* VGG_GZIP_H */
+
+/*
+   ------------------------------------------------------------------------------
+   This software is available under 2 licenses -- choose whichever you prefer.
+   ------------------------------------------------------------------------------
+   ALTERNATIVE A - MIT License
+   Copyright (c) 2025 nickscha
+   Permission is hereby granted, free of charge, to any person obtaining a copy of
+   this software and associated documentation files (the "Software"), to deal in
+   the Software without restriction, including without limitation the rights to
+   use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies
+   of the Software, and to permit persons to whom the Software is furnished to do
+   so, subject to the following conditions:
+   The above copyright notice and this permission notice shall be included in all
+   copies or substantial portions of the Software.
+   THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+   IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+   FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+   AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+   LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+   OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+   SOFTWARE.
+   ------------------------------------------------------------------------------
+   ALTERNATIVE B - Public Domain (www.unlicense.org)
+   This is free and unencumbered software released into the public domain.
+   Anyone is free to copy, modify, publish, use, compile, sell, or distribute this
+   software, either in source code form or as a compiled binary, for any purpose,
+   commercial or non-commercial, and by any means.
+   In jurisdictions that recognize copyright laws, the author or authors of this
+   software dedicate any and all copyright interest in the software to the public
+   domain. We make this dedication for the benefit of the public at large and to
+   the detriment of our heirs and successors. We intend this dedication to be an
+   overt act of relinquishment in perpetuity of all present and future rights to
+   this software under copyright law.
+   THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+   IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+   FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+   AUTHORS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN
+   ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+   WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+   ------------------------------------------------------------------------------
+*/
@@ -0,0 +1,301 @@
+/* vgg_platform_async.h - v0.1 - public domain data structures - nickscha 2025
+
+A C89 standard compliant, single header, nostdlib (no C Standard Library) pipelined writer for vgg.h using
+OS-specific threads. The writer fills one of several chunk buffers while a background I/O thread hands the
+full ones to a sink (e.g. vgg_platform_stream_sink), so formatting and I/O overlap.
+
+Supports:
+ - Linux / macOS (POSIX threads)
+ - BSDs (FreeBSD, NetBSD, OpenBSD, Haiku)
+ - Windows and other systems: the sink is called on the writing thread like a plain stream writer
+
+LICENSE
+
+  Placed in the public domain and also MIT licensed.
+  See end of file for detailed license information.
+
+*/
+#ifndef VGG_PLATFORM_ASYNC_H
+#define VGG_PLATFORM_ASYNC_H
+
+#ifndef VGG_H
+#error "vgg_platform_async: include vgg.h first"
+#endif
+
+/* #############################################################################
+ * # COMPILER SETTINGS
+ * #############################################################################
+ */
+/* Check if using C99 or later (inline is supported) */
+#ifndef VGG_PLATFORM_API
+#if __STDC_VERSION__ >= 199901L
+#define VGG_PLATFORM_INLINE inline
+#define VGG_PLATFORM_API extern
+#elif defined(__GNUC__) || defined(__clang__)
+#define VGG_PLATFORM_INLINE __inline__
+#define VGG_PLATFORM_API static
+#elif defined(_MSC_VER)
+#define VGG_PLATFORM_INLINE __inline
+#define VGG_PLATFORM_API static
+#else
+#define VGG_PLATFORM_INLINE
+#define VGG_PLATFORM_API static
+#endif
+#endif
+
+#ifndef VGG_PLATFORM_ASYNC_BUFFERS_MAX
+#define VGG_PLATFORM_ASYNC_BUFFERS_MAX 16
+#endif
+
+#if defined(__linux__) || defined(__APPLE__) || defined(__FreeBSD__) || defined(__NetBSD__) || defined(__OpenBSD__) || defined(__HAIKU__)
+#define VGG_PLATFORM_ASYNC_THREADS
+#include <pthread.h>
+#endif
+
+typedef struct vgg_platform_async
+{
+    vgg_svg_sink sink; /* Called on the I/O thread, has to consume the whole buffer */
+    void *sink_user;
+
+    unsigned char *buffers[VGG_PLATFORM_ASYNC_BUFFERS_MAX];
+    int lengths[VGG_PLATFORM_ASYNC_BUFFERS_MAX];
+    int count;
+    int capacity; /* Bytes per buffer */
+
+    int head;   /* Oldest queued buffer, next one for the I/O thread */
+    int tail;   /* Buffer the writer fills */
+    int queued; /* Buffers waiting for or in I/O */
+    int failed; /* Set once the sink failed, later buffers are dropped */
+    int stop;
+
+    unsigned long stalls; /* Times the writer had to wait for a free buffer */
+
+#ifdef VGG_PLATFORM_ASYNC_THREADS
+    pthread_t thread;
+    pthread_mutex_t mutex;
+    pthread_cond_t queued_changed;
+    int started;
+#endif
+
+} vgg_platform_async;
+
+/* Hands buffer index to the downstream sink */
+VGG_PLATFORM_API VGG_PLATFORM_INLINE int vgg_platform_async_flush_buffer(vgg_platform_async *async, int index)
+{
+    vgg_svg_writer io = vgg_svg_writer_create_stream(async->buffers[index], async->capacity, async->sink, async->sink_user);
+    io.length = async->lengths[index];
+    return async->sink(&io);
+}
+
+#ifdef VGG_PLATFORM_ASYNC_THREADS
+
+VGG_PLATFORM_API VGG_PLATFORM_INLINE void *vgg_platform_async_thread(void *user)
+{
+    vgg_platform_async *async = (vgg_platform_async *)user;
+
+    pthread_mutex_lock(&async->mutex);
+    for (;;)
+    {
+        int index, success;
+
+        while (async->queued == 0 && !async->stop)
+        {
+            pthread_cond_wait(&async->queued_changed, &async->mutex);
+        }
+        if (async->queued == 0)
+        {
+            break;
+        }
+
+        /* The writer never touches queued buffers, I/O runs unlocked */
+        index = async->head;
+        pthread_mutex_unlock(&async->mutex);
+        success = async->failed ? 0 : vgg_platform_async_flush_buffer(async, index);
+        pthread_mutex_lock(&async->mutex);
+
+        async->failed |= !success;
+        async->head = (async->head + 1) % async->count;
+        async->queued--;
+        pthread_cond_broadcast(&async->queued_changed);
+    }
+    pthread_mutex_unlock(&async->mutex);
+
+    return 0;
+}
+
+#endif
+
+/* Queues the filled buffer and continues in the next free one, waits if all are queued (backpressure) */
+VGG_PLATFORM_API VGG_PLATFORM_INLINE int vgg_platform_async_sink(vgg_svg_writer *w)
+{
+    vgg_platform_async *async = (vgg_platform_async *)w->sink_user;
+
+    async->lengths[async->tail] = w->length;
+
+#ifdef VGG_PLATFORM_ASYNC_THREADS
+    if (async->started)
+    {
+        int failed;
+
+        pthread_mutex_lock(&async->mutex);
+        async->queued++;
+        pthread_cond_broadcast(&async->queued_changed);
+
+        if (async->queued == async->count)
+        {
+            async->stalls++;
+        }
+        while (async->queued == async->count)
+        {
+            pthread_cond_wait(&async->queued_changed, &async->mutex);
+        }
+        failed = async->failed;
+        pthread_mutex_unlock(&async->mutex);
+
+        async->tail = (async->tail + 1) % async->count;
+        w->buffer = async->buffers[async->tail];
+        w->length = 0;
+        return !failed;
+    }
+#endif
+
+    /* No I/O thread, written right away */
+    async->failed |= !vgg_platform_async_flush_buffer(async, async->tail);
+    w->length = 0;
+    return !async->failed;
+}
+
+/* Splits memory into count (2 or more) chunk buffers and creates the writer w that fills them.
+   Full buffers are passed to sink (with sink_user) on a background thread. Errors of the sink are
+   reported by later flushes of w and by vgg_platform_async_finish.
+*/
+VGG_PLATFORM_API VGG_PLATFORM_INLINE int vgg_platform_async_start(
+    vgg_platform_async *async,
+    vgg_svg_writer *w,
+    unsigned char *memory,
+    unsigned long memory_size,
+    int count,
+    vgg_svg_sink sink,
+    void *sink_user)
+{
+    unsigned long capacity;
+    int i;
+
+    count = (count < 2) ? 2 : count;
+    count = (count > VGG_PLATFORM_ASYNC_BUFFERS_MAX) ? VGG_PLATFORM_ASYNC_BUFFERS_MAX : count;
+    capacity = memory_size / (unsigned long)count;
+    capacity = (capacity < 0x40000000UL) ? capacity : 0x40000000UL;
+    if (capacity == 0)
+    {
+        return 0;
+    }
+
+    async->sink = sink;
+    async->sink_user = sink_user;
+    async->count = count;
+    async->capacity = (int)capacity;
+    async->head = 0;
+    async->tail = 0;
+    async->queued = 0;
+    async->failed = 0;
+    async->stop = 0;
+    async->stalls = 0;
+
+    for (i = 0; i < count; ++i)
+    {
+        async->buffers[i] = memory + (unsigned long)i * capacity;
+        async->lengths[i] = 0;
+    }
+
+    *w = vgg_svg_writer_create_stream(async->buffers[0], async->capacity, vgg_platform_async_sink, async);
+
+#ifdef VGG_PLATFORM_ASYNC_THREADS
+    async->started = 0;
+    if (pthread_mutex_init(&async->mutex, 0) != 0)
+    {
+        return 1;
+    }
+    if (pthread_cond_init(&async->queued_changed, 0) != 0)
+    {
+        pthread_mutex_destroy(&async->mutex);
+        return 1;
+    }
+    async->started = pthread_create(&async->thread, 0, vgg_platform_async_thread, async) == 0;
+    if (!async->started)
+    {
+        pthread_cond_destroy(&async->queued_changed);
+        pthread_mutex_destroy(&async->mutex);
+    }
+#endif
+
+    return 1;
+}
+
+/* Flushes w, waits until all buffers went through the sink and stops the I/O thread.
+   Returns 0 if the sink failed or bytes were dropped.
+*/
+VGG_PLATFORM_API VGG_PLATFORM_INLINE int vgg_platform_async_finish(vgg_platform_async *async, vgg_svg_writer *w)
+{
+    int success = vgg_svg_writer_flush(w);
+
+#ifdef VGG_PLATFORM_ASYNC_THREADS
+    if (async->started)
+    {
+        pthread_mutex_lock(&async->mutex);
+        async->stop = 1;
+        pthread_cond_broadcast(&async->queued_changed);
+        pthread_mutex_unlock(&async->mutex);
+
+        pthread_join(async->thread, 0);
+        pthread_cond_destroy(&async->queued_changed);
+        pthread_mutex_destroy(&async->mutex);
+        async->started = 0;
+    }
+#endif
+
+    return success && !async->failed;
+}
+
+#endif /* VGG_PLATFORM_ASYNC_H */
+
+/*
+   ------------------------------------------------------------------------------
+   This software is available under 2 licenses -- choose whichever you prefer.
+   ------------------------------------------------------------------------------
+   ALTERNATIVE A - MIT License
+   Copyright (c) 2025 nickscha
+   Permission is hereby granted, free of charge, to any person obtaining a copy of
+   this software and associated documentation files (the "Software"), to deal in
+   the Software without restriction, including without limitation the rights to
+   use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies
+   of the Software, and to permit persons to whom the Software is furnished to do
+   so, subject to the following conditions:
+   The above copyright notice and this permission notice shall be included in all
+   copies or substantial portions of the Software.
+   THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+   IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+   FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+   AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+   LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+   OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+   SOFTWARE.
+   ------------------------------------------------------------------------------
+   ALTERNATIVE B - Public Domain (www.unlicense.org)
+   This is free and unencumbered software released into the public domain.
+   Anyone is free to copy, modify, publish, use, compile, sell, or distribute this
+   software, either in source code form or as a compiled binary, for any purpose,
+   commercial or non-commercial, and by any means.
+   In jurisdictions that recognize copyright laws, the author or authors of this
+   software dedicate any and all copyright interest in the software to the public
+   domain. We make this dedication for the benefit of the public at large and to
+   the detriment of our heirs and successors. We intend this dedication to be an
+   overt act of relinquishment in perpetuity of all present and future rights to
+   this software under copyright law.
+   THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+   IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+   FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+   AUTHORS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN
+   ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+   WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+   ------------------------------------------------------------------------------
+*/
@@ -0,0 +1,975 @@
+/* vgg_platform_cache.h - v0.1 - public domain data structures - nickscha 2025
+
+A C89 standard compliant, single header, nostdlib (no C Standard Library) content-addressed cache of rendered
+fragments in a local directory using OS-specific APIs. Fragments are stored under their key (e.g. the
+vgg_hash of the rendered elements) and memory-mapped on a hit, the cache size is bounded by evicting the
+least recently used fragments.
+
+Supports:
+ - Linux / macOS (POSIX)
+ - BSDs (FreeBSD, NetBSD, OpenBSD, Haiku)
+ - Windows (Win32 API)
+
+LICENSE
+
+  Placed in the public domain and also MIT licensed.
+  See end of file for detailed license information.
+
+*/
+#ifndef VGG_PLATFORM_CACHE_H
+#define VGG_PLATFORM_CACHE_H
+
+/* #############################################################################
+ * # COMPILER SETTINGS
+ * #############################################################################
+ */
+/* Check if using C99 or later (inline is supported) */
+#ifndef VGG_PLATFORM_API
+#if __STDC_VERSION__ >= 199901L
+#define VGG_PLATFORM_INLINE inline
+#define VGG_PLATFORM_API extern
+#elif defined(__GNUC__) || defined(__clang__)
+#define VGG_PLATFORM_INLINE __inline__
+#define VGG_PLATFORM_API static
+#elif defined(_MSC_VER)
+#define VGG_PLATFORM_INLINE __inline
+#define VGG_PLATFORM_API static
+#else
+#define VGG_PLATFORM_INLINE
+#define VGG_PLATFORM_API static
+#endif
+#endif
+
+/* Maximum length of the cache directory path */
+#ifndef VGG_PLATFORM_CACHE_DIRECTORY_SIZE
+#define VGG_PLATFORM_CACHE_DIRECTORY_SIZE 480
+#endif
+
+/* Fragment files are named <key>.vggc */
+#define VGG_PLATFORM_CACHE_KEY_SIZE 16
+
+typedef struct vgg_platform_cache
+{
+    char directory[VGG_PLATFORM_CACHE_DIRECTORY_SIZE];
+
+    unsigned long size;     /* Bytes of all cached fragments */
+    unsigned long size_max; /* Least recently used fragments are evicted down to 3/4 of it when exceeded */
+
+    unsigned long hits;
+    unsigned long misses;
+    unsigned long evictions;
+
+    unsigned long temporaries; /* Temporary files created by vgg_platform_cache_put, part of their names */
+
+} vgg_platform_cache;
+
+/* Read only bytes of a cached fragment, valid until vgg_platform_cache_release */
+typedef struct vgg_platform_cache_fragment
+{
+    unsigned char *data;
+    unsigned long size;
+
+} vgg_platform_cache_fragment;
+
+VGG_PLATFORM_API VGG_PLATFORM_INLINE void vgg_platform_cache_init(vgg_platform_cache *cache, char *directory, unsigned long size_max)
+{
+    int i;
+
+    for (i = 0; directory[i] && i < VGG_PLATFORM_CACHE_DIRECTORY_SIZE - 1; ++i)
+    {
+        cache->directory[i] = directory[i];
+    }
+    cache->directory[i] = '\0';
+
+    cache->size = 0;
+    cache->size_max = size_max;
+    cache->hits = 0;
+    cache->misses = 0;
+    cache->evictions = 0;
+    cache->temporaries = 0;
+}
+
+/* <directory>/<name>, returns 0 if it does not fit */
+VGG_PLATFORM_API VGG_PLATFORM_INLINE int vgg_platform_cache_path(vgg_platform_cache *cache, char *name, char *path, int path_size)
+{
+    int length = 0, i;
+
+    for (i = 0; cache->directory[i]; ++i)
+    {
+        if (length >= path_size - 1)
+        {
+            return 0;
+        }
+        path[length++] = cache->directory[i];
+    }
+
+    if (length >= path_size - 1)
+    {
+        return 0;
+    }
+    path[length++] = '/';
+
+    for (i = 0; name[i]; ++i)
+    {
+        if (length >= path_size - 1)
+        {
+            return 0;
+        }
+        path[length++] = name[i];
+    }
+
+    path[length] = '\0';
+    return 1;
+}
+
+/* Fragment files are named <16 key characters>.vggc */
+VGG_PLATFORM_API VGG_PLATFORM_INLINE int vgg_platform_cache_is_fragment(char *name)
+{
+    int i;
+
+    for (i = 0; i < VGG_PLATFORM_CACHE_KEY_SIZE; ++i)
+    {
+        if (!name[i] || name[i] == '.')
+        {
+            return 0;
+        }
+    }
+
+    return name[i] == '.' && name[i + 1] == 'v' && name[i + 2] == 'g' && name[i + 3] == 'g' && name[i + 4] == 'c' && !name[i + 5];
+}
+
+/* Key of at most VGG_PLATFORM_CACHE_KEY_SIZE characters to its file name */
+VGG_PLATFORM_API VGG_PLATFORM_INLINE void vgg_platform_cache_name(char *key, char *name, char *suffix)
+{
+    int i, j;
+
+    for (i = 0; key[i] && i < VGG_PLATFORM_CACHE_KEY_SIZE; ++i)
+    {
+        name[i] = key[i];
+    }
+    for (j = 0; suffix[j]; ++j)
+    {
+        name[i + j] = suffix[j];
+    }
+    name[i + j] = '\0';
+}
+
+/* Temporary files are named <key>.<process id>.<count>.tmp, created exclusively. A name taken by
+   another cache of the same process is retried with the next count.
+*/
+#define VGG_PLATFORM_CACHE_TEMPORARY_SIZE (VGG_PLATFORM_CACHE_KEY_SIZE + 48)
+#define VGG_PLATFORM_CACHE_TEMPORARY_ATTEMPTS 16
+
+VGG_PLATFORM_API VGG_PLATFORM_INLINE void vgg_platform_cache_name_temporary(vgg_platform_cache *cache, char *key, char *name, unsigned long id)
+{
+    unsigned long values[2];
+    char digits[24];
+    int i, n, v;
+
+    values[0] = id;
+    values[1] = cache->temporaries++;
+
+    for (i = 0; key[i] && i < VGG_PLATFORM_CACHE_KEY_SIZE; ++i)
+    {
+        name[i] = key[i];
+    }
+    for (v = 0; v < 2; ++v)
+    {
+        n = 0;
+        do
+        {
+            digits[n++] = (char)('0' + values[v] % 10);
+            values[v] /= 10;
+        } while (values[v]);
+
+        name[i++] = '.';
+        while (n > 0)
+        {
+            name[i++] = digits[--n];
+        }
+    }
+    for (n = 0; n < 4; ++n)
+    {
+        name[i++] = ".tmp"[n];
+    }
+    name[i] = '\0';
+}
+
+#ifdef _WIN32
+#define VGG_WIN32_GENERIC_READ (0x80000000L)
+#define VGG_WIN32_GENERIC_WRITE (0x40000000L)
+#define VGG_WIN32_FILE_WRITE_ATTRIBUTES 0x00000100
+#define VGG_WIN32_FILE_SHARE_READ 0x00000001
+#define VGG_WIN32_FILE_SHARE_DELETE 0x00000004
+#define VGG_WIN32_CREATE_NEW 1
+#define VGG_WIN32_CREATE_ALWAYS 2
+#define VGG_WIN32_OPEN_EXISTING 3
+#define VGG_WIN32_ERROR_FILE_EXISTS 80
+#define VGG_WIN32_FILE_ATTRIBUTE_NORMAL 0x00000080
+#define VGG_WIN32_MOVEFILE_REPLACE_EXISTING 0x00000001
+#define VGG_WIN32_PAGE_READONLY 0x02
+#define VGG_WIN32_FILE_MAP_READ 0x0004
+
+/* WIN32_FIND_DATAA, times are FILETIME low/high pairs */
+typedef struct vgg_platform_cache_find_data
+{
+    unsigned long attributes;
+    unsigned long time_creation[2];
+    unsigned long time_access[2];
+    unsigned long time_write[2];
+    unsigned long size_high;
+    unsigned long size_low;
+    unsigned long reserved[2];
+    char name[260];
+    char name_alternate[14];
+
+} vgg_platform_cache_find_data;
+
+#ifndef _WINDOWS_
+#ifndef VGG_WIN32_API
+#define VGG_WIN32_API(r) __declspec(dllimport) r __stdcall
+#endif
+
+VGG_WIN32_API(int)
+CloseHandle(void *hObject);
+
+VGG_WIN32_API(void *)
+CreateFileA(
+    const char *lpFileName,
+    unsigned long dwDesiredAccess,
+    unsigned long dwShareMode,
+    void *,
+    unsigned long dwCreationDisposition,
+    unsigned long dwFlagsAndAttributes,
+    void *hTemplateFile);
+
+VGG_WIN32_API(int)
+WriteFile(
+    void *hFile,
+    const void *lpBuffer,
+    unsigned long nNumberOfBytesToWrite,
+    unsigned long *lpNumberOfBytesWritten,
+    void *lpOverlapped);
+
+VGG_WIN32_API(int)
+MoveFileExA(const char *lpExistingFileName, const char *lpNewFileName, unsigned long dwFlags);
+
+VGG_WIN32_API(int)
+DeleteFileA(const char *lpFileName);
+
+VGG_WIN32_API(int)
+CreateDirectoryA(const char *lpPathName, void *lpSecurityAttributes);
+
+VGG_WIN32_API(unsigned long)
+GetFileSize(void *hFile, unsigned long *lpFileSizeHigh);
+
+VGG_WIN32_API(int)
+SetFileTime(void *hFile, const void *lpCreationTime, const void *lpLastAccessTime, const void *lpLastWriteTime);
+
+VGG_WIN32_API(void)
+GetSystemTimeAsFileTime(void *lpSystemTimeAsFileTime);
+
+VGG_WIN32_API(void *)
+CreateFileMappingA(
+    void *hFile,
+    void *lpFileMappingAttributes,
+    unsigned long flProtect,
+    unsigned long dwMaximumSizeHigh,
+    unsigned long dwMaximumSizeLow,
+    const char *lpName);
+
+VGG_WIN32_API(void *)
+MapViewOfFile(
+    void *hFileMappingObject,
+    unsigned long dwDesiredAccess,
+    unsigned long dwFileOffsetHigh,
+    unsigned long dwFileOffsetLow,
+    unsigned long dwNumberOfBytesToMap);
+
+VGG_WIN32_API(int)
+UnmapViewOfFile(const void *lpBaseAddress);
+
+VGG_WIN32_API(void *)
+FindFirstFileA(const char *lpFileName, void *lpFindFileData);
+
+VGG_WIN32_API(int)
+FindNextFileA(void *hFindFile, void *lpFindFileData);
+
+VGG_WIN32_API(int)
+FindClose(void *hFindFile);
+
+VGG_WIN32_API(unsigned long)
+GetCurrentProcessId(void);
+
+VGG_WIN32_API(unsigned long)
+GetLastError(void);
+
+#endif /* _WINDOWS_   */
+
+/* Called for every fragment in the directory, returning 0 stops the scan */
+typedef int (*vgg_platform_cache_visit)(vgg_platform_cache *cache, vgg_platform_cache_find_data *find, void *user);
+
+VGG_PLATFORM_API VGG_PLATFORM_INLINE void vgg_platform_cache_scan(vgg_platform_cache *cache, vgg_platform_cache_visit f, void *user)
+{
+    char pattern[VGG_PLATFORM_CACHE_DIRECTORY_SIZE + 32];
+    vgg_platform_cache_find_data find;
+    void *handle;
+
+    if (!vgg_platform_cache_path(cache, "*.vggc", pattern, (int)sizeof(pattern)))
+    {
+        return;
+    }
+
+    handle = FindFirstFileA(pattern, (void *)&find);
+    if (handle == (void *)-1)
+    {
+        return;
+    }
+
+    do
+    {
+        /* The pattern also matches short 8.3 names, checked again */
+        if (vgg_platform_cache_is_fragment(find.name) && !f(cache, &find, user))
+        {
+            break;
+        }
+    } while (FindNextFileA(handle, (void *)&find));
+
+    FindClose(handle);
+}
+
+/* Least recently used fragment, keep is skipped */
+typedef struct vgg_platform_cache_oldest
+{
+    char *keep;
+    int found;
+    unsigned long time[2];
+    unsigned long size;
+    char name[VGG_PLATFORM_CACHE_KEY_SIZE + 8];
+
+} vgg_platform_cache_oldest;
+
+VGG_PLATFORM_API VGG_PLATFORM_INLINE int vgg_platform_cache_visit_oldest(vgg_platform_cache *cache, vgg_platform_cache_find_data *find, void *user)
+{
+    vgg_platform_cache_oldest *oldest = (vgg_platform_cache_oldest *)user;
+    unsigned long *time = find->time_write;
+    int i;
+
+    (void)cache;
+
+    for (i = 0; oldest->keep && i < VGG_PLATFORM_CACHE_KEY_SIZE && find->name[i] == oldest->keep[i]; ++i)
+    {
+    }
+    if (oldest->keep && i == VGG_PLATFORM_CACHE_KEY_SIZE)
+    {
+        return 1;
+    }
+
+    if (!oldest->found || time[1] < oldest->time[1] || (time[1] == oldest->time[1] && time[0] < oldest->time[0]))
+    {
+        oldest->found = 1;
+        oldest->time[0] = time[0];
+        oldest->time[1] = time[1];
+        oldest->size = find->size_low;
+        for (i = 0; find->name[i]; ++i)
+        {
+            oldest->name[i] = find->name[i];
+        }
+        oldest->name[i] = '\0';
+    }
+
+    return 1;
+}
+
+VGG_PLATFORM_API VGG_PLATFORM_INLINE int vgg_platform_cache_visit_size(vgg_platform_cache *cache, vgg_platform_cache_find_data *find, void *user)
+{
+    (void)user;
+    cache->size += find->size_low;
+    return 1;
+}
+
+VGG_PLATFORM_API VGG_PLATFORM_INLINE int vgg_platform_cache_visit_delete(vgg_platform_cache *cache, vgg_platform_cache_find_data *find, void *user)
+{
+    char path[VGG_PLATFORM_CACHE_DIRECTORY_SIZE + 32];
+
+    (void)user;
+    if (vgg_platform_cache_path(cache, find->name, path, (int)sizeof(path)))
+    {
+        DeleteFileA(path);
+    }
+    return 1;
+}
+
+/* Removes least recently used fragments (oldest last write time, refreshed on every hit)
+   until size is below the bound, keep is never removed. Mapped fragments cannot be
+   deleted, eviction stops at the first one.
+*/
+VGG_PLATFORM_API VGG_PLATFORM_INLINE void vgg_platform_cache_evict(vgg_platform_cache *cache, unsigned long size, char *keep)
+{
+    char path[VGG_PLATFORM_CACHE_DIRECTORY_SIZE + 32];
+    vgg_platform_cache_oldest oldest;
+
+    while (cache->size > size)
+    {
+        oldest.keep = keep;
+        oldest.found = 0;
+        vgg_platform_cache_scan(cache, vgg_platform_cache_visit_oldest, &oldest);
+
+        if (!oldest.found)
+        {
+            /* Only keep is left */
+            return;
+        }
+
+        if (!vgg_platform_cache_path(cache, oldest.name, path, (int)sizeof(path)) || !DeleteFileA(path))
+        {
+            return;
+        }
+
+        cache->size = (oldest.size < cache->size) ? cache->size - oldest.size : 0;
+        cache->evictions++;
+    }
+}
+
+/* Creates the directory if needed and sums up the fragments already cached by earlier runs */
+VGG_PLATFORM_API VGG_PLATFORM_INLINE int vgg_platform_cache_open(vgg_platform_cache *cache, char *directory, unsigned long size_max)
+{
+    vgg_platform_cache_init(cache, directory, size_max);
+
+    /* Fails if it already exists */
+    CreateDirectoryA(cache->directory, 0);
+    vgg_platform_cache_scan(cache, vgg_platform_cache_visit_size, 0);
+
+    if (cache->size > cache->size_max)
+    {
+        vgg_platform_cache_evict(cache, cache->size_max / 4 * 3, 0);
+    }
+
+    return 1;
+}
+
+/* Maps the fragment stored under key, returns 0 on a miss */
+VGG_PLATFORM_API VGG_PLATFORM_INLINE int vgg_platform_cache_get(vgg_platform_cache *cache, char *key, vgg_platform_cache_fragment *fragment)
+{
+    char name[VGG_PLATFORM_CACHE_KEY_SIZE + 8];
+    char path[VGG_PLATFORM_CACHE_DIRECTORY_SIZE + 32];
+    unsigned long size, size_high, now[2];
+    void *hFile, *hMapping, *data;
+
+    fragment->data = 0;
+    fragment->size = 0;
+
+    vgg_platform_cache_name(key, name, ".vggc");
+    if (!vgg_platform_cache_path(cache, name, path, (int)sizeof(path)))
+    {
+        cache->misses++;
+        return 0;
+    }
+
+    hFile = CreateFileA(path, VGG_WIN32_GENERIC_READ | VGG_WIN32_FILE_WRITE_ATTRIBUTES, VGG_WIN32_FILE_SHARE_READ | VGG_WIN32_FILE_SHARE_DELETE, 0, VGG_WIN32_OPEN_EXISTING, VGG_WIN32_FILE_ATTRIBUTE_NORMAL, 0);
+    if (hFile == (void *)-1)
+    {
+        cache->misses++;
+        return 0;
+    }
+
+    size = GetFileSize(hFile, &size_high);
+    if (size == 0xFFFFFFFFUL || size_high != 0)
+    {
+        CloseHandle(hFile);
+        cache->misses++;
+        return 0;
+    }
+
+    /* Empty files cannot be mapped */
+    if (size > 0)
+    {
+        hMapping = CreateFileMappingA(hFile, 0, VGG_WIN32_PAGE_READONLY, 0, 0, 0);
+        data = hMapping ? MapViewOfFile(hMapping, VGG_WIN32_FILE_MAP_READ, 0, 0, 0) : 0;
+        if (hMapping)
+        {
+            /* The view keeps the mapping alive */
+            CloseHandle(hMapping);
+        }
+        if (!data)
+        {
+            CloseHandle(hFile);
+            cache->misses++;
+            return 0;
+        }
+        fragment->data = (unsigned char *)data;
+        fragment->size = size;
+    }
+
+    /* Recently used fragments are evicted last */
+    GetSystemTimeAsFileTime((void *)now);
+    SetFileTime(hFile, 0, 0, (void *)now);
+    CloseHandle(hFile);
+
+    cache->hits++;
+    return 1;
+}
+
+VGG_PLATFORM_API VGG_PLATFORM_INLINE void vgg_platform_cache_release(vgg_platform_cache_fragment *fragment)
+{
+    if (fragment->data)
+    {
+        UnmapViewOfFile(fragment->data);
+    }
+    fragment->data = 0;
+    fragment->size = 0;
+}
+
+/* Stores size bytes under key. Written to a temporary file of its own first and moved,
+   readers and other writers (also in other processes) never see a partial fragment.
+*/
+VGG_PLATFORM_API VGG_PLATFORM_INLINE int vgg_platform_cache_put(vgg_platform_cache *cache, char *key, unsigned char *data, unsigned long size)
+{
+    char name[VGG_PLATFORM_CACHE_TEMPORARY_SIZE];
+    char path[VGG_PLATFORM_CACHE_DIRECTORY_SIZE + 32];
+    char path_temporary[VGG_PLATFORM_CACHE_DIRECTORY_SIZE + VGG_PLATFORM_CACHE_TEMPORARY_SIZE + 1];
+    unsigned long remaining = size, written, size_old = 0;
+    vgg_platform_cache_find_data find;
+    void *hFile;
+    int attempt;
+
+    vgg_platform_cache_name(key, name, ".vggc");
+    if (!vgg_platform_cache_path(cache, name, path, (int)sizeof(path)))
+    {
+        return 0;
+    }
+
+    for (attempt = 1;; ++attempt)
+    {
+        vgg_platform_cache_name_temporary(cache, key, name, GetCurrentProcessId());
+        if (!vgg_platform_cache_path(cache, name, path_temporary, (int)sizeof(path_temporary)))
+        {
+            return 0;
+        }
+        hFile = CreateFileA(path_temporary, VGG_WIN32_GENERIC_WRITE, 0, 0, VGG_WIN32_CREATE_NEW, VGG_WIN32_FILE_ATTRIBUTE_NORMAL, 0);
+        if (hFile != (void *)-1)
+        {
+            break;
+        }
+        if (GetLastError() != VGG_WIN32_ERROR_FILE_EXISTS || attempt == VGG_PLATFORM_CACHE_TEMPORARY_ATTEMPTS)
+        {
+            return 0;
+        }
+    }
+
+    while (remaining > 0)
+    {
+        if (!WriteFile(hFile, data, remaining, &written, 0) || written == 0)
+        {
+            CloseHandle(hFile);
+            DeleteFileA(path_temporary);
+            return 0;
+        }
+        data += written;
+        remaining -= written;
+    }
+    CloseHandle(hFile);
+
+    /* Replacing a fragment frees its old bytes */
+    hFile = FindFirstFileA(path, (void *)&find);
+    if (hFile != (void *)-1)
+    {
+        FindClose(hFile);
+        size_old = find.size_low;
+    }
+
+    /* Fails while another reader has the old fragment mapped */
+    if (!MoveFileExA(path_temporary, path, VGG_WIN32_MOVEFILE_REPLACE_EXISTING))
+    {
+        DeleteFileA(path_temporary);
+        return 0;
+    }
+
+    cache->size = (size_old < cache->size) ? cache->size - size_old + size : size;
+    if (cache->size > cache->size_max)
+    {
+        vgg_platform_cache_evict(cache, cache->size_max / 4 * 3, key);
+    }
+
+    return 1;
+}
+
+/* Removes all fragments, mapped ones stay */
+VGG_PLATFORM_API VGG_PLATFORM_INLINE void vgg_platform_cache_clear(vgg_platform_cache *cache)
+{
+    cache->size = 0;
+    vgg_platform_cache_scan(cache, vgg_platform_cache_visit_delete, 0);
+}
+
+#elif defined(__linux__) || defined(__APPLE__) || defined(__FreeBSD__) || defined(__NetBSD__) || defined(__OpenBSD__) || defined(__HAIKU__)
+
+#include <fcntl.h>
+#include <unistd.h>
+#include <errno.h>
+#include <stdio.h> /* rename */
+#include <dirent.h>
+#include <utime.h>
+#include <sys/types.h>
+#include <sys/stat.h>
+#include <sys/mman.h>
+
+/* Removes least recently used fragments (oldest modification time, refreshed on every hit)
+   until size is below the bound, keep is never removed.
+*/
+VGG_PLATFORM_API VGG_PLATFORM_INLINE void vgg_platform_cache_evict(vgg_platform_cache *cache, unsigned long size, char *keep)
+{
+    char path[VGG_PLATFORM_CACHE_DIRECTORY_SIZE + 32];
+    char oldest[VGG_PLATFORM_CACHE_KEY_SIZE + 8];
+    struct dirent *entry;
+    struct stat info;
+    DIR *dir;
+
+    while (cache->size > size)
+    {
+        unsigned long oldest_size = 0;
+        time_t oldest_time = 0;
+        int found = 0, i;
+
+        /* One scan per evicted fragment, evicting down to 3/4 of size_max keeps this rare */
+        if (!(dir = opendir(cache->directory)))
+        {
+            return;
+        }
+
+        while ((entry = readdir(dir)) != 0)
+        {
+            if (!vgg_platform_cache_is_fragment(entry->d_name))
+            {
+                continue;
+            }
+            for (i = 0; keep && i < VGG_PLATFORM_CACHE_KEY_SIZE && entry->d_name[i] == keep[i]; ++i)
+            {
+            }
+            if (keep && i == VGG_PLATFORM_CACHE_KEY_SIZE)
+            {
+                continue;
+            }
+            if (!vgg_platform_cache_path(cache, entry->d_name, path, (int)sizeof(path)) || stat(path, &info) != 0)
+            {
+                continue;
+            }
+            if (!found || info.st_mtime < oldest_time)
+            {
+                found = 1;
+                oldest_time = info.st_mtime;
+                oldest_size = (unsigned long)info.st_size;
+                for (i = 0; entry->d_name[i]; ++i)
+                {
+                    oldest[i] = entry->d_name[i];
+                }
+                oldest[i] = '\0';
+            }
+        }
+        closedir(dir);
+
+        if (!found)
+        {
+            /* Only keep is left */
+            return;
+        }
+
+        if (!vgg_platform_cache_path(cache, oldest, path, (int)sizeof(path)) || unlink(path) != 0)
+        {
+            return;
+        }
+
+        cache->size = (oldest_size < cache->size) ? cache->size - oldest_size : 0;
+        cache->evictions++;
+    }
+}
+
+/* Creates the directory if needed and sums up the fragments already cached by earlier runs */
+VGG_PLATFORM_API VGG_PLATFORM_INLINE int vgg_platform_cache_open(vgg_platform_cache *cache, char *directory, unsigned long size_max)
+{
+    char path[VGG_PLATFORM_CACHE_DIRECTORY_SIZE + 32];
+    struct dirent *entry;
+    struct stat info;
+    DIR *dir;
+
+    vgg_platform_cache_init(cache, directory, size_max);
+
+    mkdir(cache->directory, 0755);
+    if (!(dir = opendir(cache->directory)))
+    {
+        return 0;
+    }
+
+    while ((entry = readdir(dir)) != 0)
+    {
+        if (vgg_platform_cache_is_fragment(entry->d_name) && vgg_platform_cache_path(cache, entry->d_name, path, (int)sizeof(path)) && stat(path, &info) == 0)
+        {
+            cache->size += (unsigned long)info.st_size;
+        }
+    }
+    closedir(dir);
+
+    if (cache->size > cache->size_max)
+    {
+        vgg_platform_cache_evict(cache, cache->size_max / 4 * 3, 0);
+    }
+
+    return 1;
+}
+
+/* Maps the fragment stored under key, returns 0 on a miss */
+VGG_PLATFORM_API VGG_PLATFORM_INLINE int vgg_platform_cache_get(vgg_platform_cache *cache, char *key, vgg_platform_cache_fragment *fragment)
+{
+    char name[VGG_PLATFORM_CACHE_KEY_SIZE + 8];
+    char path[VGG_PLATFORM_CACHE_DIRECTORY_SIZE + 32];
+    struct stat info;
+    void *data;
+    int fd;
+
+    fragment->data = 0;
+    fragment->size = 0;
+
+    vgg_platform_cache_name(key, name, ".vggc");
+    if (!vgg_platform_cache_path(cache, name, path, (int)sizeof(path)) || (fd = open(path, O_RDONLY)) < 0)
+    {
+        cache->misses++;
+        return 0;
+    }
+
+    if (fstat(fd, &info) != 0)
+    {
+        close(fd);
+        cache->misses++;
+        return 0;
+    }
+
+    if (info.st_size > 0)
+    {
+        data = mmap(0, (size_t)info.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+        if (data == MAP_FAILED)
+        {
+            close(fd);
+            cache->misses++;
+            return 0;
+        }
+        fragment->data = (unsigned char *)data;
+        fragment->size = (unsigned long)info.st_size;
+    }
+    close(fd);
+
+    /* Recently used fragments are evicted last */
+    utime(path, 0);
+
+    cache->hits++;
+    return 1;
+}
+
+VGG_PLATFORM_API VGG_PLATFORM_INLINE void vgg_platform_cache_release(vgg_platform_cache_fragment *fragment)
+{
+    if (fragment->data)
+    {
+        munmap(fragment->data, (size_t)fragment->size);
+    }
+    fragment->data = 0;
+    fragment->size = 0;
+}
+
+/* Stores size bytes under key. Written to a temporary file of its own first and renamed,
+   readers and other writers (also in other processes) never see a partial fragment.
+*/
+VGG_PLATFORM_API VGG_PLATFORM_INLINE int vgg_platform_cache_put(vgg_platform_cache *cache, char *key, unsigned char *data, unsigned long size)
+{
+    char name[VGG_PLATFORM_CACHE_TEMPORARY_SIZE];
+    char path[VGG_PLATFORM_CACHE_DIRECTORY_SIZE + 32];
+    char path_temporary[VGG_PLATFORM_CACHE_DIRECTORY_SIZE + VGG_PLATFORM_CACHE_TEMPORARY_SIZE + 1];
+    unsigned long remaining = size, size_old = 0;
+    struct stat info;
+    ssize_t written;
+    int fd, attempt;
+
+    vgg_platform_cache_name(key, name, ".vggc");
+    if (!vgg_platform_cache_path(cache, name, path, (int)sizeof(path)))
+    {
+        return 0;
+    }
+
+    for (attempt = 1;; ++attempt)
+    {
+        vgg_platform_cache_name_temporary(cache, key, name, (unsigned long)getpid());
+        if (!vgg_platform_cache_path(cache, name, path_temporary, (int)sizeof(path_temporary)))
+        {
+            return 0;
+        }
+        fd = open(path_temporary, O_WRONLY | O_CREAT | O_EXCL, 0644);
+        if (fd >= 0)
+        {
+            break;
+        }
+        if (errno != EEXIST || attempt == VGG_PLATFORM_CACHE_TEMPORARY_ATTEMPTS)
+        {
+            return 0;
+        }
+    }
+
+    /* write may return less than requested or be interrupted by a signal */
+    while (remaining > 0)
+    {
+        written = write(fd, data, remaining);
+        if (written < 0 && errno == EINTR)
+        {
+            continue;
+        }
+        if (written <= 0)
+        {
+            close(fd);
+            unlink(path_temporary);
+            return 0;
+        }
+        data += written;
+        remaining -= (unsigned long)written;
+    }
+    close(fd);
+
+    /* Replacing a fragment frees its old bytes */
+    if (stat(path, &info) == 0)
+    {
+        size_old = (unsigned long)info.st_size;
+    }
+
+    if (rename(path_temporary, path) != 0)
+    {
+        unlink(path_temporary);
+        return 0;
+    }
+
+    cache->size = (size_old < cache->size) ? cache->size - size_old + size : size;
+    if (cache->size > cache->size_max)
+    {
+        vgg_platform_cache_evict(cache, cache->size_max / 4 * 3, key);
+    }
+
+    return 1;
+}
+
+/* Removes all fragments */
+VGG_PLATFORM_API VGG_PLATFORM_INLINE void vgg_platform_cache_clear(vgg_platform_cache *cache)
+{
+    char path[VGG_PLATFORM_CACHE_DIRECTORY_SIZE + 32];
+    struct dirent *entry;
+    DIR *dir;
+
+    cache->size = 0;
+
+    if (!(dir = opendir(cache->directory)))
+    {
+        return;
+    }
+
+    while ((entry = readdir(dir)) != 0)
+    {
+        if (vgg_platform_cache_is_fragment(entry->d_name) && vgg_platform_cache_path(cache, entry->d_name, path, (int)sizeof(path)))
+        {
+            unlink(path);
+        }
+    }
+    closedir(dir);
+}
+
+#else
+#error "vgg_platform_cache: unsupported operating system. please provide your own cache implementation"
+#endif
+
+/* Document level caching (include "vgg.h" first) */
+#ifdef VGG_H
+
+/* Writes the elements of doc to w from the cache if the same elements were rendered before,
+   also by an earlier process. On a miss they are rendered into the fixed size writer scratch
+   and stored. Returns 1 on a hit. Writers with style interning bypass the cache, their
+   classes depend on the writer state.
+*/
+VGG_PLATFORM_API VGG_PLATFORM_INLINE int vgg_platform_cache_document(vgg_platform_cache *cache, vgg_document *doc, vgg_svg_writer *w, vgg_svg_writer *scratch)
+{
+    char key[VGG_PLATFORM_CACHE_KEY_SIZE + 1];
+    vgg_platform_cache_fragment fragment;
+    vgg_hash hash;
+
+    if (w->style)
+    {
+        vgg_document_write(doc, w);
+        return 0;
+    }
+
+    vgg_hash_init(&hash);
+    vgg_hash_document(&hash, doc, w);
+    vgg_hash_hex(&hash, key);
+    key[VGG_PLATFORM_CACHE_KEY_SIZE] = '\0';
+
+    if (vgg_platform_cache_get(cache, key, &fragment))
+    {
+        vgg_svg_putn(w, (char *)fragment.data, (int)fragment.size);
+        vgg_platform_cache_release(&fragment);
+        return 1;
+    }
+
+    scratch->length = 0;
+    scratch->truncated = 0;
+    scratch->cull = w->cull;
+    scratch->cull_viewport = w->cull_viewport;
+    vgg_document_write(doc, scratch);
+
+    if (scratch->truncated)
+    {
+        /* Too large for scratch, written without caching */
+        vgg_document_write(doc, w);
+        return 0;
+    }
+
+    vgg_platform_cache_put(cache, key, scratch->buffer, (unsigned long)scratch->length);
+    vgg_svg_putn(w, (char *)scratch->buffer, scratch->length);
+    return 0;
+}
+
+#endif
+
+#endif /* VGG_PLATFORM_CACHE_H */
+
+/*
+   ------------------------------------------------------------------------------
+   This software is available under 2 licenses -- choose whichever you prefer.
+   ------------------------------------------------------------------------------
+   ALTERNATIVE A - MIT License
+   Copyright (c) 2025 nickscha
+   Permission is hereby granted, free of charge, to any person obtaining a copy of
+   this software and associated documentation files (the "Software"), to deal in
+   the Software without restriction, including without limitation the rights to
+   use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies
+   of the Software, and to permit persons to whom the Software is furnished to do
+   so, subject to the following conditions:
+   The above copyright notice and this permission notice shall be included in all
+   copies or substantial portions of the Software.
+   THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+   IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+   FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+   AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+   LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+   OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+   SOFTWARE.
+   ------------------------------------------------------------------------------
+   ALTERNATIVE B - Public Domain (www.unlicense.org)
+   This is free and unencumbered software released into the public domain.
+   Anyone is free to copy, modify, publish, use, compile, sell, or distribute this
+   software, either in source code form or as a compiled binary, for any purpose,
+   commercial or non-commercial, and by any means.
+   In jurisdictions that recognize copyright laws, the author or authors of this
+   software dedicate any and all copyright interest in the software to the public
+   domain. We make this dedication for the benefit of the public at large and to
+   the detriment of our heirs and successors. We intend this dedication to be an
+   overt act of relinquishment in perpetuity of all present and future rights to
+   this software under copyright law.
+   THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+   IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+   FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+   AUTHORS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN
+   ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+   WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+   ------------------------------------------------------------------------------
+*/
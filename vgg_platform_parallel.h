@@ -0,0 +1,332 @@
+/* vgg_platform_parallel.h - v0.1 - public domain data structures - nickscha 2025
+
+A C89 standard compliant, single header, nostdlib (no C Standard Library) parallel serializer for vgg.h
+using OS-specific threads. Elements are split into shards, each shard is serialized into its own part of a
+caller provided memory block and the shards are appended to the writer in order, so the output is byte
+identical to calling vgg_svg_element_add for every element.
+
+Supports:
+ - Linux / macOS (POSIX threads)
+ - BSDs (FreeBSD, NetBSD, OpenBSD, Haiku)
+ - Windows and other systems: shards are serialized one after another on the calling thread
+
+LICENSE
+
+  Placed in the public domain and also MIT licensed.
+  See end of file for detailed license information.
+
+*/
+#ifndef VGG_PLATFORM_PARALLEL_H
+#define VGG_PLATFORM_PARALLEL_H
+
+#ifndef VGG_H
+#error "vgg_platform_parallel: include vgg.h first"
+#endif
+
+/* #############################################################################
+ * # COMPILER SETTINGS
+ * #############################################################################
+ */
+/* Check if using C99 or later (inline is supported) */
+#ifndef VGG_PLATFORM_API
+#if __STDC_VERSION__ >= 199901L
+#define VGG_PLATFORM_INLINE inline
+#define VGG_PLATFORM_API extern
+#elif defined(__GNUC__) || defined(__clang__)
+#define VGG_PLATFORM_INLINE __inline__
+#define VGG_PLATFORM_API static
+#elif defined(_MSC_VER)
+#define VGG_PLATFORM_INLINE __inline
+#define VGG_PLATFORM_API static
+#else
+#define VGG_PLATFORM_INLINE
+#define VGG_PLATFORM_API static
+#endif
+#endif
+
+/* Upper bound of threads per call, the shards live on the stack of the calling thread */
+#ifndef VGG_PLATFORM_PARALLEL_THREADS_MAX
+#define VGG_PLATFORM_PARALLEL_THREADS_MAX 64
+#endif
+
+/* Elements [first, first + count) of either an element array or a document */
+typedef struct vgg_platform_parallel_shard
+{
+    vgg_header **elements;
+    vgg_document *doc;
+    unsigned int first;
+    unsigned int count;
+    unsigned int done; /* Elements serialized before the shard writer ran out of room */
+
+    vgg_svg_writer w;
+
+} vgg_platform_parallel_shard;
+
+VGG_PLATFORM_API VGG_PLATFORM_INLINE void vgg_platform_parallel_serialize(vgg_platform_parallel_shard *shard)
+{
+    vgg_element element;
+    vgg_header *header;
+    unsigned int i;
+
+    shard->w.length = 0;
+    shard->w.truncated = 0;
+    shard->w.culled = 0;
+
+    for (i = 0; i < shard->count; ++i)
+    {
+        int length = shard->w.length;
+
+        if (shard->doc)
+        {
+            vgg_document_element(shard->doc, shard->first + i, &element);
+            header = &element.header;
+        }
+        else
+        {
+            header = shard->elements[shard->first + i];
+        }
+
+        vgg_svg_element_add(&shard->w, header);
+
+        /* The rest of the shard is written serially when it is appended */
+        if (shard->w.truncated)
+        {
+            shard->w.length = length;
+            break;
+        }
+    }
+
+    shard->done = i;
+}
+
+#if defined(__linux__) || defined(__APPLE__) || defined(__FreeBSD__) || defined(__NetBSD__) || defined(__OpenBSD__) || defined(__HAIKU__)
+
+#include <pthread.h>
+
+VGG_PLATFORM_API VGG_PLATFORM_INLINE void *vgg_platform_parallel_thread(void *user)
+{
+    vgg_platform_parallel_serialize((vgg_platform_parallel_shard *)user);
+    return 0;
+}
+
+/* Shard 0 runs on the calling thread, shards without a thread as well */
+VGG_PLATFORM_API VGG_PLATFORM_INLINE void vgg_platform_parallel_run(vgg_platform_parallel_shard *shards, unsigned int count)
+{
+    pthread_t threads[VGG_PLATFORM_PARALLEL_THREADS_MAX];
+    int started[VGG_PLATFORM_PARALLEL_THREADS_MAX];
+    unsigned int i;
+
+    for (i = 1; i < count; ++i)
+    {
+        started[i] = pthread_create(&threads[i], 0, vgg_platform_parallel_thread, &shards[i]) == 0;
+    }
+
+    vgg_platform_parallel_serialize(&shards[0]);
+
+    for (i = 1; i < count; ++i)
+    {
+        if (started[i])
+        {
+            pthread_join(threads[i], 0);
+        }
+        else
+        {
+            vgg_platform_parallel_serialize(&shards[i]);
+        }
+    }
+}
+
+#else
+
+VGG_PLATFORM_API VGG_PLATFORM_INLINE void vgg_platform_parallel_run(vgg_platform_parallel_shard *shards, unsigned int count)
+{
+    unsigned int i;
+
+    for (i = 0; i < count; ++i)
+    {
+        vgg_platform_parallel_serialize(&shards[i]);
+    }
+}
+
+#endif
+
+/* Shared by vgg_platform_parallel_elements_add and vgg_platform_parallel_document_write */
+VGG_PLATFORM_API VGG_PLATFORM_INLINE void vgg_platform_parallel_write(
+    vgg_svg_writer *w,
+    vgg_header **elements,
+    vgg_document *doc,
+    unsigned int count,
+    unsigned int threads,
+    unsigned char *memory,
+    unsigned long memory_size)
+{
+    vgg_platform_parallel_shard shards[VGG_PLATFORM_PARALLEL_THREADS_MAX];
+    vgg_element element;
+    unsigned long shard_capacity, bytes = 0, elements_done = 0, element_size;
+    unsigned int next = 0, i, j;
+
+    threads = (threads < VGG_PLATFORM_PARALLEL_THREADS_MAX) ? threads : VGG_PLATFORM_PARALLEL_THREADS_MAX;
+    shard_capacity = threads ? memory_size / threads : 0;
+    shard_capacity = (shard_capacity < 0x40000000UL) ? shard_capacity : 0x40000000UL;
+
+    /* Interned classes depend on the order colors are first seen */
+    if (threads < 2 || w->style || shard_capacity < 256)
+    {
+        for (i = 0; i < count; ++i)
+        {
+            if (doc)
+            {
+                vgg_document_element(doc, i, &element);
+                vgg_svg_element_add(w, &element.header);
+            }
+            else
+            {
+                vgg_svg_element_add(w, elements[i]);
+            }
+        }
+        return;
+    }
+
+    for (i = 0; i < threads; ++i)
+    {
+        shards[i].elements = elements;
+        shards[i].doc = doc;
+        shards[i].w = vgg_svg_writer_create(memory + (unsigned long)i * shard_capacity, (int)shard_capacity);
+        shards[i].w.cull = w->cull;
+        shards[i].w.cull_viewport = w->cull_viewport;
+    }
+
+    while (next < count)
+    {
+        unsigned int shard_elements, shard_count = 0;
+
+        /* Worst case size of the first element until the average of written ones is known */
+        if (elements_done)
+        {
+            element_size = bytes / elements_done + 1;
+            element_size += element_size / 8;
+        }
+        else if (doc)
+        {
+            vgg_document_element(doc, next, &element);
+            element_size = (unsigned long)vgg_svg_element_size_max(&element.header);
+        }
+        else
+        {
+            element_size = (unsigned long)vgg_svg_element_size_max(elements[next]);
+        }
+
+        shard_elements = (unsigned int)(shard_capacity / element_size);
+        shard_elements = shard_elements ? shard_elements : 1;
+
+        /* Small remainders are spread over all threads */
+        if ((count - next) / threads < shard_elements)
+        {
+            shard_elements = (count - next) / threads + 1;
+        }
+
+        for (i = 0; i < threads && next < count; ++i)
+        {
+            shards[i].first = next;
+            shards[i].count = (count - next < shard_elements) ? count - next : shard_elements;
+            next += shards[i].count;
+            shard_count++;
+        }
+
+        vgg_platform_parallel_run(shards, shard_count);
+
+        /* Appended in order */
+        for (i = 0; i < shard_count; ++i)
+        {
+            vgg_platform_parallel_shard *shard = &shards[i];
+
+            vgg_svg_putn(w, (char *)shard->w.buffer, shard->w.length);
+            w->culled += shard->w.culled;
+            bytes += (unsigned long)shard->w.length;
+            elements_done += shard->done;
+
+            for (j = shard->done; j < shard->count; ++j)
+            {
+                if (doc)
+                {
+                    vgg_document_element(doc, shard->first + j, &element);
+                    vgg_svg_element_add(w, &element.header);
+                }
+                else
+                {
+                    vgg_svg_element_add(w, elements[shard->first + j]);
+                }
+            }
+        }
+    }
+}
+
+/* Same output as calling vgg_svg_element_add for elements [0, count) in order. memory is split into one
+   shard buffer per thread, the elements are written in rounds of what fits. Falls back to serial
+   writing for a single thread, less than 256 bytes per thread or writers with style interning.
+*/
+VGG_PLATFORM_API VGG_PLATFORM_INLINE void vgg_platform_parallel_elements_add(
+    vgg_svg_writer *w,
+    vgg_header **elements,
+    unsigned int count,
+    unsigned int threads,
+    unsigned char *memory,
+    unsigned long memory_size)
+{
+    vgg_platform_parallel_write(w, elements, 0, count, threads, memory, memory_size);
+}
+
+/* Same output as vgg_document_write */
+VGG_PLATFORM_API VGG_PLATFORM_INLINE void vgg_platform_parallel_document_write(
+    vgg_svg_writer *w,
+    vgg_document *doc,
+    unsigned int threads,
+    unsigned char *memory,
+    unsigned long memory_size)
+{
+    vgg_platform_parallel_write(w, 0, doc, doc->count, threads, memory, memory_size);
+}
+
+#endif /* VGG_PLATFORM_PARALLEL_H */
+
+/*
+   ------------------------------------------------------------------------------
+   This software is available under 2 licenses -- choose whichever you prefer.
+   ------------------------------------------------------------------------------
+   ALTERNATIVE A - MIT License
+   Copyright (c) 2025 nickscha
+   Permission is hereby granted, free of charge, to any person obtaining a copy of
+   this software and associated documentation files (the "Software"), to deal in
+   the Software without restriction, including without limitation the rights to
+   use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies
+   of the Software, and to permit persons to whom the Software is furnished to do
+   so, subject to the following conditions:
+   The above copyright notice and this permission notice shall be included in all
+   copies or substantial portions of the Software.
+   THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+   IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+   FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+   AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+   LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+   OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+   SOFTWARE.
+   ------------------------------------------------------------------------------
+   ALTERNATIVE B - Public Domain (www.unlicense.org)
+   This is free and unencumbered software released into the public domain.
+   Anyone is free to copy, modify, publish, use, compile, sell, or distribute this
+   software, either in source code form or as a compiled binary, for any purpose,
+   commercial or non-commercial, and by any means.
+   In jurisdictions that recognize copyright laws, the author or authors of this
+   software dedicate any and all copyright interest in the software to the public
+   domain. We make this dedication for the benefit of the public at large and to
+   the detriment of our heirs and successors. We intend this dedication to be an
+   overt act of relinquishment in perpetuity of all present and future rights to
+   this software under copyright law.
+   THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+   IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+   FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+   AUTHORS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN
+   ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+   WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+   ------------------------------------------------------------------------------
+*/
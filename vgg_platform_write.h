@@ -35,9 +35,19 @@ LICENSE
 #define VGG_PLATFORM_API static
 #endif
 
+/* A piece of output for gathered writes, e.g. part of a writer buffer or a cached fragment */
+typedef struct vgg_platform_span
+{
+    unsigned char *data;
+    unsigned long size;
+
+} vgg_platform_span;
+
 #ifdef _WIN32
 #define VGG_WIN32_GENERIC_WRITE (0x40000000L)
+#define VGG_WIN32_CREATE_NEW 1
 #define VGG_WIN32_CREATE_ALWAYS 2
+#define VGG_WIN32_ERROR_FILE_EXISTS 80
 #define VGG_WIN32_FILE_ATTRIBUTE_NORMAL 0x00000080
 
 #ifndef _WINDOWS_
@@ -64,6 +74,21 @@ WriteFile(
     unsigned long *lpNumberOfBytesWritten,
     void *lpOverlapped);
 
+VGG_WIN32_API(int)
+FlushFileBuffers(void *hFile);
+
+VGG_WIN32_API(int)
+MoveFileExA(const char *lpExistingFileName, const char *lpNewFileName, unsigned long dwFlags);
+
+VGG_WIN32_API(int)
+DeleteFileA(const char *lpFileName);
+
+VGG_WIN32_API(unsigned long)
+GetCurrentProcessId(void);
+
+VGG_WIN32_API(unsigned long)
+GetLastError(void);
+
 #endif /* _WINDOWS_   */
 
 VGG_PLATFORM_API VGG_PLATFORM_INLINE int vgg_platform_write(char *filename, unsigned char *buffer, unsigned long size)
@@ -79,34 +104,693 @@ VGG_PLATFORM_API VGG_PLATFORM_INLINE int vgg_platform_write(char *filename, unsi
     return (success && (bytes_written == size));
 }
 
+/* File handle for streaming writes */
+typedef struct vgg_platform_stream
+{
+    void *handle;
+
+} vgg_platform_stream;
+
+VGG_PLATFORM_API VGG_PLATFORM_INLINE int vgg_platform_stream_open(vgg_platform_stream *stream, char *filename)
+{
+    stream->handle = CreateFileA(filename, VGG_WIN32_GENERIC_WRITE, 0, 0, VGG_WIN32_CREATE_ALWAYS, VGG_WIN32_FILE_ATTRIBUTE_NORMAL, 0);
+    return (stream->handle != (void *)-1);
+}
+
+VGG_PLATFORM_API VGG_PLATFORM_INLINE int vgg_platform_stream_write(vgg_platform_stream *stream, unsigned char *buffer, unsigned long size)
+{
+    unsigned long bytes_written;
+
+    while (size > 0)
+    {
+        if (!WriteFile(stream->handle, buffer, size, &bytes_written, 0) || bytes_written == 0)
+        {
+            return 0;
+        }
+        buffer += bytes_written;
+        size -= bytes_written;
+    }
+
+    return 1;
+}
+
+/* Writes the spans in order, one WriteFile per span */
+VGG_PLATFORM_API VGG_PLATFORM_INLINE int vgg_platform_stream_writev(vgg_platform_stream *stream, vgg_platform_span *spans, unsigned long count)
+{
+    unsigned long i;
+
+    for (i = 0; i < count; ++i)
+    {
+        if (!vgg_platform_stream_write(stream, spans[i].data, spans[i].size))
+        {
+            return 0;
+        }
+    }
+
+    return 1;
+}
+
+VGG_PLATFORM_API VGG_PLATFORM_INLINE int vgg_platform_stream_close(vgg_platform_stream *stream)
+{
+    return CloseHandle(stream->handle);
+}
+
 #elif defined(__linux__) || defined(__APPLE__) || defined(__FreeBSD__) || defined(__NetBSD__) || defined(__OpenBSD__) || defined(__HAIKU__)
 
+/* ftruncate is POSIX, hidden by strict ISO C builds on Linux. Requested like vgg.h does if this header comes first. */
+#if defined(__linux__) && defined(__STRICT_ANSI__) && !defined(_POSIX_C_SOURCE) && !defined(_XOPEN_SOURCE) && !defined(_GNU_SOURCE) && !defined(_DEFAULT_SOURCE)
+#define _POSIX_C_SOURCE 200112L
+#endif
+
 #include <fcntl.h>
 #include <unistd.h>
+#include <errno.h>
+#include <limits.h>
 #include <sys/types.h>
 #include <sys/stat.h>
+#include <sys/uio.h>
+#include <sys/mman.h>
+#include <stdio.h> /* rename */
 
-VGG_PLATFORM_API VGG_PLATFORM_INLINE int vgg_platform_write(char *filename, unsigned char *buffer, unsigned long size)
+/* posix_fallocate is POSIX.1-2001, only used if the feature level of the build declares it */
+#if defined(__linux__) && ((defined(_POSIX_C_SOURCE) && _POSIX_C_SOURCE >= 200112L) || (defined(_XOPEN_SOURCE) && _XOPEN_SOURCE >= 600))
+#define VGG_PLATFORM_FALLOCATE
+#endif
+
+/* Spans per writev call */
+#ifdef IOV_MAX
+#define VGG_PLATFORM_IOV_MAX IOV_MAX
+#else
+#define VGG_PLATFORM_IOV_MAX 1024
+#endif
+
+/* File handle for streaming writes */
+typedef struct vgg_platform_stream
 {
     int fd;
+
+} vgg_platform_stream;
+
+VGG_PLATFORM_API VGG_PLATFORM_INLINE int vgg_platform_stream_open(vgg_platform_stream *stream, char *filename)
+{
+    stream->fd = open(filename, O_WRONLY | O_CREAT | O_TRUNC, 0644);
+    return (stream->fd >= 0);
+}
+
+VGG_PLATFORM_API VGG_PLATFORM_INLINE int vgg_platform_stream_write(vgg_platform_stream *stream, unsigned char *buffer, unsigned long size)
+{
     ssize_t written;
 
-    fd = open(filename, O_WRONLY | O_CREAT | O_TRUNC, 0644);
-    if (fd < 0)
+    /* write may return less than requested or be interrupted by a signal */
+    while (size > 0)
     {
-        return 0;
+        written = write(stream->fd, buffer, size);
+        if (written < 0 && errno == EINTR)
+        {
+            continue;
+        }
+        if (written <= 0)
+        {
+            return 0;
+        }
+        buffer += written;
+        size -= (unsigned long)written;
     }
 
-    written = write(fd, buffer, size);
-    close(fd);
+    return 1;
+}
+
+/* Writes the spans in order with as few writev calls as possible, no bytes are copied.
+   Short writes continue inside the span they stopped in.
+*/
+VGG_PLATFORM_API VGG_PLATFORM_INLINE int vgg_platform_stream_writev(vgg_platform_stream *stream, vgg_platform_span *spans, unsigned long count)
+{
+    struct iovec vectors[VGG_PLATFORM_IOV_MAX < 1024 ? VGG_PLATFORM_IOV_MAX : 1024];
+    unsigned long next = 0, offset = 0;
+
+    while (next < count)
+    {
+        unsigned long n = 0, i;
+        ssize_t written;
+
+        /* The first span may be partly written already */
+        for (i = next; i < count && n < (unsigned long)(sizeof(vectors) / sizeof(vectors[0])); ++i)
+        {
+            unsigned long skip = (i == next) ? offset : 0;
+
+            if (spans[i].size > skip)
+            {
+                vectors[n].iov_base = (void *)(spans[i].data + skip);
+                vectors[n].iov_len = (size_t)(spans[i].size - skip);
+                n++;
+            }
+        }
+
+        if (n == 0)
+        {
+            return 1;
+        }
+
+        written = writev(stream->fd, vectors, (int)n);
+        if (written < 0 && errno == EINTR)
+        {
+            continue;
+        }
+        if (written <= 0)
+        {
+            return 0;
+        }
+
+        /* Advance over the written bytes, empty spans included */
+        offset += (unsigned long)written;
+        while (next < count && offset >= spans[next].size)
+        {
+            offset -= spans[next].size;
+            next++;
+        }
+    }
+
+    return 1;
+}
+
+VGG_PLATFORM_API VGG_PLATFORM_INLINE int vgg_platform_stream_close(vgg_platform_stream *stream)
+{
+    return (close(stream->fd) == 0);
+}
+
+VGG_PLATFORM_API VGG_PLATFORM_INLINE int vgg_platform_write(char *filename, unsigned char *buffer, unsigned long size)
+{
+    vgg_platform_stream stream;
+    int success;
+
+    if (!vgg_platform_stream_open(&stream, filename))
+    {
+        return 0;
+    }
 
-    return (written == (ssize_t)size);
+    success = vgg_platform_stream_write(&stream, buffer, size);
+    return vgg_platform_stream_close(&stream) && success;
 }
 
 #else
 #error "vgg_platform_write: unsupported operating system. please provide your own write binary file implementation"
 #endif
 
+/* #############################################################################
+ * # ATOMIC FILE OUTPUT
+ * #############################################################################
+ * Output goes to a temporary file next to the target which replaces the target
+ * on commit, readers see either the old or the complete new file.
+ */
+#ifndef VGG_PLATFORM_PATH_SIZE
+#define VGG_PLATFORM_PATH_SIZE 512
+#endif
+
+#define VGG_PLATFORM_SYNC_NONE 0      /* Crash may leave an empty or partial target */
+#define VGG_PLATFORM_SYNC_FILE 1      /* Data is on disk before the rename */
+#define VGG_PLATFORM_SYNC_DIRECTORY 2 /* The rename is on disk as well */
+
+typedef struct vgg_platform_atomic
+{
+    vgg_platform_stream stream; /* Temporary file */
+    int sync;                   /* VGG_PLATFORM_SYNC_* */
+
+    unsigned long size;      /* Bytes written */
+    unsigned long file_size; /* Length of the temporary file including preallocation */
+
+    unsigned char *map;       /* Mapped window of vgg_platform_atomic_map, 0 otherwise */
+    unsigned long map_offset; /* Page aligned file offset of the window */
+    unsigned long map_size;
+
+    char path[VGG_PLATFORM_PATH_SIZE];
+    char path_temporary[VGG_PLATFORM_PATH_SIZE + 48];
+
+} vgg_platform_atomic;
+
+/* Temporary files are created exclusively, a name taken by another thread is retried with the next count */
+#define VGG_PLATFORM_ATOMIC_ATTEMPTS 16
+
+/* Count of temporary files opened by this process, not synchronized (collisions are retried) */
+VGG_PLATFORM_API VGG_PLATFORM_INLINE unsigned long vgg_platform_atomic_count(void)
+{
+    static unsigned long count;
+    return count++;
+}
+
+/* Target path and <target>.<id>.<count>.tmp in the same directory (rename does not cross file systems) */
+VGG_PLATFORM_API VGG_PLATFORM_INLINE int vgg_platform_atomic_paths(vgg_platform_atomic *atomic, char *filename, unsigned long id, unsigned long count)
+{
+    unsigned long values[2];
+    char digits[24];
+    int length, i, n, v;
+
+    for (length = 0; filename[length]; ++length)
+    {
+        if (length >= VGG_PLATFORM_PATH_SIZE - 1)
+        {
+            return 0;
+        }
+        atomic->path[length] = filename[length];
+        atomic->path_temporary[length] = filename[length];
+    }
+    atomic->path[length] = '\0';
+
+    values[0] = id;
+    values[1] = count;
+    for (v = 0; v < 2; ++v)
+    {
+        n = 0;
+        do
+        {
+            digits[n++] = (char)('0' + values[v] % 10);
+            values[v] /= 10;
+        } while (values[v]);
+
+        atomic->path_temporary[length++] = '.';
+        while (n > 0)
+        {
+            atomic->path_temporary[length++] = digits[--n];
+        }
+    }
+    for (i = 0; i < 4; ++i)
+    {
+        atomic->path_temporary[length++] = ".tmp"[i];
+    }
+    atomic->path_temporary[length] = '\0';
+
+    atomic->size = 0;
+    atomic->file_size = 0;
+    atomic->map = 0;
+    atomic->map_offset = 0;
+    atomic->map_size = 0;
+    return 1;
+}
+
+#ifdef _WIN32
+
+/* Opens <filename>.<process id>.<count>.tmp, size_hint is not used on Win32 */
+VGG_PLATFORM_API VGG_PLATFORM_INLINE int vgg_platform_atomic_open(vgg_platform_atomic *atomic, char *filename, unsigned long size_hint, int sync)
+{
+    int attempt;
+
+    (void)size_hint;
+    atomic->sync = sync;
+
+    for (attempt = 1;; ++attempt)
+    {
+        if (!vgg_platform_atomic_paths(atomic, filename, GetCurrentProcessId(), vgg_platform_atomic_count()))
+        {
+            return 0;
+        }
+        atomic->stream.handle = CreateFileA(atomic->path_temporary, VGG_WIN32_GENERIC_WRITE, 0, 0, VGG_WIN32_CREATE_NEW, VGG_WIN32_FILE_ATTRIBUTE_NORMAL, 0);
+        if (atomic->stream.handle != (void *)-1)
+        {
+            return 1;
+        }
+        if (GetLastError() != VGG_WIN32_ERROR_FILE_EXISTS || attempt == VGG_PLATFORM_ATOMIC_ATTEMPTS)
+        {
+            return 0;
+        }
+    }
+}
+
+VGG_PLATFORM_API VGG_PLATFORM_INLINE int vgg_platform_atomic_write(vgg_platform_atomic *atomic, unsigned char *buffer, unsigned long size)
+{
+    atomic->size += size;
+    return vgg_platform_stream_write(&atomic->stream, buffer, size);
+}
+
+/* Replaces the target with the temporary file */
+VGG_PLATFORM_API VGG_PLATFORM_INLINE int vgg_platform_atomic_commit(vgg_platform_atomic *atomic)
+{
+    int success = 1;
+
+    if (atomic->sync != VGG_PLATFORM_SYNC_NONE)
+    {
+        success = FlushFileBuffers(atomic->stream.handle);
+    }
+    success = CloseHandle(atomic->stream.handle) && success;
+
+    /* MOVEFILE_REPLACE_EXISTING | MOVEFILE_WRITE_THROUGH */
+    return success && MoveFileExA(atomic->path_temporary, atomic->path, 0x1 | 0x8);
+}
+
+/* Removes the temporary file, the target stays as it was */
+VGG_PLATFORM_API VGG_PLATFORM_INLINE void vgg_platform_atomic_abort(vgg_platform_atomic *atomic)
+{
+    CloseHandle(atomic->stream.handle);
+    DeleteFileA(atomic->path_temporary);
+}
+
+#else
+
+/* Grows the temporary file to size, allocating the blocks for the preallocation hint */
+VGG_PLATFORM_API VGG_PLATFORM_INLINE int vgg_platform_atomic_reserve(vgg_platform_atomic *atomic, unsigned long size, int allocate)
+{
+    if (size <= atomic->file_size)
+    {
+        return 1;
+    }
+
+#ifdef VGG_PLATFORM_FALLOCATE
+    if (allocate && posix_fallocate(atomic->stream.fd, 0, (off_t)size) == 0)
+    {
+        atomic->file_size = size;
+        return 1;
+    }
+#else
+    (void)allocate;
+#endif
+
+    if (ftruncate(atomic->stream.fd, (off_t)size) != 0)
+    {
+        return 0;
+    }
+    atomic->file_size = size;
+    return 1;
+}
+
+/* Opens <filename>.<pid>.<count>.tmp. size_hint > 0 preallocates the expected size (fallocate on Linux),
+   sync is one of VGG_PLATFORM_SYNC_*. An existing target passes its permissions on to the replacement.
+*/
+VGG_PLATFORM_API VGG_PLATFORM_INLINE int vgg_platform_atomic_open(vgg_platform_atomic *atomic, char *filename, unsigned long size_hint, int sync)
+{
+    struct stat info;
+    int attempt;
+
+    atomic->sync = sync;
+
+    for (attempt = 1;; ++attempt)
+    {
+        if (!vgg_platform_atomic_paths(atomic, filename, (unsigned long)getpid(), vgg_platform_atomic_count()))
+        {
+            return 0;
+        }
+        atomic->stream.fd = open(atomic->path_temporary, O_RDWR | O_CREAT | O_EXCL, 0644);
+        if (atomic->stream.fd >= 0)
+        {
+            break;
+        }
+        if (errno != EEXIST || attempt == VGG_PLATFORM_ATOMIC_ATTEMPTS)
+        {
+            return 0;
+        }
+    }
+
+    if (stat(atomic->path, &info) == 0)
+    {
+        fchmod(atomic->stream.fd, info.st_mode & 07777);
+    }
+
+    /* Only a hint, output larger than it still works */
+    if (size_hint)
+    {
+        vgg_platform_atomic_reserve(atomic, size_hint, 1);
+    }
+
+    return 1;
+}
+
+/* Appends size bytes (write mode, not for a mapped writer) */
+VGG_PLATFORM_API VGG_PLATFORM_INLINE int vgg_platform_atomic_write(vgg_platform_atomic *atomic, unsigned char *buffer, unsigned long size)
+{
+    if (atomic->map)
+    {
+        return 0;
+    }
+
+    atomic->size += size;
+    return vgg_platform_stream_write(&atomic->stream, buffer, size);
+}
+
+VGG_PLATFORM_API VGG_PLATFORM_INLINE void vgg_platform_atomic_unmap(vgg_platform_atomic *atomic)
+{
+    if (atomic->map)
+    {
+        if (atomic->sync != VGG_PLATFORM_SYNC_NONE)
+        {
+            msync(atomic->map, (size_t)atomic->map_size, MS_SYNC);
+        }
+        munmap(atomic->map, (size_t)atomic->map_size);
+        atomic->map = 0;
+    }
+}
+
+/* Maps the window that starts at the page of atomic->size */
+VGG_PLATFORM_API VGG_PLATFORM_INLINE int vgg_platform_atomic_map_window(vgg_platform_atomic *atomic)
+{
+    unsigned long page = (unsigned long)sysconf(_SC_PAGESIZE);
+    void *map;
+
+    vgg_platform_atomic_unmap(atomic);
+
+    atomic->map_offset = atomic->size - atomic->size % page;
+    if (!vgg_platform_atomic_reserve(atomic, atomic->map_offset + atomic->map_size, 0))
+    {
+        return 0;
+    }
+
+    map = mmap(0, (size_t)atomic->map_size, PROT_READ | PROT_WRITE, MAP_SHARED, atomic->stream.fd, (off_t)atomic->map_offset);
+    if (map == MAP_FAILED)
+    {
+        return 0;
+    }
+
+    atomic->map = (unsigned char *)map;
+    return 1;
+}
+
+/* Replaces the target with the temporary file, cut to the written size */
+VGG_PLATFORM_API VGG_PLATFORM_INLINE int vgg_platform_atomic_commit(vgg_platform_atomic *atomic)
+{
+    int success = 1;
+
+    vgg_platform_atomic_unmap(atomic);
+
+    if (atomic->file_size != atomic->size)
+    {
+        success = ftruncate(atomic->stream.fd, (off_t)atomic->size) == 0;
+    }
+
+    if (success && atomic->sync != VGG_PLATFORM_SYNC_NONE)
+    {
+        success = fsync(atomic->stream.fd) == 0;
+    }
+
+    success = vgg_platform_stream_close(&atomic->stream) && success;
+
+    if (!success || rename(atomic->path_temporary, atomic->path) != 0)
+    {
+        unlink(atomic->path_temporary);
+        return 0;
+    }
+
+    /* The directory entry of the rename */
+    if (atomic->sync == VGG_PLATFORM_SYNC_DIRECTORY)
+    {
+        char directory[VGG_PLATFORM_PATH_SIZE];
+        int i, slash = -1, fd;
+
+        for (i = 0; atomic->path[i]; ++i)
+        {
+            directory[i] = atomic->path[i];
+            slash = (atomic->path[i] == '/') ? i : slash;
+        }
+        if (slash < 0)
+        {
+            directory[0] = '.';
+            directory[1] = '\0';
+        }
+        else
+        {
+            directory[(slash > 0) ? slash : 1] = '\0';
+        }
+
+        fd = open(directory, O_RDONLY);
+        if (fd < 0 || fsync(fd) != 0)
+        {
+            success = 0;
+        }
+        if (fd >= 0)
+        {
+            close(fd);
+        }
+    }
+
+    return success;
+}
+
+/* Removes the temporary file, the target stays as it was */
+VGG_PLATFORM_API VGG_PLATFORM_INLINE void vgg_platform_atomic_abort(vgg_platform_atomic *atomic)
+{
+    vgg_platform_atomic_unmap(atomic);
+    vgg_platform_stream_close(&atomic->stream);
+    unlink(atomic->path_temporary);
+}
+
+#endif
+
+/* Whole buffer through a temporary file, see vgg_platform_atomic_open */
+VGG_PLATFORM_API VGG_PLATFORM_INLINE int vgg_platform_write_atomic(char *filename, unsigned char *buffer, unsigned long size, int sync)
+{
+    vgg_platform_atomic atomic;
+
+    if (!vgg_platform_atomic_open(&atomic, filename, size, sync))
+    {
+        return 0;
+    }
+
+    if (!vgg_platform_atomic_write(&atomic, buffer, size))
+    {
+        vgg_platform_atomic_abort(&atomic);
+        return 0;
+    }
+
+    return vgg_platform_atomic_commit(&atomic);
+}
+
+/* Streaming sink for vgg_svg_writer_create_stream (include "vgg.h" first).
+   sink_user has to point to an opened vgg_platform_stream.
+*/
+#ifdef VGG_H
+VGG_PLATFORM_API VGG_PLATFORM_INLINE int vgg_platform_stream_sink(vgg_svg_writer *w)
+{
+    int success = vgg_platform_stream_write((vgg_platform_stream *)w->sink_user, w->buffer, (unsigned long)w->length);
+    w->length = 0;
+    return success;
+}
+
+/* Sink for vgg_svg_writer_create_stream writing into an opened vgg_platform_atomic (sink_user) */
+VGG_PLATFORM_API VGG_PLATFORM_INLINE int vgg_platform_atomic_sink(vgg_svg_writer *w)
+{
+    vgg_platform_atomic *atomic = (vgg_platform_atomic *)w->sink_user;
+    int success;
+
+#ifndef _WIN32
+    /* Mapped: the bytes are already in the file, continue in the next window */
+    if (atomic->map)
+    {
+        atomic->size += (unsigned long)w->length;
+        w->length = 0;
+
+        if (!vgg_platform_atomic_map_window(atomic))
+        {
+            return 0;
+        }
+        w->buffer = atomic->map + (atomic->size - atomic->map_offset);
+        w->capacity = (int)(atomic->map_size - (atomic->size - atomic->map_offset));
+        return 1;
+    }
+#endif
+
+    success = vgg_platform_atomic_write(atomic, w->buffer, (unsigned long)w->length);
+    w->length = 0;
+    return success;
+}
+
+/* Writer that formats straight into a memory mapped window of the temporary file (no user space copy).
+   window_size is rounded to pages. Flush the writer (vgg_svg_end) before vgg_platform_atomic_commit.
+   Returns 0 if mapping is not supported, use a chunk buffer with vgg_platform_atomic_sink instead.
+*/
+VGG_PLATFORM_API VGG_PLATFORM_INLINE int vgg_platform_atomic_map(vgg_platform_atomic *atomic, vgg_svg_writer *w, unsigned long window_size)
+{
+#ifndef _WIN32
+    unsigned long page = (unsigned long)sysconf(_SC_PAGESIZE);
+
+    window_size = (window_size < 0x40000000UL) ? window_size : 0x40000000UL;
+    atomic->map_size = (window_size + page - 1) / page * page;
+    atomic->map_size = atomic->map_size ? atomic->map_size : page;
+
+    if (!vgg_platform_atomic_map_window(atomic))
+    {
+        return 0;
+    }
+
+    *w = vgg_svg_writer_create_stream(atomic->map + (atomic->size - atomic->map_offset), (int)(atomic->map_size - (atomic->size - atomic->map_offset)), vgg_platform_atomic_sink, atomic);
+    return 1;
+#else
+    (void)atomic;
+    (void)w;
+    (void)window_size;
+    return 0;
+#endif
+}
+
+/* Collects output as spans instead of copying it into one buffer: the bytes written to a
+   fixed size writer and external fragments (cached or shard output) in between them.
+   The writer must not be flushed or reset until vgg_platform_gather_write.
+*/
+typedef struct vgg_platform_gather
+{
+    vgg_platform_span *spans;
+    unsigned long count;
+    unsigned long capacity;
+
+    vgg_svg_writer *w;
+    int mark; /* Writer bytes before it are covered by spans */
+
+} vgg_platform_gather;
+
+VGG_PLATFORM_API VGG_PLATFORM_INLINE void vgg_platform_gather_init(vgg_platform_gather *gather, vgg_platform_span *spans, unsigned long capacity, vgg_svg_writer *w)
+{
+    gather->spans = spans;
+    gather->count = 0;
+    gather->capacity = capacity;
+    gather->w = w;
+    gather->mark = w->length;
+}
+
+VGG_PLATFORM_API VGG_PLATFORM_INLINE int vgg_platform_gather_span(vgg_platform_gather *gather, unsigned char *data, unsigned long size)
+{
+    vgg_platform_span *last = gather->count ? &gather->spans[gather->count - 1] : 0;
+
+    if (size == 0)
+    {
+        return 1;
+    }
+
+    /* Adjacent writer pieces stay one span */
+    if (last && last->data + last->size == data)
+    {
+        last->size += size;
+        return 1;
+    }
+
+    if (gather->count >= gather->capacity)
+    {
+        return 0;
+    }
+
+    gather->spans[gather->count].data = data;
+    gather->spans[gather->count].size = size;
+    gather->count++;
+    return 1;
+}
+
+/* Ends the current writer piece */
+VGG_PLATFORM_API VGG_PLATFORM_INLINE int vgg_platform_gather_writer(vgg_platform_gather *gather)
+{
+    int mark = gather->mark;
+
+    gather->mark = gather->w->length;
+    return vgg_platform_gather_span(gather, gather->w->buffer + mark, (unsigned long)(gather->w->length - mark));
+}
+
+/* Appends size bytes of data after what was written so far, data has to stay valid until written.
+   Returns 0 if the spans are full.
+*/
+VGG_PLATFORM_API VGG_PLATFORM_INLINE int vgg_platform_gather_fragment(vgg_platform_gather *gather, unsigned char *data, unsigned long size)
+{
+    return vgg_platform_gather_writer(gather) && vgg_platform_gather_span(gather, data, size);
+}
+
+/* Writes all spans including the writer bytes after the last fragment */
+VGG_PLATFORM_API VGG_PLATFORM_INLINE int vgg_platform_gather_write(vgg_platform_gather *gather, vgg_platform_stream *stream)
+{
+    return vgg_platform_gather_writer(gather) && vgg_platform_stream_writev(stream, gather->spans, gather->count);
+}
+#endif
+
 #endif /* VGG_PLATFORM_WRITE_H */
 
 /*
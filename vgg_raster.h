@@ -0,0 +1,796 @@
+/* vgg_raster.h - v0.1 - public domain data structures - nickscha 2025
+
+A C89 standard compliant, single header, nostdlib (no C Standard Library) software rasterizer for vgg.h.
+Renders the element types of vgg_svg_element_add into a caller provided RGBA framebuffer with
+anti-aliased coverage, e.g. for thumbnails and previews without a browser.
+
+Rects are filled with exact box coverage. Circles, ellipses, lines and paths are turned into edges
+whose signed area is accumulated per pixel and summed along each row (nonzero fill, overlapping
+subpaths saturate). The spans are blended with SSE2 if available.
+
+Not rendered: text (no font rasterizer), arcs of paths are drawn as straight lines.
+
+LICENSE
+
+  Placed in the public domain and also MIT licensed.
+  See end of file for detailed license information.
+
+*/
+#ifndef VGG_RASTER_H
+#define VGG_RASTER_H
+
+#ifndef VGG_H
+#error "vgg_raster: include vgg.h first"
+#endif
+
+/* Floats of the coverage accumulation buffer for a framebuffer of width x height pixels */
+#define VGG_RASTER_CELLS(width, height) (((unsigned long)(width) + 2UL) * (unsigned long)(height))
+
+#define VGG_RASTER_ELLIPSE_SEGMENTS_MAX 512
+#define VGG_RASTER_CURVE_SEGMENTS_MAX 64
+
+typedef struct vgg_raster
+{
+  unsigned char *pixels; /* width * height RGBA pixels, rows top to bottom */
+  float *cells;          /* VGG_RASTER_CELLS(width, height), all zero between elements */
+  int width;
+  int height;
+
+  double scale_x; /* Document units to pixels */
+  double scale_y;
+
+  double line_width; /* SVG lines without a stroke are invisible, they are drawn this wide (0 skips them) */
+
+  unsigned int skipped; /* Elements that were not rendered (text, unparsable paths) */
+
+  /* Cells touched by the edges of the current element */
+  int cell_x0, cell_y0, cell_x1, cell_y1;
+
+} vgg_raster;
+
+/* Maps a document of document_width x document_height onto the framebuffer and clears cells */
+VGG_API VGG_INLINE void vgg_raster_init(
+    vgg_raster *r,
+    unsigned char *pixels,
+    float *cells,
+    int width,
+    int height,
+    double document_width,
+    double document_height)
+{
+  unsigned long i;
+
+  r->pixels = pixels;
+  r->cells = cells;
+  r->width = width;
+  r->height = height;
+  r->scale_x = (document_width > 0.0) ? (double)width / document_width : 1.0;
+  r->scale_y = (document_height > 0.0) ? (double)height / document_height : 1.0;
+  r->line_width = 1.0;
+  r->skipped = 0;
+  r->cell_x0 = width + 2;
+  r->cell_y0 = height;
+  r->cell_x1 = -1;
+  r->cell_y1 = -1;
+
+  for (i = 0; i < VGG_RASTER_CELLS(width, height); ++i)
+  {
+    cells[i] = 0.0f;
+  }
+}
+
+/* Fills the framebuffer with an opaque color */
+VGG_API VGG_INLINE void vgg_raster_clear(vgg_raster *r, vgg_color color)
+{
+  unsigned long i, count = (unsigned long)r->width * (unsigned long)r->height;
+  unsigned char *p = r->pixels;
+
+  for (i = 0; i < count; ++i, p += 4)
+  {
+    p[0] = (unsigned char)color.r;
+    p[1] = (unsigned char)color.g;
+    p[2] = (unsigned char)color.b;
+    p[3] = 255;
+  }
+}
+
+VGG_API VGG_INLINE double vgg_raster_floor(double v)
+{
+  double f = (double)(long)v;
+  return (f > v) ? f - 1.0 : f;
+}
+
+VGG_API VGG_INLINE double vgg_raster_sqrt(double v)
+{
+  double x = (v > 1.0) ? v : 1.0;
+  int i;
+
+  if (!(v > 0.0))
+  {
+    return 0.0;
+  }
+
+  /* Newton from above decreases monotonically until it converges */
+  for (i = 0; i < 128; ++i)
+  {
+    double next = 0.5 * (x + v / x);
+    if (next >= x)
+    {
+      break;
+    }
+    x = next;
+  }
+  return x;
+}
+
+/* Coverage (0..1) to blend weight (0..256) */
+VGG_API VGG_INLINE int vgg_raster_alpha(float coverage)
+{
+  coverage = (coverage < 0.0f) ? -coverage : coverage;
+  coverage = (coverage > 1.0f) ? 1.0f : coverage;
+  return (int)(coverage * 256.0f + 0.5f);
+}
+
+/* dst = (dst * (256 - alpha) + color * alpha) >> 8 per channel, color alpha is 255 */
+VGG_API VGG_INLINE void vgg_raster_blend(unsigned char *p, unsigned char *color, int alpha)
+{
+  p[0] = (unsigned char)((p[0] * (256 - alpha) + color[0] * alpha) >> 8);
+  p[1] = (unsigned char)((p[1] * (256 - alpha) + color[1] * alpha) >> 8);
+  p[2] = (unsigned char)((p[2] * (256 - alpha) + color[2] * alpha) >> 8);
+  p[3] = (unsigned char)((p[3] * (256 - alpha) + color[3] * alpha) >> 8);
+}
+
+#if defined(VGG_SIMD_AVX) || defined(VGG_SIMD_SSE2)
+/* Two pixels of the 16 bit lanes of dst blended with color by the weights in alpha */
+VGG_API VGG_INLINE __m128i vgg_raster_blend_simd(__m128i dst, __m128i color, __m128i alpha)
+{
+  __m128i inverse = _mm_sub_epi16(_mm_set1_epi16(256), alpha);
+  __m128i sum = _mm_add_epi16(_mm_mullo_epi16(dst, inverse), _mm_mullo_epi16(color, alpha));
+  return _mm_srli_epi16(sum, 8);
+}
+#endif
+
+/* Blends count pixels with the same weight, opaque spans are stored directly */
+VGG_API VGG_INLINE void vgg_raster_span(unsigned char *p, int count, unsigned char *color, int alpha)
+{
+  int i = 0;
+
+  if (alpha <= 0)
+  {
+    return;
+  }
+
+#if defined(VGG_SIMD_AVX) || defined(VGG_SIMD_SSE2)
+  {
+    __m128i zero = _mm_setzero_si128();
+    __m128i color8 = _mm_set_epi8(
+        (char)color[3], (char)color[2], (char)color[1], (char)color[0], (char)color[3], (char)color[2], (char)color[1], (char)color[0],
+        (char)color[3], (char)color[2], (char)color[1], (char)color[0], (char)color[3], (char)color[2], (char)color[1], (char)color[0]);
+
+    if (alpha >= 256)
+    {
+      for (; i + 4 <= count; i += 4)
+      {
+        _mm_storeu_si128((__m128i *)(void *)(p + 4 * i), color8);
+      }
+    }
+    else
+    {
+      __m128i color16 = _mm_unpacklo_epi8(color8, zero);
+      __m128i alpha16 = _mm_set1_epi16((short)alpha);
+
+      for (; i + 4 <= count; i += 4)
+      {
+        __m128i dst = _mm_loadu_si128((__m128i *)(void *)(p + 4 * i));
+        __m128i lo = vgg_raster_blend_simd(_mm_unpacklo_epi8(dst, zero), color16, alpha16);
+        __m128i hi = vgg_raster_blend_simd(_mm_unpackhi_epi8(dst, zero), color16, alpha16);
+        _mm_storeu_si128((__m128i *)(void *)(p + 4 * i), _mm_packus_epi16(lo, hi));
+      }
+    }
+  }
+#endif
+
+  for (; i < count; ++i)
+  {
+    vgg_raster_blend(p + 4 * i, color, alpha);
+  }
+}
+
+/* Area left of t under the edge: integral of max(t - x, 0) over x uniform in [left, right] */
+VGG_API VGG_INLINE double vgg_raster_edge_area(double t, double left, double right)
+{
+  if (t <= left)
+  {
+    return 0.0;
+  }
+  if (t >= right)
+  {
+    return t - 0.5 * (left + right);
+  }
+  return (t - left) * (t - left) / (2.0 * (right - left));
+}
+
+/* Accumulates an edge from x0 to x1 within one row, d is its signed height in the row.
+   Cells receive the difference of the covered share of neighbouring pixels, so the running
+   sum over a row is the coverage.
+*/
+VGG_API VGG_INLINE void vgg_raster_edge_row(float *row, double x0, double x1, double d)
+{
+  double left = (x0 < x1) ? x0 : x1, right = (x0 < x1) ? x1 : x0;
+  double previous = 0.0;
+  int i, first = (int)left, last = (int)right + 1;
+
+  for (i = first; i <= last; ++i)
+  {
+    double covered = d * (vgg_raster_edge_area((double)(i + 1), left, right) - vgg_raster_edge_area((double)i, left, right));
+    row[i] += (float)(covered - previous);
+    previous = covered;
+  }
+}
+
+/* Point at share s in [0, 1] from a to b, without overflow for any finite a and b */
+VGG_API VGG_INLINE double vgg_raster_lerp(double a, double b, double s)
+{
+  return a * (1.0 - s) + b * s;
+}
+
+/* Share of c in [a, b], halved so the differences of finite values do not overflow */
+VGG_API VGG_INLINE double vgg_raster_share(double a, double b, double c)
+{
+  return (0.5 * c - 0.5 * a) / (0.5 * b - 0.5 * a);
+}
+
+/* Adds an edge in pixel space, clipped to the framebuffer rows. Parts left of the framebuffer are
+   moved onto x = 0 and parts right of it onto x = width, so the winding of the pixels stays intact.
+   Edges with infinite or NaN coordinates are dropped, finite ones are exact up to DBL_MAX.
+*/
+VGG_API VGG_INLINE void vgg_raster_edge(vgg_raster *r, double x0, double y0, double x1, double y1)
+{
+  double width = (double)r->width, height = (double)r->height, dir = 1.0, splits[4], t;
+  int count = 0, i;
+
+  if (y0 == y1 || x0 - x0 != 0.0 || y0 - y0 != 0.0 || x1 - x1 != 0.0 || y1 - y1 != 0.0)
+  {
+    return;
+  }
+  if (y0 > y1)
+  {
+    t = x0; x0 = x1; x1 = t;
+    t = y0; y0 = y1; y1 = t;
+    dir = -1.0;
+  }
+  if (y1 <= 0.0 || y0 >= height)
+  {
+    return;
+  }
+
+  /* Pieces between the framebuffer rows and the crossings of x = 0 and x = width */
+  splits[count++] = (y0 > 0.0) ? y0 : 0.0;
+  if (x0 != x1)
+  {
+    double crossings[2];
+    crossings[0] = vgg_raster_lerp(y0, y1, vgg_raster_share(x0, x1, 0.0));
+    crossings[1] = vgg_raster_lerp(y0, y1, vgg_raster_share(x0, x1, width));
+    if (crossings[0] > crossings[1])
+    {
+      t = crossings[0]; crossings[0] = crossings[1]; crossings[1] = t;
+    }
+    for (i = 0; i < 2; ++i)
+    {
+      if (crossings[i] > splits[0] && crossings[i] < y1 && crossings[i] < height)
+      {
+        splits[count++] = crossings[i];
+      }
+    }
+  }
+  splits[count++] = (y1 < height) ? y1 : height;
+
+  for (i = 0; i + 1 < count; ++i)
+  {
+    double top = splits[i], bottom = splits[i + 1], y;
+    double xa = vgg_raster_lerp(x0, x1, vgg_raster_share(y0, y1, top));
+    double xb = vgg_raster_lerp(x0, x1, vgg_raster_share(y0, y1, bottom));
+    int row;
+
+    /* NaN ends up on x = 0 as well, the cells are never indexed with it */
+    xa = (xa > 0.0) ? ((xa < width) ? xa : width) : 0.0;
+    xb = (xb > 0.0) ? ((xb < width) ? xb : width) : 0.0;
+
+    if (!(top < bottom))
+    {
+      continue;
+    }
+    if (r->cell_y0 > (int)top)
+    {
+      r->cell_y0 = (int)top;
+    }
+    if (r->cell_x0 > (int)((xa < xb) ? xa : xb))
+    {
+      r->cell_x0 = (int)((xa < xb) ? xa : xb);
+    }
+    if (r->cell_x1 < (int)((xa < xb) ? xb : xa) + 1)
+    {
+      r->cell_x1 = (int)((xa < xb) ? xb : xa) + 1;
+    }
+
+    for (y = top, row = (int)top; y < bottom; ++row)
+    {
+      double next = ((double)(row + 1) < bottom) ? (double)(row + 1) : bottom;
+      double xs = xa + (y - top) / (bottom - top) * (xb - xa);
+      double xe = xa + (next - top) / (bottom - top) * (xb - xa);
+
+      vgg_raster_edge_row(r->cells + (unsigned long)row * (unsigned long)(r->width + 2), xs, xe, dir * (next - y));
+      y = next;
+    }
+
+    if (r->cell_y1 < row - 1)
+    {
+      r->cell_y1 = row - 1;
+    }
+  }
+}
+
+/* Blends the accumulated coverage of the touched cells with color and clears them */
+VGG_API VGG_INLINE void vgg_raster_fill(vgg_raster *r, vgg_color fill)
+{
+  unsigned char color[4];
+  int x, y, x0 = r->cell_x0, x1 = r->cell_x1;
+
+  color[0] = (unsigned char)fill.r;
+  color[1] = (unsigned char)fill.g;
+  color[2] = (unsigned char)fill.b;
+  color[3] = 255;
+
+  x1 = (x1 > r->width + 1) ? r->width + 1 : x1;
+
+  for (y = r->cell_y0; y <= r->cell_y1; ++y)
+  {
+    float *row = r->cells + (unsigned long)y * (unsigned long)(r->width + 2);
+    unsigned char *p = r->pixels + ((unsigned long)y * (unsigned long)r->width) * 4UL;
+    int end = (x1 < r->width) ? x1 + 1 : r->width;
+    float sum = 0.0f;
+
+    /* Running sum of the signed areas is the coverage, sequential for the same result everywhere */
+    for (x = x0; x <= x1; ++x)
+    {
+      sum += row[x];
+      row[x] = sum;
+    }
+
+    x = x0;
+#if defined(VGG_SIMD_AVX) || defined(VGG_SIMD_SSE2)
+    {
+      __m128i zero = _mm_setzero_si128();
+      __m128 sign = _mm_set1_ps(-0.0f);
+      __m128 one = _mm_set1_ps(1.0f);
+      __m128 scale = _mm_set1_ps(256.0f);
+      __m128 half = _mm_set1_ps(0.5f);
+      __m128i color16 = _mm_set_epi16(color[3], color[2], color[1], color[0], color[3], color[2], color[1], color[0]);
+
+      /* Cells right of x1 are zero, blocks may run past it up to the framebuffer edge */
+      for (; x < end && x + 4 <= r->width; x += 4)
+      {
+        __m128 coverage = _mm_min_ps(_mm_andnot_ps(sign, _mm_loadu_ps(row + x)), one);
+        __m128i alpha = _mm_cvttps_epi32(_mm_add_ps(_mm_mul_ps(coverage, scale), half));
+        __m128i alpha16, dst, lo, hi;
+
+        _mm_storeu_ps(row + x, _mm_setzero_ps());
+        if (_mm_movemask_epi8(_mm_cmpeq_epi32(alpha, zero)) == 0xFFFF)
+        {
+          continue;
+        }
+
+        /* Weights of pixels 0, 1 and 2, 3 repeated over their four channels */
+        alpha16 = _mm_packs_epi32(alpha, alpha);
+        alpha16 = _mm_unpacklo_epi16(alpha16, alpha16);
+
+        dst = _mm_loadu_si128((__m128i *)(void *)(p + 4 * x));
+        lo = vgg_raster_blend_simd(_mm_unpacklo_epi8(dst, zero), color16, _mm_unpacklo_epi32(alpha16, alpha16));
+        hi = vgg_raster_blend_simd(_mm_unpackhi_epi8(dst, zero), color16, _mm_unpackhi_epi32(alpha16, alpha16));
+        _mm_storeu_si128((__m128i *)(void *)(p + 4 * x), _mm_packus_epi16(lo, hi));
+      }
+    }
+#endif
+    for (; x < end; ++x)
+    {
+      int alpha = vgg_raster_alpha(row[x]);
+      row[x] = 0.0f;
+      if (alpha)
+      {
+        vgg_raster_blend(p + 4 * x, color, alpha);
+      }
+    }
+    for (; x <= x1; ++x)
+    {
+      row[x] = 0.0f;
+    }
+  }
+
+  r->cell_x0 = r->width + 2;
+  r->cell_y0 = r->height;
+  r->cell_x1 = -1;
+  r->cell_y1 = -1;
+}
+
+/* Axis aligned box with exact coverage, in document units */
+VGG_API VGG_INLINE void vgg_raster_rect(vgg_raster *r, double x, double y, double width, double height, vgg_color fill)
+{
+  double x0 = x * r->scale_x, y0 = y * r->scale_y;
+  double x1 = (x + width) * r->scale_x, y1 = (y + height) * r->scale_y;
+  unsigned char color[4];
+  int ix0, ix1, iy;
+
+  if (!(width > 0.0) || !(height > 0.0))
+  {
+    return;
+  }
+
+  x0 = (x0 < 0.0) ? 0.0 : x0;
+  y0 = (y0 < 0.0) ? 0.0 : y0;
+  x1 = (x1 > (double)r->width) ? (double)r->width : x1;
+  y1 = (y1 > (double)r->height) ? (double)r->height : y1;
+  if (!(x0 < x1) || !(y0 < y1))
+  {
+    return;
+  }
+
+  color[0] = (unsigned char)fill.r;
+  color[1] = (unsigned char)fill.g;
+  color[2] = (unsigned char)fill.b;
+  color[3] = 255;
+
+  /* A rect narrower than the epsilon stays in its first column */
+  ix0 = (int)x0;
+  ix1 = (int)vgg_raster_floor(x1 - 1e-9);
+  ix1 = (ix1 < ix0) ? ix0 : ix1;
+
+  for (iy = (int)y0; (double)iy < y1; ++iy)
+  {
+    unsigned char *p = r->pixels + ((unsigned long)iy * (unsigned long)r->width) * 4UL;
+    double top = ((double)iy > y0) ? (double)iy : y0;
+    double bottom = ((double)(iy + 1) < y1) ? (double)(iy + 1) : y1;
+    float vertical = (float)(bottom - top);
+
+    if (ix0 == ix1)
+    {
+      vgg_raster_span(p + 4 * ix0, 1, color, vgg_raster_alpha(vertical * (float)(x1 - x0)));
+      continue;
+    }
+
+    vgg_raster_span(p + 4 * ix0, 1, color, vgg_raster_alpha(vertical * (float)((double)(ix0 + 1) - x0)));
+    vgg_raster_span(p + 4 * (ix0 + 1), ix1 - ix0 - 1, color, vgg_raster_alpha(vertical));
+    vgg_raster_span(p + 4 * ix1, 1, color, vgg_raster_alpha(vertical * (float)(x1 - (double)ix1)));
+  }
+}
+
+/* Closed polygon of an ellipse, in document units */
+VGG_API VGG_INLINE void vgg_raster_ellipse(vgg_raster *r, double cx, double cy, double rx, double ry, vgg_color fill)
+{
+  double pcx = cx * r->scale_x, pcy = cy * r->scale_y, prx = rx * r->scale_x, pry = ry * r->scale_y;
+  double radius = (prx > pry) ? prx : pry;
+  double a, a2, c, s, scale, ux = 1.0, uy = 0.0;
+  int segments, i;
+
+  if (!(rx > 0.0) || !(ry > 0.0) || pcx + prx < 0.0 || pcy + pry < 0.0 || pcx - prx > (double)r->width || pcy - pry > (double)r->height)
+  {
+    return;
+  }
+
+  /* Chords stay within about a tenth of a pixel of the curve */
+  segments = (radius < (double)VGG_RASTER_ELLIPSE_SEGMENTS_MAX) ? 8 + (int)radius : VGG_RASTER_ELLIPSE_SEGMENTS_MAX;
+  segments = (segments + 3) & ~3;
+
+  /* cos and sin of the step by their series, the step is at most pi / 4 */
+  a = 6.283185307179586 / (double)segments;
+  a2 = a * a;
+  c = 1.0 - a2 / 2.0 * (1.0 - a2 / 12.0 * (1.0 - a2 / 30.0 * (1.0 - a2 / 56.0 * (1.0 - a2 / 90.0))));
+  s = a * (1.0 - a2 / 6.0 * (1.0 - a2 / 20.0 * (1.0 - a2 / 42.0 * (1.0 - a2 / 72.0 * (1.0 - a2 / 110.0)))));
+
+  /* Polygon with the area of the ellipse, an inscribed one would lose coverage on small shapes */
+  scale = vgg_raster_sqrt(a / s);
+  prx *= scale;
+  pry *= scale;
+
+  for (i = 0; i < segments; ++i)
+  {
+    double nx = (i + 1 == segments) ? 1.0 : ux * c - uy * s;
+    double ny = (i + 1 == segments) ? 0.0 : ux * s + uy * c;
+    vgg_raster_edge(r, pcx + prx * ux, pcy + pry * uy, pcx + prx * nx, pcy + pry * ny);
+    ux = nx;
+    uy = ny;
+  }
+
+  vgg_raster_fill(r, fill);
+}
+
+/* Line drawn as a quad of r->line_width document units, in document units */
+VGG_API VGG_INLINE void vgg_raster_line(vgg_raster *r, double x1, double y1, double x2, double y2, vgg_color fill)
+{
+  double ax = x1 * r->scale_x, ay = y1 * r->scale_y, bx = x2 * r->scale_x, by = y2 * r->scale_y;
+  double dx = 0.5 * bx - 0.5 * ax, dy = 0.5 * by - 0.5 * ay, nx, ny;
+  double length = (dx < 0.0) ? -dx : dx, ady = (dy < 0.0) ? -dy : dy;
+
+  /* Direction scaled to at most 1 first, huge coordinates would overflow when squared */
+  length = (length > ady) ? length : ady;
+  if (!(r->line_width > 0.0) || !(length > 0.0) || length - length != 0.0)
+  {
+    return;
+  }
+  dx /= length;
+  dy /= length;
+  length = vgg_raster_sqrt(dx * dx + dy * dy);
+
+  /* Half width along the normal, at least half a pixel so thin lines stay visible */
+  nx = -dy / length * 0.5 * r->line_width * r->scale_x;
+  ny = dx / length * 0.5 * r->line_width * r->scale_y;
+  if (nx * nx + ny * ny < 0.25)
+  {
+    nx = -dy / length * 0.5;
+    ny = dx / length * 0.5;
+  }
+
+  vgg_raster_edge(r, ax + nx, ay + ny, bx + nx, by + ny);
+  vgg_raster_edge(r, bx + nx, by + ny, bx - nx, by - ny);
+  vgg_raster_edge(r, bx - nx, by - ny, ax - nx, ay - ny);
+  vgg_raster_edge(r, ax - nx, ay - ny, ax + nx, ay + ny);
+  vgg_raster_fill(r, fill);
+}
+
+/* Flattened quadratic (x3, y3 equal to x2, y2) or cubic Bezier from (x0, y0), in pixel space */
+VGG_API VGG_INLINE void vgg_raster_curve(vgg_raster *r, double x0, double y0, double x1, double y1, double x2, double y2, double x3, double y3, int cubic)
+{
+  double length = vgg_raster_sqrt((x1 - x0) * (x1 - x0) + (y1 - y0) * (y1 - y0)) +
+                  vgg_raster_sqrt((x2 - x1) * (x2 - x1) + (y2 - y1) * (y2 - y1)) +
+                  vgg_raster_sqrt((x3 - x2) * (x3 - x2) + (y3 - y2) * (y3 - y2));
+  double px = x0, py = y0;
+  int segments = 2 + (int)(length * 0.25), i;
+
+  segments = (segments > VGG_RASTER_CURVE_SEGMENTS_MAX || length != length) ? VGG_RASTER_CURVE_SEGMENTS_MAX : segments;
+
+  for (i = 1; i <= segments; ++i)
+  {
+    double t = (double)i / (double)segments, u = 1.0 - t, x, y;
+
+    if (cubic)
+    {
+      x = u * u * u * x0 + 3.0 * u * u * t * x1 + 3.0 * u * t * t * x2 + t * t * t * x3;
+      y = u * u * u * y0 + 3.0 * u * u * t * y1 + 3.0 * u * t * t * y2 + t * t * t * y3;
+    }
+    else
+    {
+      x = u * u * x0 + 2.0 * u * t * x1 + t * t * x3;
+      y = u * u * y0 + 2.0 * u * t * y1 + t * t * y3;
+    }
+
+    vgg_raster_edge(r, px, py, x, y);
+    px = x;
+    py = y;
+  }
+}
+
+/* Fills a path string with the nonzero rule, in document units. Returns 0 if it can not be parsed. */
+VGG_API VGG_INLINE int vgg_raster_path(vgg_raster *r, char *d, vgg_color fill)
+{
+  double v[7];
+  double cx = 0.0, cy = 0.0, start_x = 0.0, start_y = 0.0, control_x = 0.0, control_y = 0.0;
+  double sx = r->scale_x, sy = r->scale_y;
+  char command = 0, previous = 0;
+  int parsed = 1;
+
+  for (;;)
+  {
+    double ox, oy, x, y;
+    char upper;
+    int count, i;
+
+    while (*d == ' ' || *d == ',' || *d == '\t' || *d == '\n' || *d == '\r')
+    {
+      d++;
+    }
+
+    if (!*d)
+    {
+      break;
+    }
+
+    if ((*d >= 'A' && *d <= 'Z') || (*d >= 'a' && *d <= 'z'))
+    {
+      command = *d++;
+      if (command == 'Z' || command == 'z')
+      {
+        vgg_raster_edge(r, cx * sx, cy * sy, start_x * sx, start_y * sy);
+        cx = start_x;
+        cy = start_y;
+        previous = 'Z';
+        continue;
+      }
+    }
+
+    upper = (command >= 'a') ? (char)(command - 'a' + 'A') : command;
+    count = (upper == 'M' || upper == 'L' || upper == 'T') ? 2 : (upper == 'H' || upper == 'V') ? 1 : (upper == 'S' || upper == 'Q') ? 4 : (upper == 'C') ? 6 : (upper == 'A') ? 7 : 0;
+
+    for (i = 0; i < count; ++i)
+    {
+      if (!(d = vgg_bounds_parse_number(d, &v[i])))
+      {
+        break;
+      }
+    }
+    if (!count || i < count)
+    {
+      parsed = 0;
+      break;
+    }
+
+    /* Relative coordinates start at the current point */
+    ox = (command >= 'a') ? cx : 0.0;
+    oy = (command >= 'a') ? cy : 0.0;
+    x = (upper == 'H') ? ox + v[0] : (upper == 'V') ? cx : ox + v[count - 2];
+    y = (upper == 'V') ? oy + v[0] : (upper == 'H') ? cy : oy + v[count - 1];
+
+    if (upper == 'M')
+    {
+      /* Subpaths are closed implicitly for filling */
+      vgg_raster_edge(r, cx * sx, cy * sy, start_x * sx, start_y * sy);
+      start_x = x;
+      start_y = y;
+      command = (command == 'm') ? 'l' : 'L';
+    }
+    else if (upper == 'Q' || upper == 'T')
+    {
+      double qx = (upper == 'Q') ? ox + v[0] : (previous == 'Q' || previous == 'T') ? 2.0 * cx - control_x : cx;
+      double qy = (upper == 'Q') ? oy + v[1] : (previous == 'Q' || previous == 'T') ? 2.0 * cy - control_y : cy;
+      vgg_raster_curve(r, cx * sx, cy * sy, qx * sx, qy * sy, x * sx, y * sy, x * sx, y * sy, 0);
+      control_x = qx;
+      control_y = qy;
+    }
+    else if (upper == 'C' || upper == 'S')
+    {
+      double c1x = (upper == 'C') ? ox + v[0] : (previous == 'C' || previous == 'S') ? 2.0 * cx - control_x : cx;
+      double c1y = (upper == 'C') ? oy + v[1] : (previous == 'C' || previous == 'S') ? 2.0 * cy - control_y : cy;
+      double c2x = ox + v[count - 4], c2y = oy + v[count - 3];
+      vgg_raster_curve(r, cx * sx, cy * sy, c1x * sx, c1y * sy, c2x * sx, c2y * sy, x * sx, y * sy, 1);
+      control_x = c2x;
+      control_y = c2y;
+    }
+    else
+    {
+      vgg_raster_edge(r, cx * sx, cy * sy, x * sx, y * sy);
+    }
+
+    cx = x;
+    cy = y;
+    previous = upper;
+  }
+
+  vgg_raster_edge(r, cx * sx, cy * sy, start_x * sx, start_y * sy);
+  vgg_raster_fill(r, fill);
+  return parsed;
+}
+
+/* Renders one element like vgg_svg_element_add would have it drawn */
+VGG_API VGG_INLINE void vgg_raster_element(vgg_raster *r, vgg_header *header)
+{
+  if (header->type == VGG_TYPE_RECT)
+  {
+    vgg_rect *rect = (vgg_rect *)header;
+    vgg_raster_rect(r, rect->x, rect->y, rect->width, rect->height, header->color_fill);
+  }
+  else if (header->type == VGG_TYPE_CIRCLE)
+  {
+    vgg_circle *circle = (vgg_circle *)header;
+    vgg_raster_ellipse(r, circle->cx, circle->cy, circle->r, circle->r, header->color_fill);
+  }
+  else if (header->type == VGG_TYPE_ELLIPSE)
+  {
+    vgg_ellipse *ellipse = (vgg_ellipse *)header;
+    vgg_raster_ellipse(r, ellipse->cx, ellipse->cy, ellipse->rx, ellipse->ry, header->color_fill);
+  }
+  else if (header->type == VGG_TYPE_LINE)
+  {
+    vgg_line *line = (vgg_line *)header;
+    vgg_raster_line(r, line->x1, line->y1, line->x2, line->y2, header->color_fill);
+  }
+  else if (header->type == VGG_TYPE_PATH)
+  {
+    r->skipped += !vgg_raster_path(r, ((vgg_path *)header)->d, header->color_fill);
+  }
+  else
+  {
+    r->skipped++;
+  }
+}
+
+/* Renders all elements of a document in paint order */
+VGG_API VGG_INLINE void vgg_raster_document(vgg_raster *r, vgg_document *doc)
+{
+  vgg_element element;
+  unsigned int i;
+
+  for (i = 0; i < doc->count; ++i)
+  {
+    vgg_document_element(doc, i, &element);
+    vgg_raster_element(r, &element.header);
+  }
+}
+
+/* Writes the framebuffer as binary PPM (P6, alpha is dropped) */
+VGG_API VGG_INLINE void vgg_raster_write_ppm(vgg_raster *r, vgg_svg_writer *w)
+{
+  char rgb[3 * 256];
+  unsigned long i, count = (unsigned long)r->width * (unsigned long)r->height;
+  unsigned char *p = r->pixels;
+
+  vgg_svg_puts(w, "P6\n");
+  vgg_svg_put_uint(w, (unsigned int)r->width);
+  vgg_svg_putc(w, ' ');
+  vgg_svg_put_uint(w, (unsigned int)r->height);
+  vgg_svg_puts(w, "\n255\n");
+
+  for (i = 0; i < count;)
+  {
+    int n = 0;
+    for (; n < 3 * 256 && i < count; n += 3, ++i, p += 4)
+    {
+      rgb[n] = (char)p[0];
+      rgb[n + 1] = (char)p[1];
+      rgb[n + 2] = (char)p[2];
+    }
+    vgg_svg_putn(w, rgb, n);
+  }
+}
+
+/* Writes the raw RGBA rows */
+VGG_API VGG_INLINE void vgg_raster_write_raw(vgg_raster *r, vgg_svg_writer *w)
+{
+  int y;
+
+  for (y = 0; y < r->height; ++y)
+  {
+    vgg_svg_putn(w, (char *)r->pixels + (unsigned long)y * (unsigned long)r->width * 4UL, 4 * r->width);
+  }
+}
+
+#endif /* VGG_RASTER_H */
+
+/*
+   ------------------------------------------------------------------------------
+   This software is available under 2 licenses -- choose whichever you prefer.
+   ------------------------------------------------------------------------------
+   ALTERNATIVE A - MIT License
+   Copyright (c) 2025 nickscha
+   Permission is hereby granted, free of charge, to any person obtaining a copy of
+   this software and associated documentation files (the "Software"), to deal in
+   the Software without restriction, including without limitation the rights to
+   use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies
+   of the Software, and to permit persons to whom the Software is furnished to do
+   so, subject to the following conditions:
+   The above copyright notice and this permission notice shall be included in all
+   copies or substantial portions of the Software.
+   THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+   IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+   FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+   AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+   LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+   OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+   SOFTWARE.
+   ------------------------------------------------------------------------------
+   ALTERNATIVE B - Public Domain (www.unlicense.org)
+   This is free and unencumbered software released into the public domain.
+   Anyone is free to copy, modify, publish, use, compile, sell, or distribute this
+   software, either in source code form or as a compiled binary, for any purpose,
+   commercial or non-commercial, and by any means.
+   In jurisdictions that recognize copyright laws, the author or authors of this
+   software dedicate any and all copyright interest in the software to the public
+   domain. We make this dedication for the benefit of the public at large and to
+   the detriment of our heirs and successors. We intend this dedication to be an
+   overt act of relinquishment in perpetuity of all present and future rights to
+   this software under copyright law.
+   THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+   IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+   FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+   AUTHORS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN
+   ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+   WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+   ------------------------------------------------------------------------------
+*/
@@ -0,0 +1,462 @@
+/* vgg_scene.h - v0.1 - public domain data structures - nickscha 2025
+
+A C89 standard compliant, single header, nostdlib (no C Standard Library) binary scene format for vgg.h.
+Capturing an element costs a handful of stores into a vgg_svg_writer (fixed buffer or any sink), the
+SVG text is produced later by vgg_scene_convert, e.g. on another machine from a memory mapped file.
+
+Layout (native byte order, every field and record 4 byte aligned):
+
+  header   "VGGS", u32 version, u32 byte order mark 0x01020304, u32 header size,
+           f32 width, f32 height, svg id (zero terminated, padded to 4 bytes)
+  record   u32 type | data fields count << 8, u32 record size, u32 id, u32 fill 0xRRGGBB,
+           f32 geometry in the field order of the element struct (rect 4, circle 3, line 4,
+           ellipse 4, text 2, path 0), text or path d string, data field key/value strings
+           (all strings zero terminated, the record padded to 4 bytes with zeros)
+
+Records are walked by their size without looking at the content. Coordinates are stored as float,
+the written SVG matches vgg_svg_element_add as long as the values are exact in single precision.
+
+LICENSE
+
+  Placed in the public domain and also MIT licensed.
+  See end of file for detailed license information.
+
+*/
+#ifndef VGG_SCENE_H
+#define VGG_SCENE_H
+
+#ifndef VGG_H
+#error "vgg_scene: include vgg.h first"
+#endif
+
+#define VGG_SCENE_VERSION 1
+#define VGG_SCENE_BYTE_ORDER 0x01020304U
+#define VGG_SCENE_RECORD_SIZE 16     /* Fixed part of a record before the geometry */
+#define VGG_SCENE_FIELDS_MAX 64      /* Data fields per element decoded by vgg_scene_convert */
+
+/* Native byte order stores without alignment requirements, compilers turn them into single moves */
+typedef union vgg_scene_word
+{
+  unsigned int u;
+  float f;
+  unsigned char bytes[4];
+
+} vgg_scene_word;
+
+VGG_API VGG_INLINE char *vgg_scene_put_u32(char *p, unsigned int value)
+{
+  vgg_scene_word word;
+  word.u = value;
+  p[0] = (char)word.bytes[0];
+  p[1] = (char)word.bytes[1];
+  p[2] = (char)word.bytes[2];
+  p[3] = (char)word.bytes[3];
+  return p + 4;
+}
+
+VGG_API VGG_INLINE char *vgg_scene_put_f32(char *p, double value)
+{
+  vgg_scene_word word;
+  word.f = (float)value;
+  return vgg_scene_put_u32(p, word.u);
+}
+
+VGG_API VGG_INLINE unsigned int vgg_scene_get_u32(unsigned char *p)
+{
+  vgg_scene_word word;
+  word.bytes[0] = p[0];
+  word.bytes[1] = p[1];
+  word.bytes[2] = p[2];
+  word.bytes[3] = p[3];
+  return word.u;
+}
+
+VGG_API VGG_INLINE double vgg_scene_get_f32(unsigned char *p)
+{
+  vgg_scene_word word;
+  word.u = vgg_scene_get_u32(p);
+  return (double)word.f;
+}
+
+VGG_API VGG_INLINE unsigned int vgg_scene_pack_color(vgg_color color)
+{
+  return ((unsigned int)color.r & 0xFFU) << 16 | ((unsigned int)color.g & 0xFFU) << 8 | ((unsigned int)color.b & 0xFFU);
+}
+
+/* Bytes of a zero terminated string padded to 4 */
+VGG_API VGG_INLINE int vgg_scene_string_size(char *s)
+{
+  return (vgg_svg_strlen(s) + 4) & ~3;
+}
+
+/* Writes s with its terminator and the zero padding */
+VGG_API VGG_INLINE void vgg_scene_put_string(vgg_svg_writer *w, char *s)
+{
+  static char zeros[4] = {0, 0, 0, 0};
+  int length = vgg_svg_strlen(s);
+
+  vgg_svg_putn(w, s, length);
+  vgg_svg_putn(w, zeros, 4 - (length & 3));
+}
+
+/* Writes the scene header, the counterpart of vgg_svg_start */
+VGG_API VGG_INLINE void vgg_scene_start(vgg_svg_writer *w, char *id, double width, double height)
+{
+  char buf[24];
+  char *p = buf;
+
+  p[0] = 'V';
+  p[1] = 'G';
+  p[2] = 'G';
+  p[3] = 'S';
+  p = vgg_scene_put_u32(p + 4, VGG_SCENE_VERSION);
+  p = vgg_scene_put_u32(p, VGG_SCENE_BYTE_ORDER);
+  p = vgg_scene_put_u32(p, (unsigned int)(24 + vgg_scene_string_size(id)));
+  p = vgg_scene_put_f32(p, width);
+  p = vgg_scene_put_f32(p, height);
+
+  vgg_svg_putn(w, buf, 24);
+  vgg_scene_put_string(w, id);
+}
+
+/* Appends one element. Shapes without strings are stored with unchecked writes into the writer buffer. */
+VGG_API VGG_INLINE void vgg_scene_add(vgg_svg_writer *w, vgg_header *header)
+{
+  char fixed[VGG_SCENE_RECORD_SIZE + 16];
+  unsigned int i, size = VGG_SCENE_RECORD_SIZE + 4 * vgg_document_columns(header->type);
+  char *p, *start;
+
+  if (header->type == VGG_TYPE_TEXT)
+  {
+    size += (unsigned int)vgg_scene_string_size(((vgg_text *)header)->text);
+  }
+  else if (header->type == VGG_TYPE_PATH)
+  {
+    size += (unsigned int)vgg_scene_string_size(((vgg_path *)header)->d);
+  }
+
+  if (header->data_fields_count)
+  {
+    unsigned int length = 0;
+    for (i = 0; i < header->data_fields_count; ++i)
+    {
+      length += (unsigned int)(vgg_svg_strlen(header->data_fields[i].key) + vgg_svg_strlen(header->data_fields[i].value) + 2);
+    }
+    size += (length + 3) & ~3U;
+  }
+
+  /* Straight into the writer buffer if the whole fixed part fits */
+  start = vgg_svg_reserve(w, VGG_SCENE_RECORD_SIZE + 16);
+  p = start ? start : fixed;
+
+  p = vgg_scene_put_u32(p, (unsigned int)header->type | header->data_fields_count << 8);
+  p = vgg_scene_put_u32(p, size);
+  p = vgg_scene_put_u32(p, header->id);
+  p = vgg_scene_put_u32(p, vgg_scene_pack_color(header->color_fill));
+
+  if (header->type == VGG_TYPE_RECT)
+  {
+    vgg_rect *rect = (vgg_rect *)header;
+    p = vgg_scene_put_f32(p, rect->x);
+    p = vgg_scene_put_f32(p, rect->y);
+    p = vgg_scene_put_f32(p, rect->width);
+    p = vgg_scene_put_f32(p, rect->height);
+  }
+  else if (header->type == VGG_TYPE_CIRCLE)
+  {
+    vgg_circle *circle = (vgg_circle *)header;
+    p = vgg_scene_put_f32(p, circle->cx);
+    p = vgg_scene_put_f32(p, circle->cy);
+    p = vgg_scene_put_f32(p, circle->r);
+  }
+  else if (header->type == VGG_TYPE_LINE)
+  {
+    vgg_line *line = (vgg_line *)header;
+    p = vgg_scene_put_f32(p, line->x1);
+    p = vgg_scene_put_f32(p, line->y1);
+    p = vgg_scene_put_f32(p, line->x2);
+    p = vgg_scene_put_f32(p, line->y2);
+  }
+  else if (header->type == VGG_TYPE_ELLIPSE)
+  {
+    vgg_ellipse *ellipse = (vgg_ellipse *)header;
+    p = vgg_scene_put_f32(p, ellipse->cx);
+    p = vgg_scene_put_f32(p, ellipse->cy);
+    p = vgg_scene_put_f32(p, ellipse->rx);
+    p = vgg_scene_put_f32(p, ellipse->ry);
+  }
+  else if (header->type == VGG_TYPE_TEXT)
+  {
+    vgg_text *text = (vgg_text *)header;
+    p = vgg_scene_put_f32(p, text->x);
+    p = vgg_scene_put_f32(p, text->y);
+  }
+
+  if (start)
+  {
+    vgg_svg_commit(w, p);
+  }
+  else
+  {
+    vgg_svg_putn(w, fixed, (int)(p - fixed));
+  }
+
+  if (header->type == VGG_TYPE_TEXT)
+  {
+    vgg_scene_put_string(w, ((vgg_text *)header)->text);
+  }
+  else if (header->type == VGG_TYPE_PATH)
+  {
+    vgg_scene_put_string(w, ((vgg_path *)header)->d);
+  }
+
+  if (header->data_fields_count)
+  {
+    static char zeros[4] = {0, 0, 0, 0};
+    unsigned int length = 0;
+
+    for (i = 0; i < header->data_fields_count; ++i)
+    {
+      int key = vgg_svg_strlen(header->data_fields[i].key) + 1;
+      int value = vgg_svg_strlen(header->data_fields[i].value) + 1;
+      vgg_svg_putn(w, header->data_fields[i].key, key);
+      vgg_svg_putn(w, header->data_fields[i].value, value);
+      length += (unsigned int)(key + value);
+    }
+    vgg_svg_putn(w, zeros, (int)((4 - (length & 3)) & 3));
+  }
+}
+
+/* Hands the remaining bytes of a streaming writer to its sink. Returns 0 if bytes were dropped. */
+VGG_API VGG_INLINE int vgg_scene_end(vgg_svg_writer *w)
+{
+  return vgg_svg_writer_flush(w);
+}
+
+/* Walks the records of a scene in place, strings point into data */
+typedef struct vgg_scene_reader
+{
+  unsigned char *data;
+  unsigned long size;
+  unsigned long offset; /* Next record */
+
+  char *id;
+  double width;
+  double height;
+
+  unsigned int fields_dropped; /* Data fields that did not fit the array passed to vgg_scene_next */
+
+} vgg_scene_reader;
+
+/* Returns 0 if data does not start with a scene header of this version and byte order */
+VGG_API VGG_INLINE int vgg_scene_open(vgg_scene_reader *reader, unsigned char *data, unsigned long size)
+{
+  unsigned long header_size;
+
+  reader->data = data;
+  reader->size = size;
+  reader->offset = size;
+  reader->fields_dropped = 0;
+
+  if (size < 28 || data[0] != 'V' || data[1] != 'G' || data[2] != 'G' || data[3] != 'S' ||
+      vgg_scene_get_u32(data + 4) != VGG_SCENE_VERSION || vgg_scene_get_u32(data + 8) != VGG_SCENE_BYTE_ORDER)
+  {
+    return 0;
+  }
+
+  header_size = vgg_scene_get_u32(data + 12);
+  if (header_size < 28 || header_size > size || (header_size & 3) || data[header_size - 1] != 0)
+  {
+    return 0;
+  }
+
+  reader->id = (char *)data + 24;
+  reader->width = vgg_scene_get_f32(data + 16);
+  reader->height = vgg_scene_get_f32(data + 20);
+  reader->offset = header_size;
+  return 1;
+}
+
+/* Decodes the next record into element, data fields into fields[0..fields_capacity).
+   Returns 0 at the end of the scene or at a damaged (e.g. cut off) record.
+*/
+VGG_API VGG_INLINE int vgg_scene_next(vgg_scene_reader *reader, vgg_element *element, vgg_data_field *fields, unsigned int fields_capacity)
+{
+  unsigned char *p = reader->data + reader->offset;
+  unsigned long available = reader->size - reader->offset;
+  unsigned int tag, size, type, columns, count, rgb, i;
+  char *s, *end;
+
+  if (available < VGG_SCENE_RECORD_SIZE)
+  {
+    return 0;
+  }
+
+  tag = vgg_scene_get_u32(p);
+  size = vgg_scene_get_u32(p + 4);
+  type = tag & 0xFFU;
+  if (type > VGG_TYPE_PATH)
+  {
+    return 0;
+  }
+
+  /* Strings end within the record, its last byte is a terminator or padding */
+  columns = vgg_document_columns((vgg_header_type)type);
+  if (size < VGG_SCENE_RECORD_SIZE + 4 * columns || size > available || (size & 3) ||
+      ((type >= VGG_TYPE_TEXT || tag >> 8) && (size == VGG_SCENE_RECORD_SIZE + 4 * columns || p[size - 1] != 0)))
+  {
+    return 0;
+  }
+
+  end = (char *)p + size;
+  rgb = vgg_scene_get_u32(p + 12);
+
+  element->header.type = (vgg_header_type)type;
+  element->header.id = vgg_scene_get_u32(p + 8);
+  element->header.color_fill.r = (int)((rgb >> 16) & 0xFFU);
+  element->header.color_fill.g = (int)((rgb >> 8) & 0xFFU);
+  element->header.color_fill.b = (int)(rgb & 0xFFU);
+
+  p += VGG_SCENE_RECORD_SIZE;
+  if (type == VGG_TYPE_RECT)
+  {
+    element->rect.x = vgg_scene_get_f32(p);
+    element->rect.y = vgg_scene_get_f32(p + 4);
+    element->rect.width = vgg_scene_get_f32(p + 8);
+    element->rect.height = vgg_scene_get_f32(p + 12);
+  }
+  else if (type == VGG_TYPE_CIRCLE)
+  {
+    element->circle.cx = vgg_scene_get_f32(p);
+    element->circle.cy = vgg_scene_get_f32(p + 4);
+    element->circle.r = vgg_scene_get_f32(p + 8);
+  }
+  else if (type == VGG_TYPE_LINE)
+  {
+    element->line.x1 = vgg_scene_get_f32(p);
+    element->line.y1 = vgg_scene_get_f32(p + 4);
+    element->line.x2 = vgg_scene_get_f32(p + 8);
+    element->line.y2 = vgg_scene_get_f32(p + 12);
+  }
+  else if (type == VGG_TYPE_ELLIPSE)
+  {
+    element->ellipse.cx = vgg_scene_get_f32(p);
+    element->ellipse.cy = vgg_scene_get_f32(p + 4);
+    element->ellipse.rx = vgg_scene_get_f32(p + 8);
+    element->ellipse.ry = vgg_scene_get_f32(p + 12);
+  }
+  else if (type == VGG_TYPE_TEXT)
+  {
+    element->text.x = vgg_scene_get_f32(p);
+    element->text.y = vgg_scene_get_f32(p + 4);
+  }
+  p += 4 * columns;
+
+  s = (char *)p;
+  if (type == VGG_TYPE_TEXT)
+  {
+    element->text.text = s;
+    s += vgg_scene_string_size(s);
+  }
+  else if (type == VGG_TYPE_PATH)
+  {
+    element->path.d = s;
+    s += vgg_scene_string_size(s);
+  }
+  if (s > end)
+  {
+    return 0;
+  }
+
+  count = tag >> 8;
+  element->header.data_fields = fields;
+  element->header.data_fields_count = (count < fields_capacity) ? count : fields_capacity;
+  reader->fields_dropped += count - element->header.data_fields_count;
+
+  for (i = 0; i < element->header.data_fields_count; ++i)
+  {
+    if (s >= end)
+    {
+      return 0;
+    }
+    fields[i].key = s;
+    s += vgg_svg_strlen(s) + 1;
+    if (s >= end)
+    {
+      return 0;
+    }
+    fields[i].value = s;
+    s += vgg_svg_strlen(s) + 1;
+  }
+
+  reader->offset += size;
+  return 1;
+}
+
+/* Writes the SVG of a scene through w, same as vgg_svg_start, vgg_svg_element_add per record and vgg_svg_end.
+   Returns 0 if data is not a scene, a record is damaged or w dropped bytes.
+*/
+VGG_API VGG_INLINE int vgg_scene_convert(vgg_svg_writer *w, unsigned char *data, unsigned long size)
+{
+  vgg_data_field fields[VGG_SCENE_FIELDS_MAX];
+  vgg_scene_reader reader;
+  vgg_element element;
+
+  if (!vgg_scene_open(&reader, data, size))
+  {
+    return 0;
+  }
+
+  vgg_svg_start(w, reader.id, reader.width, reader.height);
+  while (vgg_scene_next(&reader, &element, fields, VGG_SCENE_FIELDS_MAX))
+  {
+    vgg_svg_element_add(w, &element.header);
+  }
+  vgg_svg_end(w);
+
+  return reader.offset == reader.size && !reader.fields_dropped && !w->truncated;
+}
+
+#endif /* VGG_SCENE_H */
+
+/*
+   ------------------------------------------------------------------------------
+   This software is available under 2 licenses -- choose whichever you prefer.
+   ------------------------------------------------------------------------------
+   ALTERNATIVE A - MIT License
+   Copyright (c) 2025 nickscha
+   Permission is hereby granted, free of charge, to any person obtaining a copy of
+   this software and associated documentation files (the "Software"), to deal in
+   the Software without restriction, including without limitation the rights to
+   use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies
+   of the Software, and to permit persons to whom the Software is furnished to do
+   so, subject to the following conditions:
+   The above copyright notice and this permission notice shall be included in all
+   copies or substantial portions of the Software.
+   THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+   IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+   FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+   AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+   LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+   OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+   SOFTWARE.
+   ------------------------------------------------------------------------------
+   ALTERNATIVE B - Public Domain (www.unlicense.org)
+   This is free and unencumbered software released into the public domain.
+   Anyone is free to copy, modify, publish, use, compile, sell, or distribute this
+   software, either in source code form or as a compiled binary, for any purpose,
+   commercial or non-commercial, and by any means.
+   In jurisdictions that recognize copyright laws, the author or authors of this
+   software dedicate any and all copyright interest in the software to the public
+   domain. We make this dedication for the benefit of the public at large and to
+   the detriment of our heirs and successors. We intend this dedication to be an
+   overt act of relinquishment in perpetuity of all present and future rights to
+   this software under copyright law.
+   THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+   IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+   FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+   AUTHORS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN
+   ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+   WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+   ------------------------------------------------------------------------------
+*/